@@ -8,15 +8,12 @@ namespace
 {
     constexpr auto STARTUP_REGISTRY_KEY = L"SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Run";
     constexpr auto PROGRAM_NAME = L"ThreeFingerDrag";
-    constexpr auto TOUCH_ACTIVITY_PERIOD_MS = std::chrono::milliseconds(1);
+    constexpr auto WM_GESTURE_COMMAND = WM_APP + 1;
+    constexpr auto WM_CONFIG_RELOADED = WM_APP + 2;
     constexpr auto MAX_LOAD_STRING_LENGTH = 100;
 
     constexpr auto SETTINGS_WINDOW_WIDTH = 456;
     constexpr auto SETTINGS_WINDOW_HEIGHT = 170;
-    constexpr auto MIN_CANCELLATION_DELAY_MS = 100;
-    constexpr auto MAX_CANCELLATION_DELAY_MS = 2000;
-    constexpr auto MIN_GESTURE_SPEED = 1;
-    constexpr auto MAX_GESTURE_SPEED = 100;
     constexpr auto ID_SETTINGS_MENUITEM = 10000;
     constexpr auto ID_QUIT_MENUITEM = 10001;
     constexpr auto ID_RUN_ON_STARTUP_CHECKBOX = 10002;
@@ -24,6 +21,7 @@ namespace
     constexpr auto ID_TEXT_BOX = 10004;
     constexpr auto ID_CANCELLATION_DELAY_SPINNER = 10005;
     constexpr auto ID_OPEN_CONFIG_FOLDER = 10005;
+    constexpr auto ID_SAVE_DIAGNOSTICS = 10006;
 }
 
 // Global Variables
@@ -32,6 +30,7 @@ HINSTANCE current_instance;
 HWND tray_icon_hwnd;
 HWND settings_hwnd;
 HWND settings_trackbar_hwnd;
+HWND settings_spinner_hwnd;
 HWND settings_checkbox_hwnd;
 WCHAR title_bar_text[MAX_LOAD_STRING_LENGTH];
 WCHAR settings_title_text[MAX_LOAD_STRING_LENGTH];
@@ -39,8 +38,11 @@ WCHAR main_window_class_name[MAX_LOAD_STRING_LENGTH];
 WCHAR settings_window_class_name[MAX_LOAD_STRING_LENGTH];
 NOTIFYICONDATA tray_icon_data;
 TouchProcessor touch_processor;
-std::thread touch_activity_thread;
-BOOL application_running = TRUE;
+CaptureWriter capture_writer;
+TraceWriter trace_writer;
+FlightRecorder flight_recorder;
+ConfigWatcher config_watcher;
+ConfigPersister config_persister;
 BOOL gui_initialized = FALSE;
 HBRUSH white_brush = CreateSolidBrush(RGB(255, 255, 255));
 HFONT normal_font = CreateFont(17, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, ANSI_CHARSET, OUT_TT_PRECIS,
@@ -60,6 +62,11 @@ void AddStartupTask();
 void RemoveStartupTask();
 void RemoveStartupRegistryKey();
 void StartPeriodicUpdateThreads();
+void StartReportCapture();
+void StartFrameTrace();
+void HandleConfigurationChange();
+void ApplyReloadedConfiguration();
+void HandleGestureTimeout(TimeoutKind kind, std::chrono::steady_clock::time_point now);
 void HandleUncaughtExceptions();
 void PerformAdditionalSteps();
 void PromptUserForStartupPreference();
@@ -70,6 +77,9 @@ bool RegisterRawInputDevices();
 bool CheckSingleInstance();
 bool InitializeGUI();
 
+// Runs the gesture timeouts armed by the touch processor
+TimeoutScheduler timeout_scheduler(HandleGestureTimeout);
+
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                       _In_opt_ HINSTANCE hPrevInstance,
                       _In_ LPWSTR lpCmdLine,
@@ -110,9 +120,19 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     Shell_NotifyIcon(NIM_DELETE, &tray_icon_data);
 
     // Join threads
-    application_running = false;
-    if (touch_activity_thread.joinable())
-        touch_activity_thread.join();
+    config_watcher.Stop();
+    config_persister.Stop();
+
+    touch_processor.SetTimeoutScheduler(nullptr);
+    timeout_scheduler.Stop();
+
+    touch_processor.SetCaptureWriter(nullptr);
+    capture_writer.Close();
+
+    touch_processor.SetTraceWriter(nullptr);
+    trace_writer.Close();
+
+    INFO("Touch pipeline latency:\n" + touch_processor.Latency().Summary());
     return static_cast<int>(msg.wParam);
 }
 
@@ -145,6 +165,18 @@ BOOL InitInstance()
     if (log)
         DEBUG("Registered raw input device.");
 
+    // Always keep the last touch events in memory, so that they can be saved after a crash or an anomaly
+    flight_recorder.SetDumpFolder(Application::GetConfigurationFolderPath());
+    touch_processor.SetFlightRecorder(&flight_recorder);
+
+    // Optionally, record every touchpad report so that problems can be replayed
+    if (config->CaptureReports())
+        StartReportCapture();
+
+    // Optionally, trace the details of every frame and gesture step for the offline trace decoder
+    if (config->TraceFrames())
+        StartFrameTrace();
+
     // Show the settings icon
     Shell_NotifyIcon(NIM_ADD, &tray_icon_data);
 
@@ -167,6 +199,22 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         touch_processor.ProcessRawInput((HRAWINPUT)lParam);
         break;
 
+    // Commands queued by the touch activity thread
+    case WM_GESTURE_COMMAND:
+        touch_processor.ProcessCommands();
+        break;
+
+    // Settings reloaded by the configuration watcher thread
+    case WM_CONFIG_RELOADED:
+        ApplyReloadedConfiguration();
+        break;
+
+    // Touch device added or removed
+    case WM_INPUT_DEVICE_CHANGE:
+        if (wParam == GIDC_REMOVAL)
+            touch_processor.RemoveDevice(reinterpret_cast<DeviceHandle>(lParam));
+        break;
+
     // Notify Icon
     case WM_APP:
         switch (lParam)
@@ -193,6 +241,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             case ID_OPEN_CONFIG_FOLDER:
                 ShellExecuteA(NULL, "open", Application::config_folder_path.c_str(), NULL, NULL, SW_SHOWNORMAL);
                 break;
+            case ID_SAVE_DIAGNOSTICS:
+                {
+                    const std::string& path = flight_recorder.DumpPath(FlightDumpReason::Requested);
+                    if (flight_recorder.Dump(FlightDumpReason::Requested))
+                        INFO("Saved the recent touch events to '" + path + "'.");
+                    else
+                        ERROR("Could not save the recent touch events.");
+                    break;
+                }
             default:
                 return DefWindowProc(hWnd, message, wParam, lParam);
             }
@@ -239,7 +296,7 @@ LRESULT CALLBACK SettingsWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPar
                 wchar_t buffer[64];
                 GetWindowText((HWND)lParam, buffer, 64); // get textbox text
                 config->SetCancellationDelayMs(_wtoi(buffer)); // convert to integer (only numerical values are entered)
-                Application::WriteConfiguration();
+                config_persister.RequestSave();
                 break;
             }
         }
@@ -263,7 +320,7 @@ LRESULT CALLBACK SettingsWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPar
             {
                 // Trackbar value changed
                 config->SetGestureSpeed(SendMessage((HWND)lParam, TBM_GETPOS, 0, 0));
-                Application::WriteConfiguration();
+                config_persister.RequestSave();
             }
         }
         break;
@@ -368,7 +425,7 @@ bool InitializeGUI()
     SendMessage(hwndTextBox, WM_SETFONT, reinterpret_cast<WPARAM>(normal_font), TRUE);
 
     // Spinner for numeric textbox
-    HWND settings_spinner_hwnd = CreateWindowW(L"msctls_updown32", NULL,
+    settings_spinner_hwnd = CreateWindowW(L"msctls_updown32", NULL,
                                                WS_CHILD | WS_VISIBLE | UDS_ALIGNRIGHT | UDS_ARROWKEYS | UDS_SETBUDDYINT
                                                | UDS_NOTHOUSANDS,
                                                pos_x, pos_y, 0, label_height,
@@ -443,6 +500,7 @@ void CreateTrayMenu(const HWND hWnd)
     // Add the menu items
     AppendMenu(hMenu, MF_STRING, ID_SETTINGS_MENUITEM, TEXT("Settings"));
     AppendMenu(hMenu, MF_STRING, ID_OPEN_CONFIG_FOLDER, TEXT("Open Config"));
+    AppendMenu(hMenu, MF_STRING, ID_SAVE_DIAGNOSTICS, TEXT("Save Diagnostics"));
 
     // Add a separator and the "Exit" menu item.
     AppendMenu(hMenu, MF_SEPARATOR, 0, nullptr);
@@ -489,59 +547,127 @@ void ShowSettingsWindow()
  */
 void StartPeriodicUpdateThreads()
 {
-    // Check if the dragging action needs to be completed
-    touch_activity_thread = std::thread([&]
+    // Gesture timeouts are armed by the touch processor whenever the gesture state changes
+    touch_processor.SetTimeoutScheduler(&timeout_scheduler);
+    timeout_scheduler.Start();
+
+    // The injected button state is occasionally checked against the system, to catch physical clicks
+    touch_processor.SetButtonReconciler(Cursor::IsLeftMouseDown);
+
+    // Settings changed in the settings window are saved in the background
+    config_persister.Start(Application::GetConfigurationFilePath());
+
+    // Changes made to the configuration file by hand are applied without a restart
+    if (!config_watcher.Start(Application::GetConfigurationFilePath(), HandleConfigurationChange))
+        WARNING("Could not watch the configuration file for changes.");
+}
+
+/**
+ * \brief Reloads the configuration file after it changed on disk. Runs on the configuration watcher thread; the
+ * touch processor picks the new settings up with its next batch of input, and the GUI is refreshed on its own thread.
+ */
+void HandleConfigurationChange()
+{
+    // The settings in memory are newer than the file until the pending save has replaced it
+    if (config_persister.HasPendingSave())
+        return;
+
+    if (Application::ReloadConfiguration())
+        PostMessage(tray_icon_hwnd, WM_CONFIG_RELOADED, 0, 0);
+}
+
+/**
+ * \brief Brings the settings window and the optional recorders in line with reloaded settings. Runs on the GUI
+ * thread.
+ */
+void ApplyReloadedConfiguration()
+{
+    const SettingsSnapshot settings = config->Settings();
+
+    // The change events of the controls would save the file again, so they are ignored meanwhile
+    gui_initialized = FALSE;
+    SendMessage(settings_trackbar_hwnd, TBM_SETPOS, TRUE, static_cast<int>(settings.gesture_speed));
+    SendMessage(settings_spinner_hwnd, UDM_SETPOS, 0, MAKELONG(settings.cancellation_delay_ms, 0));
+    gui_initialized = TRUE;
+
+    if (settings.capture_reports && !capture_writer.IsOpen())
+        StartReportCapture();
+    else if (!settings.capture_reports && capture_writer.IsOpen())
     {
-        while (application_running)
-        {
-            std::this_thread::sleep_for(TOUCH_ACTIVITY_PERIOD_MS);
+        touch_processor.SetCaptureWriter(nullptr);
+        capture_writer.Close();
+    }
 
-            if (Cursor::IsLeftMouseDown() && config->IsGestureStarted())
-            {
-                const auto interval = EventListeners::CalculateElapsedTimeMs(
-                    config->GetLastEvent(), std::chrono::high_resolution_clock::now());
-                if (interval > config->GetCancellationDelayMs())
-                {
-                    EventListeners::CancelGesture();
-                    touch_processor.ClearContacts();
-                    if (config->LogDebug())
-                        DEBUG("Cancelled gesture (automatic timeout).");
-                }
-            }
+    if (settings.trace_frames && !trace_writer.IsOpen())
+        StartFrameTrace();
+    else if (!settings.trace_frames && trace_writer.IsOpen())
+    {
+        touch_processor.SetTraceWriter(nullptr);
+        trace_writer.Close();
+    }
+}
 
-            // Only continue if a cancellation was initiated, or if the gesture is ongoing
-            if (!config->IsCancellationStarted() && !config->IsGestureStarted())
-                continue;
-            
-            if (config->IsCancellationStarted()) // Check for cancellation timeout started by user
-            {
-                const auto now = std::chrono::high_resolution_clock::now();
-                const std::chrono::duration<float> duration = now - config->GetCancellationTime();
-                const float ms_since_cancellation = duration.count() * 1000.0f;
-                if (ms_since_cancellation < config->GetCancellationDelayMs())
-                {
-                    continue;
-                }
+/**
+ * \brief Starts capturing the raw touchpad reports to a new file in the configuration folder, named after the
+ * current time.
+ */
+void StartReportCapture()
+{
+    const std::time_t now_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm time_info;
+    if (localtime_s(&time_info, &now_time) != 0)
+        return;
 
-                EventListeners::CancelGesture();
-                touch_processor.ClearContacts();
-                if (config->LogDebug())
-                    DEBUG("Cancelled gesture (cancellation timeout).");
-            }
-            else if (Cursor::IsLeftMouseDown()) // Check for automatic gesture timeout (failsafe)
-            {
-                const auto now = std::chrono::high_resolution_clock::now();
-                const auto ms_since_last_touch_event = EventListeners::CalculateElapsedTimeMs(config->GetLastEvent(), now);
-                if (ms_since_last_touch_event > config->GetAutomaticTimeoutDelayMs())
-                {
-                    EventListeners::CancelGesture();
-                    touch_processor.ClearContacts();
-                    if (config->LogDebug())
-                        DEBUG("Cancelled gesture (automatic timeout).");
-                }
-            }
-        }
-    });
+    std::stringstream file_path;
+    file_path << Application::GetConfigurationFolderPath() << "\\capture-"
+        << std::put_time(&time_info, "%y%m%d-%H%M%S") << CAPTURE_FILE_EXTENSION;
+
+    if (!capture_writer.Open(file_path.str()))
+        return;
+
+    touch_processor.SetCaptureWriter(&capture_writer);
+    INFO("Capturing touchpad reports to '" + file_path.str() + "'.");
+}
+
+/**
+ * \brief Starts tracing the frames and gesture steps of the touch processor to the trace file in the configuration
+ * folder, replacing the previous trace.
+ */
+void StartFrameTrace()
+{
+    const std::string file_path = Application::GetConfigurationFolderPath() + "\\trace" + TRACE_FILE_EXTENSION;
+
+    if (!trace_writer.Open(file_path))
+        return;
+
+    touch_processor.SetTraceWriter(&trace_writer);
+    INFO("Tracing touchpad frames to '" + file_path + "'.");
+}
+
+/**
+ * \brief Checks whether the dragging action needs to be completed once a gesture timeout expires. The gesture state is
+ * only read here; cancellations are sent to the input thread, which owns the state.
+ * \param kind The expired timeout.
+ * \param now The time the timeout was run.
+ */
+void HandleGestureTimeout(const TimeoutKind kind, const std::chrono::steady_clock::time_point now)
+{
+    static uint64_t requested_sequence = 0;
+
+    // The state may have changed after the deadline was armed, so check it again
+    GestureCommand command;
+    if (!touch_processor.CheckTimeout(kind, now, command))
+        return;
+
+    // A cancellation for this state is already waiting on the input thread
+    if (command.sequence == requested_sequence)
+        return;
+
+    if (touch_processor.PostCommand(command))
+    {
+        requested_sequence = command.sequence;
+        PostMessage(tray_icon_hwnd, WM_GESTURE_COMMAND, 0, 0);
+    }
 }
 
 /**
@@ -556,7 +682,8 @@ bool RegisterRawInputDevices()
 
     rid.usUsagePage = HID_USAGE_PAGE_DIGITIZER;
     rid.usUsage = HID_USAGE_DIGITIZER_TOUCH_PAD;
-    rid.dwFlags = RIDEV_INPUTSINK; // Receive input even when the application is in the background
+    rid.dwFlags = RIDEV_INPUTSINK // Receive input even when the application is in the background
+        | RIDEV_DEVNOTIFY; // Receive device arrival and removal notifications
     rid.hwndTarget = tray_icon_hwnd; // Handle to the application window
 
     return RegisterRawInputDevices(&rid, 1, sizeof(RAWINPUTDEVICE));
@@ -753,5 +880,12 @@ void HandleUncaughtExceptions()
         ss << "Unhandled exception: Unknown exception type\n";
     }
     ERROR(ss.str());
+
+    // Save the touch events leading up to the crash. The dump paths were built at startup.
+    if (flight_recorder.Dump(FlightDumpReason::Crash))
+        ERROR("Saved the recent touch events to '" + flight_recorder.DumpPath(FlightDumpReason::Crash) + "'.");
+
+    // Logging is asynchronous, so make sure the error reaches the file before the process ends
+    Logger::GetInstance().Flush();
     std::terminate();
 }
@@ -3,11 +3,15 @@
 #include <thread>
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <Windows.h>
 #include "resource.h"
 #include "logging/logger.h"
 #include "task/task_scheduler.h"
 #include "application.h"
+#include "config/config_persister.h"
+#include "config/config_watcher.h"
+#include "mouse/cursor.h"
 #include "notification/wintoastlib.h"
 #include "notification/popups.h"
 #include <CommCtrl.h>
@@ -7,6 +7,7 @@
 #include "gesture/touch_processor.h"
 #include "data/ini.h"
 #include "config/globalconfig.h"
+#include "config/config_file.h"
 
 namespace Application
 {
@@ -70,6 +71,14 @@ namespace Application
         return directory_path;
     }
 
+    /**
+     * @brief Returns the path to the configuration file, which may not exist yet.
+     */
+    inline std::string GetConfigurationFilePath()
+    {
+        return GetConfigurationFolderPath() + "\\config.ini";
+    }
+
     /**
      * @brief Checks if a version.txt file exists in application data and updates it.
      * @return True if no version file was found
@@ -96,35 +105,20 @@ namespace Application
         return true;
     }
 
+    /**
+     * @brief Writes the current settings to the configuration file right away. Changes made while the application
+     * runs are saved by a ConfigPersister instead, away from the GUI thread.
+     */
     inline void WriteConfiguration()
     {
-        std::stringstream ss;
-        std::string file_path = GetConfigurationFolderPath();
-        
-        file_path += "\\";
-        file_path += "\\config.ini";
-
-        mINI::INIFile file(file_path);
-        mINI::INIStructure ini;
-
-        ss << std::fixed << std::setprecision(2) << config->GetGestureSpeed();
-
-        ini["Configuration"]["gesture_speed"] = ss.str();
-        ini["Configuration"]["cancellation_delay_ms"] = std::to_string(config->GetCancellationDelayMs());
-        ini["Configuration"]["automatic_timeout_delay_ms"] = std::to_string(config->GetAutomaticTimeoutDelayMs());
-        ini["Configuration"]["one_finger_transition_delay_ms"] = std::to_string(config->GetOneFingerTransitionDelayMs());
-        ini["Configuration"]["debug"] = config->LogDebug() ? "true" : "false";
-
-        if (!file.generate(ini))
-            ERROR("Error writing to config file.");
+        std::string error;
+        if (!ConfigFile::Save(GetConfigurationFilePath(), config->Settings(), error))
+            ERROR(error);
     }
 
     inline void ReadConfiguration()
     {
-        std::string file_path = GetConfigurationFolderPath();
-        
-        file_path += "\\";
-        file_path += "\\config.ini";
+        const std::string file_path = GetConfigurationFilePath();
 
         if (!std::filesystem::exists(file_path))
         {
@@ -132,34 +126,44 @@ namespace Application
             return;
         }
 
-
-        mINI::INIFile file(file_path);
-        mINI::INIStructure ini;
-
-        if (!file.read(ini))
+        ConfigFile file;
+        std::string error;
+        if (!ConfigFile::Load(file_path, file, error))
         {
-            std::stringstream ss;
-            ss << "Couldn't read '" << file_path << "'";
-            ERROR(ss.str());
+            ERROR(error);
             return;
         }
 
-        const auto config_section = ini["Configuration"];
+        // Every setting of the file is published as one snapshot
+        config->Update([&file](SettingsSnapshot& settings) { file.ApplyTo(settings); });
+    }
 
-        if (config_section.has("gesture_speed"))
-            config->SetGestureSpeed(std::stof(config_section.get("gesture_speed")));
+    /**
+     * @brief Reads the configuration file again after it was changed on disk. Safe to call from any thread. A file
+     * that is unreadable or has any invalid setting is rejected as a whole, and the current settings are kept.
+     * @return True if any setting changed
+     */
+    inline bool ReloadConfiguration()
+    {
+        ConfigFile file;
+        std::string error;
+        if (!ConfigFile::Load(GetConfigurationFilePath(), file, error))
+        {
+            WARNING(error + " Keeping the current settings.");
+            return false;
+        }
 
-        if (config_section.has("cancellation_delay_ms"))
-            config->SetCancellationDelayMs(std::stof(config_section.get("cancellation_delay_ms")));
+        // The file is also rewritten by the settings window, which changes nothing here
+        bool changed = false;
+        config->Update([&file, &changed](SettingsSnapshot& settings)
+        {
+            changed = file.Changes(settings);
+            file.ApplyTo(settings);
+        });
 
-        if (config_section.has("automatic_timeout_delay_ms"))
-            config->SetAutomaticTimeoutDelayMs(std::stof(config_section.get("automatic_timeout_delay_ms")));
-        
-        if (config_section.has("one_finger_transition_delay_ms"))
-            config->SetOneFingerTransitionDelayMs(std::stof(config_section.get("one_finger_transition_delay_ms")));
-        
-        if (config_section.has("debug"))
-            config->SetLogDebug(config_section.get("debug") == "true");
+        if (changed)
+            INFO("Reloaded the configuration file.");
+        return changed;
     }
 
     inline std::filesystem::path ExePath()
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Touchpad
+{
+    /*
+     * Layout of a capture file. All values are little endian.
+     *
+     *   Header:  magic "TFDC" (4), version u16, reserved u16
+     *   Record:  type u8, followed by the payload of its type
+     *
+     *   Device:         device u64, has_report_id_prefix u8, field_count u16, report_count u16,
+     *                   field_count * field (report_id u8, slot u8, kind u8, bit_width u8, bit_offset u16,
+     *                                        logical_min i32, logical_max i32),
+     *                   report_count * table (report_id u8, slot_count u8, first_field u16, field_count u16),
+     *                   descriptor_format u8, descriptor_size u32, descriptor_size * byte
+     *   Report:         device u64, arrival_ns i64, scan_time u32, scan_time_bits u8, size u16, size * byte
+     *   DeviceRemoved:  device u64
+     *
+     * The device record describing a device always precedes its first report. It holds the layout the capturing
+     * build compiled and, if known, the descriptor bytes it was compiled from, which a replay compiles again.
+     * Version 1 captures end the device record after the tables.
+     */
+
+    constexpr uint8_t CAPTURE_MAGIC[4] = {'T', 'F', 'D', 'C'};
+    constexpr uint16_t CAPTURE_VERSION = 2;
+    constexpr uint16_t CAPTURE_LAYOUT_ONLY_VERSION = 1; ///< The last version without descriptor bytes.
+    constexpr size_t CAPTURE_HEADER_SIZE = 8;
+    constexpr size_t CAPTURE_DEVICE_HEADER_SIZE = 14; ///< A device record up to its fields, including the type.
+    constexpr size_t CAPTURE_FIELD_SIZE = 14;
+    constexpr size_t CAPTURE_TABLE_SIZE = 6;
+    constexpr size_t CAPTURE_DESCRIPTOR_HEADER_SIZE = 5;
+    constexpr size_t CAPTURE_REPORT_HEADER_SIZE = 24;
+    constexpr size_t CAPTURE_DEVICE_REMOVED_SIZE = 9;
+    constexpr auto CAPTURE_FILE_EXTENSION = ".tfdcap";
+
+    enum class CaptureRecordType : uint8_t
+    {
+        Device = 1,
+        Report = 2,
+        DeviceRemoved = 3
+    };
+}
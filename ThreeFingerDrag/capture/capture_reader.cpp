@@ -0,0 +1,169 @@
+#include "capture_reader.h"
+#include "../logging/logger.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace Touchpad
+{
+    bool CaptureReader::Open(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            ERROR("Could not open the capture file '" + path + "'.");
+            return false;
+        }
+
+        const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return Load(data.data(), data.size());
+    }
+
+    bool CaptureReader::Load(const uint8_t* data, const size_t size)
+    {
+        data_.clear();
+        position_ = 0;
+        malformed_ = false;
+
+        const bool has_magic =
+            size >= CAPTURE_HEADER_SIZE && std::equal(std::begin(CAPTURE_MAGIC), std::end(CAPTURE_MAGIC), data);
+        const uint16_t version = has_magic ? static_cast<uint16_t>(data[4] | data[5] << 8) : 0;
+
+        if (version != CAPTURE_VERSION && version != CAPTURE_LAYOUT_ONLY_VERSION)
+        {
+            ERROR("The file is not a supported capture file.");
+            return false;
+        }
+
+        data_.assign(data, data + size);
+        version_ = version;
+        Rewind();
+        return true;
+    }
+
+    void CaptureReader::Rewind()
+    {
+        position_ = std::min(CAPTURE_HEADER_SIZE, data_.size());
+        malformed_ = false;
+    }
+
+    bool CaptureReader::Next(CaptureRecord& record)
+    {
+        if (position_ >= data_.size())
+            return false;
+
+        uint8_t type = 0;
+        uint64_t device = 0;
+        Get(type);
+        if (!Get(device))
+        {
+            malformed_ = true;
+            return false;
+        }
+
+        record.type = static_cast<CaptureRecordType>(type);
+        record.device = static_cast<DeviceHandle>(device);
+
+        switch (record.type)
+        {
+        case CaptureRecordType::Device:
+            {
+                uint8_t has_report_id_prefix = 0;
+                uint16_t field_count = 0;
+                uint16_t report_count = 0;
+                if (!Get(has_report_id_prefix) || !Get(field_count) || !Get(report_count) ||
+                    data_.size() - position_ < field_count * CAPTURE_FIELD_SIZE + report_count * CAPTURE_TABLE_SIZE)
+                    break;
+
+                record.layout.has_report_id_prefix = has_report_id_prefix != 0;
+                record.layout.fields.resize(field_count);
+                record.layout.reports.resize(report_count);
+
+                for (ReportField& field : record.layout.fields)
+                {
+                    uint8_t kind = 0;
+                    Get(field.report_id);
+                    Get(field.slot);
+                    Get(kind);
+                    Get(field.bit_width);
+                    Get(field.bit_offset);
+                    Get(field.logical_min);
+                    Get(field.logical_max);
+                    field.kind = static_cast<ReportFieldKind>(kind);
+                }
+
+                for (ReportTable& table : record.layout.reports)
+                {
+                    Get(table.report_id);
+                    Get(table.slot_count);
+                    Get(table.first_field);
+                    Get(table.field_count);
+                }
+
+                record.descriptor_format = DescriptorFormat::None;
+                record.descriptor.clear();
+                if (version_ == CAPTURE_LAYOUT_ONLY_VERSION)
+                    return true;
+
+                uint8_t descriptor_format = 0;
+                uint32_t descriptor_size = 0;
+                if (!Get(descriptor_format) || !Get(descriptor_size) || data_.size() - position_ < descriptor_size)
+                    break;
+
+                record.descriptor_format = static_cast<DescriptorFormat>(descriptor_format);
+                record.descriptor.assign(data_.data() + position_, data_.data() + position_ + descriptor_size);
+                position_ += descriptor_size;
+                return true;
+            }
+        case CaptureRecordType::Report:
+            {
+                int64_t arrival_ns = 0;
+                uint16_t size = 0;
+                if (!Get(arrival_ns) || !Get(record.scan_time) || !Get(record.scan_time_bits) || !Get(size) ||
+                    data_.size() - position_ < size)
+                    break;
+
+                record.arrival_time = std::chrono::steady_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::nanoseconds(arrival_ns)));
+                record.data = data_.data() + position_;
+                record.size = size;
+                position_ += size;
+                return true;
+            }
+        case CaptureRecordType::DeviceRemoved:
+            return true;
+        }
+
+        malformed_ = true;
+        return false;
+    }
+
+    bool CaptureReader::Read(void* value, const size_t size)
+    {
+        if (data_.size() - position_ < size)
+        {
+            position_ = data_.size();
+            return false;
+        }
+
+        std::memcpy(value, data_.data() + position_, size);
+        position_ += size;
+        return true;
+    }
+
+    template <typename T>
+    bool CaptureReader::Get(T& value)
+    {
+        uint8_t bytes[sizeof(T)];
+        if (!Read(bytes, sizeof(T)))
+            return false;
+
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            bits |= static_cast<uint64_t>(bytes[i]) << i * 8;
+        value = static_cast<T>(bits);
+        return true;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "capture_format.h"
+#include "../hid/device_cache.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Touchpad
+{
+    /**
+     * \brief A single record of a capture file. Only the members of its type are set.
+     */
+    struct CaptureRecord
+    {
+        CaptureRecordType type = CaptureRecordType::Report;
+        DeviceHandle device = 0;
+        ReportLayout layout; ///< Device: the layout of the device, as compiled by the capturing build.
+        DescriptorFormat descriptor_format = DescriptorFormat::None; ///< Device: what the descriptor bytes hold.
+        std::vector<uint8_t> descriptor; ///< Device: the bytes the layout was compiled from, or empty.
+        std::chrono::steady_clock::time_point arrival_time; ///< Report: host time the report was received.
+        uint32_t scan_time = 0; ///< Report: the decoded Scan Time counter.
+        uint8_t scan_time_bits = 0; ///< Report: width of the Scan Time field, or 0 if absent.
+        const uint8_t* data = nullptr; ///< Report: the report bytes, valid until the reader is reopened.
+        size_t size = 0; ///< Report: size of the report in bytes.
+    };
+
+    /**
+     * \brief Reads the records of a capture file written by CaptureWriter. The whole file is loaded into memory
+     * up front, so reading records performs no I/O.
+     */
+    class CaptureReader
+    {
+    public:
+        /**
+         * \brief Loads a capture file and checks its header.
+         * \param path Path of the file.
+         * \return False if the file could not be read or is not a capture file.
+         */
+        bool Open(const std::string& path);
+
+        /**
+         * \brief Uses a capture already held in memory.
+         * \param data The capture bytes, starting with the header.
+         * \param size Size of the capture in bytes.
+         * \return False if the data does not start with a valid header.
+         */
+        bool Load(const uint8_t* data, size_t size);
+
+        /**
+         * \brief Reads the next record.
+         * \param record Receives the record.
+         * \return False at the end of the capture, or if the next record is truncated or unknown.
+         */
+        bool Next(CaptureRecord& record);
+
+        /**
+         * \brief Starts reading from the first record again.
+         */
+        void Rewind();
+
+        /**
+         * \brief Returns true if reading stopped at a malformed record rather than at the end of the capture.
+         */
+        bool Malformed() const { return malformed_; }
+
+    private:
+        bool Read(void* value, size_t size);
+
+        template <typename T>
+        bool Get(T& value);
+
+        std::vector<uint8_t> data_;
+        uint16_t version_ = CAPTURE_VERSION;
+        size_t position_ = 0;
+        bool malformed_ = false;
+    };
+}
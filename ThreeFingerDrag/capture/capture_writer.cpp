@@ -0,0 +1,358 @@
+#include "capture_writer.h"
+#include "../logging/logger.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace Touchpad
+{
+    namespace
+    {
+        template <typename T>
+        uint8_t* Put(uint8_t* destination, const T value)
+        {
+            const auto bits = static_cast<uint64_t>(value);
+            for (size_t i = 0; i < sizeof(T); i++)
+                *destination++ = static_cast<uint8_t>(bits >> i * 8);
+            return destination;
+        }
+
+        uint8_t* PutDevice(uint8_t* destination, const DeviceHandle device, const DeviceInfo& info)
+        {
+            const ReportLayout& layout = info.layout;
+            destination = Put<uint8_t>(destination, static_cast<uint8_t>(CaptureRecordType::Device));
+            destination = Put<uint64_t>(destination, device);
+            destination = Put<uint8_t>(destination, layout.has_report_id_prefix ? 1 : 0);
+            destination = Put<uint16_t>(destination, static_cast<uint16_t>(layout.fields.size()));
+            destination = Put<uint16_t>(destination, static_cast<uint16_t>(layout.reports.size()));
+
+            for (const ReportField& field : layout.fields)
+            {
+                destination = Put<uint8_t>(destination, field.report_id);
+                destination = Put<uint8_t>(destination, field.slot);
+                destination = Put<uint8_t>(destination, static_cast<uint8_t>(field.kind));
+                destination = Put<uint8_t>(destination, field.bit_width);
+                destination = Put<uint16_t>(destination, field.bit_offset);
+                destination = Put<int32_t>(destination, field.logical_min);
+                destination = Put<int32_t>(destination, field.logical_max);
+            }
+
+            for (const ReportTable& table : layout.reports)
+            {
+                destination = Put<uint8_t>(destination, table.report_id);
+                destination = Put<uint8_t>(destination, table.slot_count);
+                destination = Put<uint16_t>(destination, table.first_field);
+                destination = Put<uint16_t>(destination, table.field_count);
+            }
+
+            destination = Put<uint8_t>(destination, static_cast<uint8_t>(info.descriptor_format));
+            destination = Put<uint32_t>(destination, static_cast<uint32_t>(info.descriptor.size()));
+            return std::copy(info.descriptor.begin(), info.descriptor.end(), destination);
+        }
+    }
+
+    CaptureWriter::~CaptureWriter()
+    {
+        Close();
+    }
+
+    bool CaptureWriter::Open(const std::string& path)
+    {
+        Close();
+
+        path_ = path;
+        const std::filesystem::path file_path(path);
+        previous_path_ = (file_path.parent_path() / file_path.stem()).string() + ".1" +
+            file_path.extension().string();
+        if (!StartFile())
+        {
+            ERROR("Could not create the capture file '" + path + "'.");
+            return false;
+        }
+
+        // Allocated once, so that capturing never allocates on the input thread
+        for (auto& buffer : buffers_)
+        {
+            if (buffer == nullptr)
+                buffer = std::make_unique<uint8_t[]>(CAPTURE_BUFFER_SIZE);
+        }
+
+        active_buffer_ = 0;
+        used_ = 0;
+        active_starts_file_ = false;
+        file_size_ = CAPTURE_HEADER_SIZE;
+        devices_.clear();
+        reports_ = 0;
+        dropped_blocks_ = 0;
+        writer_busy_.store(false, std::memory_order_relaxed);
+        submit_requested_.store(false, std::memory_order_relaxed);
+        pending_size_ = 0;
+        stopping_ = false;
+        open_ = true;
+
+        thread_ = std::thread(&CaptureWriter::Run, this);
+        return true;
+    }
+
+    void CaptureWriter::Close()
+    {
+        if (!open_)
+            return;
+
+        // Wait for the writer thread to finish the previous buffer, then hand over the last one
+        if (used_ > 0)
+        {
+            {
+                std::unique_lock lock(mutex_);
+                written_condition_.wait(lock, [this] { return !writer_busy_.load(std::memory_order_acquire); });
+            }
+            SubmitBuffer();
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        wake_condition_.notify_one();
+
+        if (thread_.joinable())
+            thread_.join();
+
+        if (file_ != nullptr)
+            std::fclose(file_);
+        file_ = nullptr;
+        open_ = false;
+
+        if (dropped_blocks_ > 0)
+            WARNING(std::to_string(dropped_blocks_) +
+                " blocks of captured reports were dropped because the capture buffers were full.");
+    }
+
+    void CaptureWriter::WriteReport(const DeviceHandle device, const DeviceInfo& info, const uint8_t* report,
+                                    const size_t size, const std::chrono::steady_clock::time_point arrival_time,
+                                    const uint32_t scan_time, const uint8_t scan_time_bits)
+    {
+        if (!open_ || size > UINT16_MAX)
+            return;
+
+        // A new buffer may have to describe the device again, so room is made before sizing the description
+        const size_t report_size = CAPTURE_REPORT_HEADER_SIZE + size;
+        MakeRoom(DescriptionSize(device, info) + report_size);
+
+        const size_t description_size = DescriptionSize(device, info);
+        uint8_t* destination = Reserve(description_size + report_size);
+        if (destination == nullptr)
+            return;
+
+        if (description_size > 0)
+        {
+            destination = PutDevice(destination, device, info);
+            devices_.push_back(device);
+        }
+
+        const auto arrival_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(arrival_time.time_since_epoch()).count();
+
+        destination = Put<uint8_t>(destination, static_cast<uint8_t>(CaptureRecordType::Report));
+        destination = Put<uint64_t>(destination, device);
+        destination = Put<int64_t>(destination, arrival_ns);
+        destination = Put<uint32_t>(destination, scan_time);
+        destination = Put<uint8_t>(destination, scan_time_bits);
+        destination = Put<uint16_t>(destination, static_cast<uint16_t>(size));
+        std::copy(report, report + size, destination);
+        reports_++;
+    }
+
+    void CaptureWriter::WriteDeviceRemoved(const DeviceHandle device)
+    {
+        if (!open_)
+            return;
+
+        // Only a device described in the buffers of the current generation has to be removed
+        MakeRoom(CAPTURE_DEVICE_REMOVED_SIZE);
+        const auto it = std::find(devices_.begin(), devices_.end(), device);
+        if (it == devices_.end())
+            return;
+
+        devices_.erase(it);
+        uint8_t* destination = Reserve(CAPTURE_DEVICE_REMOVED_SIZE);
+
+        destination = Put<uint8_t>(destination, static_cast<uint8_t>(CaptureRecordType::DeviceRemoved));
+        Put<uint64_t>(destination, device);
+    }
+
+    size_t CaptureWriter::DescriptionSize(const DeviceHandle device, const DeviceInfo& info) const
+    {
+        if (std::find(devices_.begin(), devices_.end(), device) != devices_.end())
+            return 0;
+
+        return CAPTURE_DEVICE_HEADER_SIZE + info.layout.fields.size() * CAPTURE_FIELD_SIZE +
+            info.layout.reports.size() * CAPTURE_TABLE_SIZE + CAPTURE_DESCRIPTOR_HEADER_SIZE + info.descriptor.size();
+    }
+
+    void CaptureWriter::MakeRoom(const size_t size)
+    {
+        // Hand over a partly filled buffer once the writer thread asks for it, so that the file stays current
+        if (submit_requested_.load(std::memory_order_relaxed) && used_ > 0)
+            SubmitBuffer();
+
+        if (used_ + size > CAPTURE_BUFFER_SIZE)
+            NextBuffer();
+    }
+
+    uint8_t* CaptureWriter::Reserve(const size_t size)
+    {
+        // Only a record larger than a whole buffer does not fit once room has been made
+        if (used_ + size > CAPTURE_BUFFER_SIZE)
+            return nullptr;
+
+        uint8_t* destination = buffers_[active_buffer_].get() + used_;
+        used_ += size;
+        return destination;
+    }
+
+    void CaptureWriter::NextBuffer()
+    {
+        if (used_ == 0 || SubmitBuffer())
+            return;
+
+        if (overflow_policy_ == CaptureOverflowPolicy::Block)
+        {
+            {
+                std::unique_lock lock(mutex_);
+                written_condition_.wait(lock, [this] { return !writer_busy_.load(std::memory_order_acquire); });
+            }
+            SubmitBuffer();
+            return;
+        }
+
+        // The dropped buffer may hold the only description of a device, so every device is described again
+        dropped_blocks_++;
+        used_ = 0;
+        devices_.clear();
+    }
+
+    bool CaptureWriter::SubmitBuffer()
+    {
+        // The other buffer is still being written
+        if (writer_busy_.load(std::memory_order_acquire))
+            return false;
+
+        submit_requested_.store(false, std::memory_order_relaxed);
+        writer_busy_.store(true, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(mutex_);
+            pending_ = buffers_[active_buffer_].get();
+            pending_size_ = used_;
+            pending_starts_file_ = active_starts_file_;
+        }
+        wake_condition_.notify_one();
+
+        file_size_ += static_cast<long>(used_);
+        active_buffer_ ^= 1;
+        StartBuffer();
+        return true;
+    }
+
+    void CaptureWriter::StartBuffer()
+    {
+        used_ = 0;
+
+        // A buffer that could take the file past its limit is written to a new generation, which has to describe
+        // its devices again
+        active_starts_file_ = file_size_ + static_cast<long>(CAPTURE_BUFFER_SIZE) > CAPTURE_FILE_MAX_SIZE;
+        if (active_starts_file_)
+        {
+            file_size_ = CAPTURE_HEADER_SIZE;
+            devices_.clear();
+        }
+    }
+
+    void CaptureWriter::Run()
+    {
+        std::unique_lock lock(mutex_);
+        for (;;)
+        {
+            const bool woken = wake_condition_.wait_for(lock, std::chrono::milliseconds(CAPTURE_FLUSH_INTERVAL_MS),
+                                                        [this] { return stopping_ || pending_size_ > 0; });
+
+            if (pending_size_ > 0)
+            {
+                const uint8_t* data = pending_;
+                const size_t size = pending_size_;
+                const bool starts_file = pending_starts_file_;
+                lock.unlock();
+                WriteToFile(data, size, starts_file);
+                lock.lock();
+
+                pending_size_ = 0;
+                writer_busy_.store(false, std::memory_order_release);
+                written_condition_.notify_all();
+            }
+            else if (stopping_)
+            {
+                break;
+            }
+            else if (!woken)
+            {
+                submit_requested_.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void CaptureWriter::WriteToFile(const uint8_t* data, const size_t size, const bool starts_file)
+    {
+        if (file_ == nullptr)
+            return;
+
+        if (starts_file && !Rotate())
+        {
+            ERROR("Could not rotate the capture file, capturing stopped.");
+            return;
+        }
+
+        if (std::fwrite(data, 1, size, file_) != size || std::fflush(file_) != 0)
+        {
+            ERROR("Could not write to the capture file, capturing stopped.");
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    bool CaptureWriter::Rotate()
+    {
+        if (file_ != nullptr)
+            std::fclose(file_);
+        file_ = nullptr;
+
+        // Renaming fails if the file is held open elsewhere. The file is truncated below in that case, so it can
+        // never grow past its limit.
+        std::error_code error;
+        std::filesystem::remove(previous_path_, error);
+        std::filesystem::rename(path_, previous_path_, error);
+        return StartFile();
+    }
+
+    bool CaptureWriter::StartFile()
+    {
+        file_ = std::fopen(path_.c_str(), "wb");
+        if (file_ == nullptr)
+            return false;
+
+        if (!WriteFileHeader())
+        {
+            std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    bool CaptureWriter::WriteFileHeader()
+    {
+        uint8_t header[CAPTURE_HEADER_SIZE];
+        uint8_t* destination = std::copy(std::begin(CAPTURE_MAGIC), std::end(CAPTURE_MAGIC), header);
+        destination = Put<uint16_t>(destination, CAPTURE_VERSION);
+        Put<uint16_t>(destination, 0);
+        return std::fwrite(header, sizeof(header), 1, file_) == 1 && std::fflush(file_) == 0;
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include "capture_format.h"
+#include "../hid/device_cache.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Touchpad
+{
+    constexpr size_t CAPTURE_BUFFER_SIZE = 64 * 1024;
+    constexpr auto CAPTURE_FLUSH_INTERVAL_MS = 1000;
+    constexpr long CAPTURE_FILE_MAX_SIZE = 16 * 1024 * 1024; // 16MB
+
+    /**
+     * \brief What the capturing thread does when both capture buffers are in use.
+     */
+    enum class CaptureOverflowPolicy : uint8_t
+    {
+        Drop, ///< Drop the full buffer and count it, never stalling the caller.
+        Block ///< Wait for the writer thread to finish the other buffer.
+    };
+
+    /**
+     * \brief Appends raw touchpad reports, and the descriptors of the devices that sent them, to a binary capture file
+     * that can be fed back through the touch processor by a ReplayDriver.
+     *
+     * Records are copied into one of two preallocated buffers. Once it is full, or at least every
+     * CAPTURE_FLUSH_INTERVAL_MS, the buffer is handed to a background thread that writes it to the file while the
+     * other buffer fills up, so capturing costs the input thread a copy per report and never blocks it. A full
+     * buffer that finds the other one still being written is dropped and counted. Once the file could exceed
+     * CAPTURE_FILE_MAX_SIZE it is rotated, as the trace file is: it is renamed to a ".1" generation next to it,
+     * replacing the previous one, and a new file is started. A dropped buffer or a new file describes every device
+     * again before its next report, so each file can be replayed on its own.
+     *
+     * All Write functions and Close must be called from the same thread.
+     */
+    class CaptureWriter
+    {
+    public:
+        CaptureWriter() = default;
+        ~CaptureWriter();
+
+        CaptureWriter(const CaptureWriter& other) = delete;
+        CaptureWriter& operator=(const CaptureWriter& other) = delete;
+
+        /**
+         * \brief Creates the capture file, replacing any existing file, writes its header and starts the writer
+         * thread.
+         * \param path Path of the file.
+         * \return False if the file could not be created.
+         */
+        bool Open(const std::string& path);
+
+        /**
+         * \brief Writes the remaining records, stops the writer thread and closes the file.
+         */
+        void Close();
+
+        bool IsOpen() const { return open_; }
+
+        /**
+         * \brief Sets what happens to a full buffer while the other one is still being written. Defaults to dropping
+         * it.
+         */
+        void SetOverflowPolicy(CaptureOverflowPolicy policy) { overflow_policy_ = policy; }
+
+        /**
+         * \brief Appends a report, preceded by the layout and descriptor of its device if the device is not yet
+         * described.
+         * \param device Handle of the device that sent the report.
+         * \param info The cached data of the device.
+         * \param report The report bytes, starting with the report ID.
+         * \param size Size of the report in bytes.
+         * \param arrival_time Host time the report was received.
+         * \param scan_time The decoded Scan Time counter, or 0 if the report does not carry one.
+         * \param scan_time_bits Width of the Scan Time field, or 0 if the report does not carry one.
+         */
+        void WriteReport(DeviceHandle device, const DeviceInfo& info, const uint8_t* report, size_t size,
+                         std::chrono::steady_clock::time_point arrival_time, uint32_t scan_time,
+                         uint8_t scan_time_bits);
+
+        /**
+         * \brief Appends the removal of a device. Its descriptor is written again if the handle sends further reports.
+         */
+        void WriteDeviceRemoved(DeviceHandle device);
+
+        /**
+         * \brief Returns the number of reports written to the buffers.
+         */
+        uint64_t Reports() const { return reports_; }
+
+        /**
+         * \brief Returns the number of full buffers dropped because the other buffer was still being written.
+         */
+        uint64_t DroppedBlocks() const { return dropped_blocks_; }
+
+    private:
+        size_t DescriptionSize(DeviceHandle device, const DeviceInfo& info) const;
+        void MakeRoom(size_t size);
+        uint8_t* Reserve(size_t size);
+        void NextBuffer();
+        bool SubmitBuffer();
+        void StartBuffer();
+        void Run();
+        void WriteToFile(const uint8_t* data, size_t size, bool starts_file);
+        bool Rotate();
+        bool StartFile();
+        bool WriteFileHeader();
+
+        bool open_ = false;
+        std::string path_;
+        std::string previous_path_; ///< The generation the file is rotated to.
+
+        // Only used by the capturing thread
+        CaptureOverflowPolicy overflow_policy_ = CaptureOverflowPolicy::Drop;
+        std::unique_ptr<uint8_t[]> buffers_[2];
+        int active_buffer_ = 0;
+        size_t used_ = 0;
+        bool active_starts_file_ = false; ///< Set if the active buffer is written to a new generation of the file.
+        long file_size_ = 0; ///< Size of the current generation once the submitted buffers are written.
+        std::vector<DeviceHandle> devices_; ///< Devices described by the records kept in the current generation.
+        uint64_t reports_ = 0;
+        uint64_t dropped_blocks_ = 0;
+
+        // Hand over of full buffers to the writer thread
+        std::atomic<bool> writer_busy_{false}; ///< Set while the inactive buffer is being written.
+        std::atomic<bool> submit_requested_{false}; ///< Set by the writer thread when the interval has passed.
+        std::mutex mutex_;
+        std::condition_variable wake_condition_;
+        std::condition_variable written_condition_;
+        const uint8_t* pending_ = nullptr;
+        size_t pending_size_ = 0;
+        bool pending_starts_file_ = false;
+        bool stopping_ = false;
+        std::thread thread_;
+
+        // Only used by the writer thread while it runs
+        std::FILE* file_ = nullptr;
+    };
+}
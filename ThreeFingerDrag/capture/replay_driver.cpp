@@ -0,0 +1,194 @@
+#include "replay_driver.h"
+#include "../hid/report_descriptor.h"
+#include "../logging/logger.h"
+#ifdef _WIN32
+#include "../hid/raw_input_device_cache.h"
+#endif
+#include <algorithm>
+
+namespace Touchpad
+{
+    namespace
+    {
+        /**
+         * \brief Compiles the captured descriptor of a device.
+         * \return False if no descriptor was captured, or it cannot be compiled on this platform or at all.
+         */
+        bool CompileDescriptor(const CaptureRecord& record, ReportLayout& layout)
+        {
+            bool compiled = false;
+            switch (record.descriptor_format)
+            {
+            case DescriptorFormat::ReportDescriptor:
+                compiled = CompileReportDescriptor(record.descriptor.data(), record.descriptor.size(), layout);
+                break;
+            case DescriptorFormat::PreparsedData:
+#ifdef _WIN32
+                compiled = RawInputDeviceCache::CompilePreparsedData(record.descriptor.data(),
+                                                                     record.descriptor.size(), layout);
+                break;
+#else
+                // Only the HID parser of Windows reads pre-parsed data
+                return false;
+#endif
+            case DescriptorFormat::None:
+                return false;
+            }
+
+            if (!compiled)
+                WARNING("The captured descriptor of a device could not be compiled, using its captured layout.");
+            return compiled;
+        }
+    }
+
+    ReplayDriver::ReplayDriver(TouchProcessor& processor, StaticDeviceCache& device_cache)
+        : processor_(processor), device_cache_(device_cache),
+          timeout_scheduler_([this](const TimeoutKind kind, const time_point now) { HandleTimeout(kind, now); },
+                             clock_)
+    {
+        batch_.reserve(RAW_INPUT_BATCH_CAPACITY);
+        processor_.SetTimeoutScheduler(&timeout_scheduler_);
+        processor_.SetClock(&clock_);
+    }
+
+    ReplayDriver::~ReplayDriver()
+    {
+        processor_.SetClock(nullptr);
+        processor_.SetTimeoutScheduler(nullptr);
+    }
+
+    bool ReplayDriver::Run(CaptureReader& reader, const ReplaySpeed speed)
+    {
+        speed_ = speed;
+        stats_ = {};
+        batch_.clear();
+        reader.Rewind();
+
+        // Captured times are shifted to continue the virtual clock, or for real time replays to start at the steady
+        // clock, which the virtual clock then follows
+        bool started = false;
+        time_point first_report;
+        std::chrono::steady_clock::duration shift{0};
+
+        CaptureRecord& record = record_;
+        while (reader.Next(record))
+        {
+            if (filter_devices_ && record.device != only_device_)
+                continue;
+
+            switch (record.type)
+            {
+            case CaptureRecordType::Device:
+                FeedBatch();
+                DescribeDevice(record);
+                break;
+            case CaptureRecordType::DeviceRemoved:
+                FeedBatch();
+                processor_.RemoveDevice(record.device);
+                break;
+            case CaptureRecordType::Report:
+                {
+                    if (!started)
+                    {
+                        started = true;
+                        first_report = record.arrival_time;
+                        const time_point start = speed_ == ReplaySpeed::RealTime
+                                                     ? std::max(std::chrono::steady_clock::now(), clock_.Now())
+                                                     : clock_.Now();
+                        shift = start - first_report;
+                        clock_.AdvanceTo(start);
+                    }
+
+                    const time_point arrival_time = record.arrival_time + shift;
+                    stats_.captured_span = record.arrival_time - first_report;
+
+                    // Reports handled by one WM_INPUT message share their arrival time
+                    if (!batch_.empty() &&
+                        (batch_.back().arrival_time != arrival_time || batch_.size() == RAW_INPUT_BATCH_CAPACITY))
+                        FeedBatch();
+
+                    if (batch_.empty())
+                        AdvanceTo(arrival_time);
+
+                    batch_.push_back({record.device, record.data, record.size, arrival_time});
+                    stats_.reports++;
+                }
+                break;
+            }
+        }
+
+        FeedBatch();
+
+        // Let the gesture end the way it did after the last report
+        for (time_point deadline = EarliestDeadline(); deadline != time_point::max(); deadline = EarliestDeadline())
+            AdvanceTo(deadline);
+
+        return !reader.Malformed();
+    }
+
+    void ReplayDriver::DescribeDevice(const CaptureRecord& record)
+    {
+        // A device already described by an earlier replay keeps its storage, and its layout if the descriptor is the
+        // same, so that repeated replays of the same capture do not allocate
+        DeviceInfo* info = device_cache_.Find(record.device);
+        if (info == nullptr)
+        {
+            device_cache_.Insert(record.device, DeviceInfo{});
+            info = device_cache_.Find(record.device);
+        }
+        else if (info->descriptor_format != DescriptorFormat::None &&
+            info->descriptor_format == record.descriptor_format && info->descriptor == record.descriptor)
+        {
+            return;
+        }
+
+        info->descriptor_format = record.descriptor_format;
+        info->descriptor = record.descriptor;
+        if (!CompileDescriptor(record, info->layout))
+            info->layout = record.layout;
+    }
+
+    void ReplayDriver::FeedBatch()
+    {
+        if (batch_.empty())
+            return;
+
+        processor_.ProcessReports(batch_.data(), batch_.size());
+        batch_.clear();
+        stats_.batches++;
+    }
+
+    void ReplayDriver::AdvanceTo(const time_point time)
+    {
+        // Timeouts that expire before the time are run first, at their deadlines
+        for (time_point deadline = EarliestDeadline(); deadline <= time; deadline = EarliestDeadline())
+        {
+            if (speed_ == ReplaySpeed::RealTime)
+                SteadyClock::Instance().SleepUntil(deadline);
+
+            clock_.AdvanceTo(deadline);
+            timeout_scheduler_.RunExpired();
+            processor_.ProcessCommands();
+        }
+
+        if (speed_ == ReplaySpeed::RealTime)
+            SteadyClock::Instance().SleepUntil(time);
+
+        clock_.AdvanceTo(time);
+    }
+
+    void ReplayDriver::HandleTimeout(const TimeoutKind kind, const time_point now)
+    {
+        GestureCommand command;
+        if (processor_.CheckTimeout(kind, now, command) && processor_.PostCommand(command))
+            stats_.timeouts++;
+    }
+
+    ReplayDriver::time_point ReplayDriver::EarliestDeadline() const
+    {
+        time_point earliest = time_point::max();
+        for (size_t i = 0; i < TIMEOUT_KIND_COUNT; i++)
+            earliest = std::min(earliest, timeout_scheduler_.Deadline(static_cast<TimeoutKind>(i)));
+        return earliest;
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "capture_reader.h"
+#include "../gesture/gesture_clock.h"
+#include "../gesture/touch_processor.h"
+#include "../gesture/timeout_scheduler.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Touchpad
+{
+    enum class ReplaySpeed : uint8_t
+    {
+        RealTime, ///< Reports and timeouts are delivered with the timing they were captured with.
+        Maximum ///< Reports and timeouts are delivered as fast as they can be processed.
+    };
+
+    /**
+     * \brief Counters of a replay.
+     */
+    struct ReplayStats
+    {
+        uint64_t reports = 0;
+        uint64_t batches = 0;
+        uint64_t timeouts = 0; ///< Gesture timeouts that cancelled the gesture.
+        std::chrono::steady_clock::duration captured_span{0}; ///< Time between the first and last captured report.
+    };
+
+    /**
+     * \brief Feeds a capture back through a touch processor, and from there through the gesture engine and its output
+     * sink, without any touchpad or window.
+     *
+     * Device descriptors are compiled again by the replaying build, so that a capture also checks changes to the
+     * descriptor compilers. Devices whose descriptor was not captured, or cannot be compiled on this platform, use
+     * the layout compiled when they were captured.
+     *
+     * Reports that arrived together are fed as one batch, as the input thread received them. Gesture timeouts run on
+     * the replaying thread at their deadlines between reports, including those still armed after the last report, so
+     * that the gesture ends as it did when it was captured.
+     *
+     * The processor and the timeouts run on the virtual clock of the driver, which follows the captured times. At
+     * maximum speed it jumps from one report or deadline to the next, so an hour of captured input replays in as
+     * long as its reports take to process; in real time it is advanced in step with the steady clock.
+     */
+    class ReplayDriver
+    {
+    public:
+        /**
+         * \param processor The processor to feed.
+         * \param device_cache The device cache of the processor, which the devices of the capture are inserted into.
+         */
+        ReplayDriver(TouchProcessor& processor, StaticDeviceCache& device_cache);
+        ~ReplayDriver();
+
+        ReplayDriver(const ReplayDriver& other) = delete;
+        ReplayDriver& operator=(const ReplayDriver& other) = delete;
+
+        /**
+         * \brief Replays every record of a capture, from its first record.
+         * \param reader The capture to replay.
+         * \param speed Whether to keep the captured timing.
+         * \return False if the capture ended in a malformed record. The records before it are still replayed.
+         */
+        bool Run(CaptureReader& reader, ReplaySpeed speed);
+
+        /**
+         * \brief Replays only the records of one device, as if it were the only touchpad, so that each device of a
+         * capture can be fed to a processor of its own.
+         */
+        void ReplayOnly(const DeviceHandle device)
+        {
+            only_device_ = device;
+            filter_devices_ = true;
+        }
+
+        const ReplayStats& Stats() const { return stats_; }
+
+        /**
+         * \brief Returns the clock the replay runs on. Successive replays continue from where the last one ended.
+         */
+        const VirtualClock& Clock() const { return clock_; }
+
+    private:
+        using time_point = std::chrono::steady_clock::time_point;
+
+        void DescribeDevice(const CaptureRecord& record);
+        void FeedBatch();
+        void AdvanceTo(time_point time);
+        void HandleTimeout(TimeoutKind kind, time_point now);
+        time_point EarliestDeadline() const;
+
+        TouchProcessor& processor_;
+        StaticDeviceCache& device_cache_;
+        VirtualClock clock_;
+        TimeoutScheduler timeout_scheduler_;
+        ReplaySpeed speed_ = ReplaySpeed::Maximum;
+        std::vector<RawReport> batch_;
+        CaptureRecord record_; ///< Reused between replays, so that the layouts it reads keep their storage.
+        ReplayStats stats_;
+        DeviceHandle only_device_ = 0;
+        bool filter_devices_ = false;
+    };
+}
@@ -0,0 +1,148 @@
+#include "config_file.h"
+#include "../data/ini.h"
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    bool ParseNumber(const std::string& text, const double minimum, const double maximum, double& value)
+    {
+        char* end = nullptr;
+        errno = 0;
+        value = std::strtod(text.c_str(), &end);
+        return !text.empty() && end == text.c_str() + text.size() && errno == 0 && value >= minimum &&
+            value <= maximum;
+    }
+
+    /**
+     * \brief Reads a number setting if the section has it.
+     * \return False if the setting is present but malformed or out of range.
+     */
+    template <typename T>
+    bool ReadNumber(const mINI::INIMap<std::string>& section, const char* key, const double minimum,
+                    const double maximum, std::optional<T>& setting, std::string& error)
+    {
+        if (!section.has(key))
+            return true;
+
+        double value = 0.0;
+        if (!ParseNumber(section.get(key), minimum, maximum, value))
+        {
+            error = std::string("Setting '") + key + "' must be a number from " +
+                std::to_string(static_cast<long long>(minimum)) + " to " +
+                std::to_string(static_cast<long long>(maximum)) + ".";
+            return false;
+        }
+        setting = static_cast<T>(value);
+        return true;
+    }
+
+    bool ReadSwitch(const mINI::INIMap<std::string>& section, const char* key, std::optional<bool>& setting,
+                    std::string& error)
+    {
+        if (!section.has(key))
+            return true;
+
+        const std::string& value = section.get(key);
+        if (value != "true" && value != "false")
+        {
+            error = std::string("Setting '") + key + "' must be true or false.";
+            return false;
+        }
+        setting = value == "true";
+        return true;
+    }
+
+    template <typename T>
+    bool Differs(const std::optional<T>& setting, const T& current)
+    {
+        return setting.has_value() && *setting != current;
+    }
+}
+
+bool ConfigFile::Load(const std::string& path, ConfigFile& file, std::string& error)
+{
+    mINI::INIFile ini_file(path);
+    mINI::INIStructure ini;
+    if (!ini_file.read(ini))
+    {
+        error = "Couldn't read '" + path + "'.";
+        return false;
+    }
+
+    ConfigFile loaded;
+    const auto& section = ini["Configuration"];
+    if (!ReadNumber(section, "gesture_speed", MIN_GESTURE_SPEED, MAX_GESTURE_SPEED, loaded.gesture_speed, error) ||
+        !ReadNumber(section, "cancellation_delay_ms", MIN_CANCELLATION_DELAY_MS, MAX_CANCELLATION_DELAY_MS,
+                    loaded.cancellation_delay_ms, error) ||
+        !ReadNumber(section, "automatic_timeout_delay_ms", MIN_AUTOMATIC_TIMEOUT_DELAY_MS,
+                    MAX_AUTOMATIC_TIMEOUT_DELAY_MS, loaded.automatic_timeout_delay_ms, error) ||
+        !ReadNumber(section, "one_finger_transition_delay_ms", MIN_ONE_FINGER_TRANSITION_DELAY_MS,
+                    MAX_ONE_FINGER_TRANSITION_DELAY_MS, loaded.one_finger_transition_delay_ms, error) ||
+        !ReadSwitch(section, "debug", loaded.log_debug, error) ||
+        !ReadSwitch(section, "capture_reports", loaded.capture_reports, error) ||
+        !ReadSwitch(section, "trace", loaded.trace_frames, error))
+        return false;
+
+    file = loaded;
+    return true;
+}
+
+bool ConfigFile::Save(const std::string& path, const SettingsSnapshot& settings, std::string& error)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << settings.gesture_speed;
+
+    mINI::INIStructure ini;
+    ini["Configuration"]["gesture_speed"] = ss.str();
+    ini["Configuration"]["cancellation_delay_ms"] = std::to_string(settings.cancellation_delay_ms);
+    ini["Configuration"]["automatic_timeout_delay_ms"] = std::to_string(settings.automatic_timeout_delay_ms);
+    ini["Configuration"]["one_finger_transition_delay_ms"] = std::to_string(settings.one_finger_transition_delay_ms);
+    ini["Configuration"]["debug"] = settings.log_debug ? "true" : "false";
+    ini["Configuration"]["capture_reports"] = settings.capture_reports ? "true" : "false";
+    ini["Configuration"]["trace"] = settings.trace_frames ? "true" : "false";
+
+    const std::string temp_path = path + ".tmp";
+    if (!mINI::INIFile(temp_path).generate(ini))
+    {
+        error = "Couldn't write '" + temp_path + "'.";
+        return false;
+    }
+
+    // Replaces the previous file in one step, on Windows as well
+    std::error_code rename_error;
+    std::filesystem::rename(temp_path, path, rename_error);
+    if (rename_error)
+    {
+        error = "Couldn't replace '" + path + "': " + rename_error.message();
+        std::filesystem::remove(temp_path, rename_error);
+        return false;
+    }
+    return true;
+}
+
+void ConfigFile::ApplyTo(SettingsSnapshot& settings) const
+{
+    settings.gesture_speed = gesture_speed.value_or(settings.gesture_speed);
+    settings.cancellation_delay_ms = cancellation_delay_ms.value_or(settings.cancellation_delay_ms);
+    settings.automatic_timeout_delay_ms = automatic_timeout_delay_ms.value_or(settings.automatic_timeout_delay_ms);
+    settings.one_finger_transition_delay_ms =
+        one_finger_transition_delay_ms.value_or(settings.one_finger_transition_delay_ms);
+    settings.log_debug = log_debug.value_or(settings.log_debug);
+    settings.capture_reports = capture_reports.value_or(settings.capture_reports);
+    settings.trace_frames = trace_frames.value_or(settings.trace_frames);
+}
+
+bool ConfigFile::Changes(const SettingsSnapshot& settings) const
+{
+    return Differs(gesture_speed, settings.gesture_speed) ||
+        Differs(cancellation_delay_ms, settings.cancellation_delay_ms) ||
+        Differs(automatic_timeout_delay_ms, settings.automatic_timeout_delay_ms) ||
+        Differs(one_finger_transition_delay_ms, settings.one_finger_transition_delay_ms) ||
+        Differs(log_debug, settings.log_debug) ||
+        Differs(capture_reports, settings.capture_reports) ||
+        Differs(trace_frames, settings.trace_frames);
+}
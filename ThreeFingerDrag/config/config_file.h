@@ -0,0 +1,51 @@
+#pragma once
+#include "globalconfig.h"
+#include <optional>
+#include <string>
+
+/**
+ * \brief The settings read from a config.ini file. Settings the file does not mention are left unset.
+ *
+ * Portable, and safe to use on any thread, so that a changed file can be parsed and validated away from the GUI
+ * thread before anything is published.
+ */
+struct ConfigFile
+{
+    std::optional<double> gesture_speed;
+    std::optional<int> cancellation_delay_ms;
+    std::optional<int> automatic_timeout_delay_ms;
+    std::optional<int> one_finger_transition_delay_ms;
+    std::optional<bool> log_debug;
+    std::optional<bool> capture_reports;
+    std::optional<bool> trace_frames;
+
+    /**
+     * \brief Reads and validates a configuration file.
+     * \param path Path of the file.
+     * \param file Receives the settings of the file.
+     * \param error Receives a message naming the offending setting if the file is rejected.
+     * \return False if the file could not be read, or if any of its settings is malformed or out of range. Nothing
+     * is set in that case.
+     */
+    static bool Load(const std::string& path, ConfigFile& file, std::string& error);
+
+    /**
+     * \brief Writes every setting to a configuration file. The settings are written to a temporary file next to it,
+     * which then replaces the file, so that a reader never sees a partly written file.
+     * \param path Path of the file.
+     * \param settings The settings to write.
+     * \param error Receives a message if the file could not be written.
+     * \return False if the file could not be written, in which case it is left as it was.
+     */
+    static bool Save(const std::string& path, const SettingsSnapshot& settings, std::string& error);
+
+    /**
+     * \brief Overwrites the settings that the file sets.
+     */
+    void ApplyTo(SettingsSnapshot& settings) const;
+
+    /**
+     * \brief Returns true if applying the file would change any of the settings.
+     */
+    bool Changes(const SettingsSnapshot& settings) const;
+};
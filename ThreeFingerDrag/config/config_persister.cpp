@@ -0,0 +1,78 @@
+#include "config_persister.h"
+#include "config_file.h"
+#include "globalconfig.h"
+#include "../logging/logger.h"
+
+ConfigPersister::~ConfigPersister()
+{
+    Stop();
+}
+
+void ConfigPersister::Start(const std::string& path)
+{
+    if (IsRunning())
+        return;
+
+    path_ = path;
+    stopping_ = false;
+    thread_ = std::thread(&ConfigPersister::Run, this);
+}
+
+void ConfigPersister::Stop()
+{
+    if (!IsRunning())
+        return;
+
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+void ConfigPersister::RequestSave()
+{
+    {
+        std::lock_guard lock(mutex_);
+        pending_ = true;
+        requested_again_ = true;
+        last_request_ = std::chrono::steady_clock::now();
+    }
+    condition_.notify_all();
+}
+
+bool ConfigPersister::HasPendingSave() const
+{
+    std::lock_guard lock(mutex_);
+    return pending_;
+}
+
+void ConfigPersister::Run()
+{
+    std::unique_lock lock(mutex_);
+    while (true)
+    {
+        condition_.wait(lock, [this] { return pending_ || stopping_; });
+        if (!pending_)
+            return;
+
+        // Every request moves the deadline, so a burst of changes is written once; stopping skips the wait
+        const auto debounce = std::chrono::milliseconds(CONFIG_SAVE_DEBOUNCE_MS);
+        while (!stopping_ && std::chrono::steady_clock::now() < last_request_ + debounce)
+            condition_.wait_until(lock, last_request_ + debounce);
+
+        requested_again_ = false;
+        lock.unlock();
+
+        std::string error;
+        if (!ConfigFile::Save(path_, GlobalConfig::GetInstance()->Settings(), error))
+            ERROR(error);
+
+        // Still pending while being written, so that the change notification of this write is not taken for an
+        // edit; settings changed while writing are written with the next save
+        lock.lock();
+        if (!requested_again_)
+            pending_ = false;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+constexpr auto CONFIG_SAVE_DEBOUNCE_MS = 500;
+
+/**
+ * \brief Saves the settings to the configuration file on a thread of its own, so that the thread changing them never
+ * touches the disk.
+ *
+ * Save requests are coalesced: the file is written once no further request has arrived for CONFIG_SAVE_DEBOUNCE_MS,
+ * with the settings current at that moment. Dragging the gesture speed trackbar thus writes the file once, after the
+ * drag. Settings that are still waiting to be saved are written when the persister is stopped.
+ */
+class ConfigPersister
+{
+public:
+    ConfigPersister() = default;
+    ~ConfigPersister();
+
+    ConfigPersister(const ConfigPersister& other) = delete;
+    ConfigPersister& operator=(const ConfigPersister& other) = delete;
+
+    /**
+     * \brief Starts the persister thread.
+     * \param path Path of the configuration file.
+     */
+    void Start(const std::string& path);
+
+    /**
+     * \brief Writes the settings that are still waiting to be saved, and joins the persister thread.
+     */
+    void Stop();
+
+    /**
+     * \brief Asks for the current settings to be saved. Never blocks on the disk; may be called from any thread.
+     */
+    void RequestSave();
+
+    /**
+     * \brief Returns true from a save request until the file has been written, in which case the settings in memory
+     * are newer than the file or are being written to it.
+     */
+    bool HasPendingSave() const;
+
+    bool IsRunning() const { return thread_.joinable(); }
+
+private:
+    void Run();
+
+    std::string path_;
+    std::thread thread_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    bool pending_ = false; ///< Set from a request until the settings are written.
+    bool requested_again_ = false; ///< Set by a request made while the settings are being written.
+    bool stopping_ = false;
+    std::chrono::steady_clock::time_point last_request_;
+};
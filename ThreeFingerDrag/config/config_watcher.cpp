@@ -0,0 +1,220 @@
+#include "config_watcher.h"
+#include "../logging/logger.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+ConfigWatcher::~ConfigWatcher()
+{
+    Stop();
+}
+
+bool ConfigWatcher::Start(const std::string& path, ChangeHandler handler)
+{
+    if (IsWatching())
+        return false;
+
+    const std::filesystem::path file_path(path);
+    directory_ = file_path.has_parent_path() ? file_path.parent_path() : std::filesystem::path(".");
+    file_name_ = file_path.filename();
+    handler_ = std::move(handler);
+    stopping_ = false;
+
+#ifdef _WIN32
+    directory_handle_ = CreateFileW(directory_.c_str(), FILE_LIST_DIRECTORY,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                    FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    change_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    overlapped_ = {};
+    overlapped_.hEvent = change_event_;
+    if (directory_handle_ == INVALID_HANDLE_VALUE || stop_event_ == nullptr || change_event_ == nullptr ||
+        !BeginRead())
+    {
+        ERROR("Could not watch '" + directory_.u8string() + "' for configuration changes.");
+        CloseWatch();
+        return false;
+    }
+#elif defined(__linux__)
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd_ < 0 || stop_fd_ < 0 ||
+        inotify_add_watch(inotify_fd_, directory_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY) < 0)
+    {
+        ERROR("Could not watch '" + directory_.u8string() + "' for configuration changes.");
+        CloseWatch();
+        return false;
+    }
+#else
+    return false;
+#endif
+
+    thread_ = std::thread(&ConfigWatcher::Run, this);
+    return true;
+}
+
+void ConfigWatcher::Stop()
+{
+    if (!IsWatching())
+        return;
+
+    stopping_ = true;
+#ifdef _WIN32
+    SetEvent(stop_event_);
+#elif defined(__linux__)
+    const uint64_t wake = 1;
+    if (write(stop_fd_, &wake, sizeof(wake)) < 0)
+        ERROR("Could not wake the configuration watcher.");
+#endif
+    thread_.join();
+    CloseWatch();
+}
+
+void ConfigWatcher::Run()
+{
+    // A change is only reported once the file has been left alone for the debounce delay. Other files of the
+    // directory, such as the log, wake the wait as well, so the delay is measured from the last change of the file
+    // rather than taken from the wait timing out.
+    bool pending = false;
+    std::chrono::steady_clock::time_point deadline;
+    while (!stopping_)
+    {
+        int timeout_ms = -1;
+        if (pending)
+        {
+            const auto remaining =
+                std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0)
+            {
+                pending = false;
+                handler_();
+                continue;
+            }
+            timeout_ms = static_cast<int>(remaining.count());
+        }
+
+        bool changed = false;
+        if (!WaitForChange(timeout_ms, changed))
+            break;
+
+        if (changed)
+        {
+            pending = true;
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CONFIG_WATCH_DEBOUNCE_MS);
+        }
+    }
+}
+
+#ifdef _WIN32
+bool ConfigWatcher::BeginRead()
+{
+    ResetEvent(change_event_);
+    return ReadDirectoryChangesW(directory_handle_, buffer_, sizeof(buffer_), FALSE,
+                                 FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME |
+                                 FILE_NOTIFY_CHANGE_SIZE, nullptr, &overlapped_, nullptr) != 0;
+}
+
+bool ConfigWatcher::WaitForChange(const int timeout_ms, bool& changed)
+{
+    const HANDLE events[] = {stop_event_, change_event_};
+    const DWORD result = WaitForMultipleObjects(2, events, FALSE, timeout_ms < 0 ? INFINITE : timeout_ms);
+    if (result == WAIT_TIMEOUT)
+        return true;
+    if (result != WAIT_OBJECT_0 + 1)
+        return false;
+
+    DWORD size = 0;
+    if (!GetOverlappedResult(directory_handle_, &overlapped_, &size, FALSE))
+        return false;
+
+    // An empty result means the notifications overflowed the buffer, so any file may have changed
+    changed = size == 0;
+    for (DWORD offset = 0; size > 0;)
+    {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer_ + offset);
+        if (CompareStringOrdinal(info->FileName, static_cast<int>(info->FileNameLength / sizeof(WCHAR)),
+                                 file_name_.c_str(), -1, TRUE) == CSTR_EQUAL)
+            changed = true;
+
+        if (info->NextEntryOffset == 0)
+            break;
+        offset += info->NextEntryOffset;
+    }
+
+    return BeginRead();
+}
+
+void ConfigWatcher::CloseWatch()
+{
+    if (directory_handle_ != INVALID_HANDLE_VALUE)
+    {
+        CancelIoEx(directory_handle_, &overlapped_);
+        DWORD size = 0;
+        GetOverlappedResult(directory_handle_, &overlapped_, &size, TRUE);
+        CloseHandle(directory_handle_);
+        directory_handle_ = INVALID_HANDLE_VALUE;
+    }
+    if (stop_event_ != nullptr)
+    {
+        CloseHandle(stop_event_);
+        stop_event_ = nullptr;
+    }
+    if (change_event_ != nullptr)
+    {
+        CloseHandle(change_event_);
+        change_event_ = nullptr;
+    }
+}
+#elif defined(__linux__)
+bool ConfigWatcher::WaitForChange(const int timeout_ms, bool& changed)
+{
+    pollfd descriptors[] = {{stop_fd_, POLLIN, 0}, {inotify_fd_, POLLIN, 0}};
+    const int ready = poll(descriptors, 2, timeout_ms);
+    if (ready < 0)
+        return errno == EINTR;
+    if (ready == 0)
+        return true;
+    if (descriptors[0].revents != 0)
+        return false;
+
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        const ssize_t size = read(inotify_fd_, buffer, sizeof(buffer));
+        if (size <= 0)
+            return size == 0 || errno == EAGAIN || errno == EINTR;
+
+        for (ssize_t offset = 0; offset < size;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && file_name_ == event->name))
+                changed = true;
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+}
+
+void ConfigWatcher::CloseWatch()
+{
+    if (inotify_fd_ >= 0)
+        close(inotify_fd_);
+    if (stop_fd_ >= 0)
+        close(stop_fd_);
+    inotify_fd_ = -1;
+    stop_fd_ = -1;
+}
+#else
+bool ConfigWatcher::WaitForChange(int, bool&)
+{
+    return false;
+}
+
+void ConfigWatcher::CloseWatch()
+{
+}
+#endif
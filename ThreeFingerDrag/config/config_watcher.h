@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include "../framework.h"
+#endif
+
+constexpr auto CONFIG_WATCH_DEBOUNCE_MS = 250;
+
+/**
+ * \brief Watches a file for changes made by other programs and reports each burst of changes once, on a thread of
+ * its own.
+ *
+ * The directory of the file is watched rather than the file itself, so that editors that save by replacing the file
+ * are seen as well. A burst of changes is reported once the file has been left alone for CONFIG_WATCH_DEBOUNCE_MS, so
+ * that a file still being written is not read. Uses ReadDirectoryChangesW on Windows and inotify on Linux.
+ */
+class ConfigWatcher
+{
+public:
+    using ChangeHandler = std::function<void()>;
+
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher& other) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher& other) = delete;
+
+    /**
+     * \brief Starts watching a file.
+     * \param path Path of the file, which does not have to exist yet.
+     * \param handler Called on the watcher thread after the file has changed.
+     * \return False if the watch could not be set up or the platform is not supported.
+     */
+    bool Start(const std::string& path, ChangeHandler handler);
+
+    /**
+     * \brief Stops watching and joins the watcher thread.
+     */
+    void Stop();
+
+    bool IsWatching() const { return thread_.joinable(); }
+
+private:
+    void Run();
+
+    /**
+     * \brief Waits until something in the directory changes, the timeout elapses or the watcher is stopped.
+     * \param timeout_ms The timeout, or -1 to wait without one.
+     * \param changed Set to true if the file changed, left unchanged if only other files did.
+     * \return False if the watcher is stopping or the watch failed.
+     */
+    bool WaitForChange(int timeout_ms, bool& changed);
+    void CloseWatch();
+
+    std::filesystem::path directory_;
+    std::filesystem::path file_name_;
+    ChangeHandler handler_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+
+#ifdef _WIN32
+    HANDLE directory_handle_ = INVALID_HANDLE_VALUE;
+    HANDLE stop_event_ = nullptr;
+    HANDLE change_event_ = nullptr;
+    OVERLAPPED overlapped_{};
+    alignas(DWORD) uint8_t buffer_[16 * 1024]{};
+    bool BeginRead();
+#elif defined(__linux__)
+    int inotify_fd_ = -1;
+    int stop_fd_ = -1;
+#endif
+};
@@ -2,20 +2,6 @@
 
 GlobalConfig* GlobalConfig::instance_ = nullptr;
 
-GlobalConfig::GlobalConfig()
-{
-    // Set default values
-    gesture_speed_ = DEFAULT_ACCELERATION_FACTOR;
-    cancellation_delay_ms_ = DEFAULT_CANCELLATION_DELAY_MS;
-    automatic_timeout_delay_ms = DEFAULT_AUTOMATIC_TIMEOUT_DELAY_MS;
-    one_finger_transition_delay_ms_ = DEFAULT_ONE_FINGER_TRANSITION_DELAY_MS;
-    precision_touch_cursor_speed_ = DEFAULT_PRECISION_CURSOR_SPEED;
-    mouse_cursor_speed_ = DEFAULT_MOUSE_CURSOR_SPEED;
-    gesture_started_ = false;
-    cancellation_started_ = false;
-    log_debug_ = false;
-}
-
 GlobalConfig* GlobalConfig::GetInstance()
 {
     if (instance_ == nullptr)
@@ -23,142 +9,87 @@ GlobalConfig* GlobalConfig::GetInstance()
     return instance_;
 }
 
+SettingsSnapshot GlobalConfig::Settings() const
+{
+    return settings_.Copy();
+}
+
 int GlobalConfig::GetCancellationDelayMs() const
 {
-    return cancellation_delay_ms_;
+    return Settings().cancellation_delay_ms;
 }
 
 void GlobalConfig::SetCancellationDelayMs(int delay)
 {
-    cancellation_delay_ms_ = delay;
+    Update([delay](SettingsSnapshot& settings) { settings.cancellation_delay_ms = delay; });
 }
 
 double GlobalConfig::GetGestureSpeed() const
 {
-    return gesture_speed_;
+    return Settings().gesture_speed;
 }
 
 void GlobalConfig::SetGestureSpeed(double speed)
 {
-    gesture_speed_ = speed;
-}
-
-bool GlobalConfig::IsGestureStarted() const
-{
-    return gesture_started_;
-}
-
-void GlobalConfig::SetGestureStarted(bool started)
-{
-    gesture_started_ = started;
-}
-
-bool GlobalConfig::IsCancellationStarted() const
-{
-    return cancellation_started_;
-}
-
-void GlobalConfig::SetCancellationStarted(bool started)
-{
-    cancellation_started_ = started;
-}
-
-std::chrono::time_point<std::chrono::steady_clock> GlobalConfig::GetCancellationTime() const
-{
-    return cancellation_time_;
-}
-
-void GlobalConfig::SetCancellationTime(const std::chrono::time_point<std::chrono::steady_clock> time)
-{
-    cancellation_time_ = time;
-}
-
-std::chrono::time_point<std::chrono::steady_clock> GlobalConfig::GetLastValidMovement() const
-{
-    return last_valid_movement_;
-}
-
-void GlobalConfig::SetLastValidMovement(const std::chrono::time_point<std::chrono::steady_clock> time)
-{
-    last_valid_movement_ = time;
-}
-
-std::chrono::time_point<std::chrono::steady_clock> GlobalConfig::GetLastEvent() const
-{
-    return last_event_;
-}
-
-void GlobalConfig::SetLastEvent(const std::chrono::time_point<std::chrono::steady_clock> time)
-{
-    last_event_ = time;
-}
-
-std::vector<TouchContact> GlobalConfig::GetPreviousTouchContacts() const
-{
-    return previous_touch_contacts_;
-}
-
-void GlobalConfig::SetPreviousTouchContacts(const std::vector<TouchContact>& data)
-{
-    previous_touch_contacts_ = data;
+    Update([speed](SettingsSnapshot& settings) { settings.gesture_speed = speed; });
 }
 
 bool GlobalConfig::LogDebug() const
 {
-    return log_debug_;
+    return Settings().log_debug;
 }
 
 void GlobalConfig::SetLogDebug(bool log)
 {
-    log_debug_ = log;
+    Update([log](SettingsSnapshot& settings) { settings.log_debug = log; });
 }
 
-int GlobalConfig::GetLastContactCount() const
+bool GlobalConfig::CaptureReports() const
 {
-    return last_contact_count_;
+    return Settings().capture_reports;
 }
 
-void GlobalConfig::SetLastContactCount(int count)
+void GlobalConfig::SetCaptureReports(bool capture)
 {
-    last_contact_count_ = count;
+    Update([capture](SettingsSnapshot& settings) { settings.capture_reports = capture; });
 }
 
-std::chrono::time_point<std::chrono::steady_clock> GlobalConfig::GetLastOneFingerSwitchTime() const
+bool GlobalConfig::TraceFrames() const
 {
-    return last_one_finger_switch_time_;
+    return Settings().trace_frames;
 }
 
-void GlobalConfig::SetLastOneFingerSwitchTime(std::chrono::time_point<std::chrono::steady_clock> time)
+void GlobalConfig::SetTraceFrames(bool trace)
 {
-    last_one_finger_switch_time_ = time;
+    Update([trace](SettingsSnapshot& settings) { settings.trace_frames = trace; });
 }
 
 int GlobalConfig::GetOneFingerTransitionDelayMs() const
 {
-    return one_finger_transition_delay_ms_;
+    return Settings().one_finger_transition_delay_ms;
 }
 
 void GlobalConfig::SetOneFingerTransitionDelayMs(int delay)
 {
-    one_finger_transition_delay_ms_ = delay;
+    Update([delay](SettingsSnapshot& settings) { settings.one_finger_transition_delay_ms = delay; });
 }
 
 bool GlobalConfig::IsPortableMode() const
 {
-    return portable_mode_;
+    return Settings().portable_mode;
 }
 
 void GlobalConfig::SetPortableMode(bool portable)
 {
-    portable_mode_ = portable;
+    Update([portable](SettingsSnapshot& settings) { settings.portable_mode = portable; });
 }
 
 int GlobalConfig::GetAutomaticTimeoutDelayMs() const
 {
-    return automatic_timeout_delay_ms;
+    return Settings().automatic_timeout_delay_ms;
 }
 
 void GlobalConfig::SetAutomaticTimeoutDelayMs(int delay)
 {
-    automatic_timeout_delay_ms = delay;
+    Update([delay](SettingsSnapshot& settings) { settings.automatic_timeout_delay_ms = delay; });
 }
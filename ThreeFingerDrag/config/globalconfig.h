@@ -1,9 +1,9 @@
 #pragma once
 #ifndef GLOBALCONFIG_H
 #define GLOBALCONFIG_H
-#include <chrono>
-#include "../data/touch_data.h"
-#include "../event/touch_events.h"
+
+#include "../sync/rcu_cell.h"
+#include <cstdint>
 
 constexpr auto DEFAULT_ACCELERATION_FACTOR = 15.0;
 constexpr auto DEFAULT_PRECISION_CURSOR_SPEED = 0.5;
@@ -12,63 +12,98 @@ constexpr auto DEFAULT_CANCELLATION_DELAY_MS = 500;
 constexpr auto DEFAULT_ONE_FINGER_TRANSITION_DELAY_MS = 100;
 constexpr auto DEFAULT_AUTOMATIC_TIMEOUT_DELAY_MS = 33;
 
+// Accepted ranges of the settings
+constexpr auto MIN_CANCELLATION_DELAY_MS = 100;
+constexpr auto MAX_CANCELLATION_DELAY_MS = 2000;
+constexpr auto MIN_GESTURE_SPEED = 1;
+constexpr auto MAX_GESTURE_SPEED = 100;
+constexpr auto MIN_AUTOMATIC_TIMEOUT_DELAY_MS = 1;
+constexpr auto MAX_AUTOMATIC_TIMEOUT_DELAY_MS = 2000;
+constexpr auto MIN_ONE_FINGER_TRANSITION_DELAY_MS = 0;
+constexpr auto MAX_ONE_FINGER_TRANSITION_DELAY_MS = 2000;
+
+/**
+ * \brief An immutable set of user settings. Every change publishes a new snapshot with a higher version.
+ */
+struct SettingsSnapshot
+{
+    uint64_t version = 0;
+    double gesture_speed = DEFAULT_ACCELERATION_FACTOR;
+    double precision_touch_cursor_speed = DEFAULT_PRECISION_CURSOR_SPEED;
+    double mouse_cursor_speed = DEFAULT_MOUSE_CURSOR_SPEED;
+    int cancellation_delay_ms = DEFAULT_CANCELLATION_DELAY_MS;
+    int automatic_timeout_delay_ms = DEFAULT_AUTOMATIC_TIMEOUT_DELAY_MS;
+    int one_finger_transition_delay_ms = DEFAULT_ONE_FINGER_TRANSITION_DELAY_MS;
+    bool log_debug = false;
+    bool capture_reports = false;
+    bool trace_frames = false;
+    bool portable_mode = false;
+};
+
+/**
+ * \brief Holds the user settings as snapshots that are replaced as a whole, so that the input and timer threads
+ * never see a half-applied change.
+ *
+ * The input thread reads through a SettingsReader, at the cost of one acquire load per batch. The getters copy the
+ * current snapshot under the writer lock and may be called from any thread, as may the setters and Update, which
+ * publish a new snapshot.
+ */
 class GlobalConfig
 {
 private:
-    double gesture_speed_;
-    double precision_touch_cursor_speed_;
-    double mouse_cursor_speed_;
-    int cancellation_delay_ms_;
-    int automatic_timeout_delay_ms;
-    int one_finger_transition_delay_ms_;
-    int last_contact_count_;
-    bool gesture_started_;
-    bool cancellation_started_;
-    bool log_debug_;
-    bool portable_mode_;
-    std::chrono::time_point<std::chrono::steady_clock> cancellation_time_;
-    std::chrono::time_point<std::chrono::steady_clock> last_valid_movement_;
-    std::chrono::time_point<std::chrono::steady_clock> last_event_;
-    std::chrono::time_point<std::chrono::steady_clock> last_one_finger_switch_time_;
-    std::vector<TouchContact> previous_touch_contacts_;
+    Sync::RcuCell<SettingsSnapshot> settings_;
     static GlobalConfig* instance_;
 
     // Private constructor
-    GlobalConfig();
+    GlobalConfig() = default;
 
 public:
+    using SettingsReader = Sync::RcuCell<SettingsSnapshot>::Reader;
+
     // Singleton instance
     static GlobalConfig* GetInstance();
-    
+
+    /**
+     * \brief Returns the cell the snapshots are published in, to register a SettingsReader with.
+     */
+    Sync::RcuCell<SettingsSnapshot>& Snapshots() { return settings_; }
+
+    /**
+     * \brief Returns a copy of the current settings.
+     */
+    SettingsSnapshot Settings() const;
+
+    /**
+     * \brief Publishes a single snapshot with any number of settings changed.
+     * \param modify Called with a copy of the current settings to change.
+     */
+    template <typename Modify>
+    void Update(Modify&& modify)
+    {
+        settings_.Update([&modify](SettingsSnapshot& settings)
+        {
+            modify(settings);
+            settings.version++;
+        });
+    }
+
     int GetCancellationDelayMs() const;
     int GetAutomaticTimeoutDelayMs() const;
     int GetOneFingerTransitionDelayMs() const;
-    int GetLastContactCount() const;
     double GetGestureSpeed() const;
-    bool IsGestureStarted() const;
-    bool IsCancellationStarted() const;
     bool LogDebug() const;
+    bool CaptureReports() const;
+    bool TraceFrames() const;
     bool IsPortableMode() const;
-    std::chrono::time_point<std::chrono::steady_clock> GetCancellationTime() const;
-    std::chrono::time_point<std::chrono::steady_clock> GetLastValidMovement() const;
-    std::chrono::time_point<std::chrono::steady_clock> GetLastEvent() const;
-    std::chrono::time_point<std::chrono::steady_clock> GetLastOneFingerSwitchTime() const;
-    std::vector<TouchContact> GetPreviousTouchContacts() const;
 
     void SetCancellationDelayMs(int delay);
     void SetAutomaticTimeoutDelayMs(int delay);
     void SetOneFingerTransitionDelayMs(int delay);
-    void SetLastContactCount(int count);
     void SetGestureSpeed(double speed);
-    void SetGestureStarted(bool started);
-    void SetCancellationStarted(bool started);
     void SetLogDebug(bool log);
+    void SetCaptureReports(bool capture);
+    void SetTraceFrames(bool trace);
     void SetPortableMode(bool portable);
-    void SetCancellationTime(std::chrono::time_point<std::chrono::steady_clock> time);
-    void SetLastValidMovement(std::chrono::time_point<std::chrono::steady_clock> time);
-    void SetLastEvent(std::chrono::time_point<std::chrono::steady_clock> time);
-    void SetLastOneFingerSwitchTime(std::chrono::time_point<std::chrono::steady_clock> time);
-    void SetPreviousTouchContacts(const std::vector<TouchContact>& data);
 };
 
 #endif // GLOBALCONFIG_H
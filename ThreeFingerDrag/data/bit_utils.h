@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * \brief Returns the index of the lowest set bit. The value must not be zero.
+ */
+inline int CountTrailingZeros(const uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&index, value);
+#else
+    if (!_BitScanForward(&index, static_cast<unsigned long>(value)))
+    {
+        _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+        index += 32;
+    }
+#endif
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+/**
+ * \brief Returns the index of the highest set bit. The value must not be zero.
+ */
+inline int HighestSetBit(const uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanReverse64(&index, value);
+#else
+    if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+        index += 32;
+    else
+        _BitScanReverse(&index, static_cast<unsigned long>(value));
+#endif
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+/**
+ * \brief Returns the number of set bits.
+ */
+inline int PopCount(uint64_t value)
+{
+#if defined(_MSC_VER)
+    value = value - (value >> 1 & 0x5555555555555555ull);
+    value = (value & 0x3333333333333333ull) + (value >> 2 & 0x3333333333333333ull);
+    value = value + (value >> 4) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<int>(value * 0x0101010101010101ull >> 56);
+#else
+    return __builtin_popcountll(value);
+#endif
+}
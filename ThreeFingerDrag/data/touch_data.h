@@ -1,5 +1,9 @@
 #pragma once
-#include <vector>
+#include <array>
+#include <cstdint>
+#include "bit_utils.h"
+
+constexpr auto TOUCH_FRAME_CAPACITY = 10;
 
 struct TouchContact
 {
@@ -15,9 +19,91 @@ struct TouchContact
     int maximum_y;
 };
 
+/**
+ * \brief Fixed-capacity set of touch contacts. Occupied slots are tracked by a bitmask, so frames can be built,
+ * copied and cleared without any heap allocation.
+ */
+class TouchFrame
+{
+public:
+    static constexpr int CAPACITY = TOUCH_FRAME_CAPACITY;
+
+    /**
+     * \brief Iterates the occupied slots of a frame in slot order.
+     */
+    class Iterator
+    {
+    public:
+        Iterator(const TouchFrame* frame, const uint32_t remaining) : frame_(frame), remaining_(remaining)
+        {
+        }
+
+        const TouchContact& operator*() const { return frame_->contacts_[CountTrailingZeros(remaining_)]; }
+        const TouchContact* operator->() const { return &**this; }
+
+        Iterator& operator++()
+        {
+            remaining_ &= remaining_ - 1;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const { return remaining_ == other.remaining_; }
+        bool operator!=(const Iterator& other) const { return remaining_ != other.remaining_; }
+
+    private:
+        const TouchFrame* frame_;
+        uint32_t remaining_;
+    };
+
+    /**
+     * \brief Stores a contact in the lowest free slot.
+     * \return False if the frame is full.
+     */
+    bool Add(const TouchContact& contact)
+    {
+        const uint32_t free_slots = ~occupancy_ & FULL_MASK;
+        if (free_slots == 0)
+            return false;
+
+        const int slot = CountTrailingZeros(free_slots);
+        contacts_[slot] = contact;
+        occupancy_ |= 1u << slot;
+        return true;
+    }
+
+    void Clear() { occupancy_ = 0; }
+
+    bool IsOccupied(const int slot) const { return occupancy_ >> slot & 1; }
+    bool Empty() const { return occupancy_ == 0; }
+    int Size() const { return PopCount(occupancy_); }
+    uint32_t OccupancyMask() const { return occupancy_; }
+
+    /**
+     * \brief Returns the number of contacts that are touching the surface.
+     */
+    int CountOnSurface() const
+    {
+        int count = 0;
+        for (const auto& contact : *this)
+            count += contact.on_surface;
+        return count;
+    }
+
+    const TouchContact& operator[](const int slot) const { return contacts_[slot]; }
+
+    Iterator begin() const { return {this, occupancy_}; }
+    Iterator end() const { return {this, 0}; }
+
+private:
+    static constexpr uint32_t FULL_MASK = (1u << CAPACITY) - 1;
+
+    std::array<TouchContact, CAPACITY> contacts_{};
+    uint32_t occupancy_ = 0;
+};
+
 struct TouchInputData
 {
-    std::vector<TouchContact> contacts;
+    TouchFrame contacts;
     int contact_count = 0;
     bool can_perform_gesture = false;
 };
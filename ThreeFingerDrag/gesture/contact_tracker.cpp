@@ -0,0 +1,54 @@
+#include "contact_tracker.h"
+
+namespace Touchpad
+{
+    void ContactTracker::Merge(const TouchFrame& received_contacts)
+    {
+        for (const auto& contact : received_contacts)
+        {
+            // Filter out unwanted data
+            if (!IsValid(contact))
+                continue;
+
+            const uint64_t bit = 1ull << contact.contact_id;
+            slots_[contact.contact_id] = contact;
+            present_ |= bit;
+            if (contact.on_surface)
+                on_surface_ |= bit;
+            else
+                on_surface_ &= ~bit;
+        }
+    }
+
+    void ContactTracker::Snapshot(TouchFrame& frame) const
+    {
+        frame.Clear();
+        for (uint64_t mask = present_; mask != 0; mask &= mask - 1)
+        {
+            if (!frame.Add(slots_[CountTrailingZeros(mask)]))
+                break;
+        }
+    }
+
+    bool ContactTracker::IsValid(const TouchContact& contact)
+    {
+        if (contact.contact_id >= CONTACT_ID_MAXIMUM || contact.contact_id < CONTACT_ID_MINIMUM)
+            return false;
+
+        if (contact.x == 0 || contact.y == 0)
+            return false;
+
+        if (contact.has_x_bounds && !ValueWithinRange(contact.x, contact.minimum_x, contact.maximum_x))
+            return false;
+
+        if (contact.has_y_bounds && !ValueWithinRange(contact.y, contact.minimum_y, contact.maximum_y))
+            return false;
+
+        return true;
+    }
+
+    bool ContactTracker::ValueWithinRange(const int value, const int minimum, const int maximum)
+    {
+        return value < maximum && value > minimum;
+    }
+}
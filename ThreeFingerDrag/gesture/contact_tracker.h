@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "../data/touch_data.h"
+
+namespace Touchpad
+{
+    constexpr auto CONTACT_ID_MAXIMUM = 64;
+    constexpr auto CONTACT_ID_MINIMUM = 0;
+
+    /**
+     * \brief Keeps the latest state of every contact on the touchpad in a slot indexed by its contact ID. Presence
+     * and surface contact are tracked as bitmasks, so merging, lift-off removal and ordered iteration are bit
+     * operations.
+     */
+    class ContactTracker
+    {
+    public:
+        static constexpr int SLOT_COUNT = CONTACT_ID_MAXIMUM;
+
+        /**
+         * \brief Validates the received contacts and stores them, replacing the previous state of the same IDs.
+         * \param received_contacts Contacts decoded from the latest report.
+         */
+        void Merge(const TouchFrame& received_contacts);
+
+        /**
+         * \brief Drops every contact that is no longer touching the surface.
+         */
+        void RemoveLifted() { present_ &= on_surface_; }
+
+        void Clear()
+        {
+            present_ = 0;
+            on_surface_ = 0;
+        }
+
+        /**
+         * \brief Copies the tracked contacts into a frame, ordered by contact ID.
+         * \param frame The frame to fill. Cleared first.
+         */
+        void Snapshot(TouchFrame& frame) const;
+
+        int Size() const { return PopCount(present_); }
+        int CountOnSurface() const { return PopCount(present_ & on_surface_); }
+        uint64_t PresenceMask() const { return present_; }
+
+    private:
+        static bool IsValid(const TouchContact& contact);
+        static bool ValueWithinRange(int value, int minimum, int maximum);
+
+        std::array<TouchContact, SLOT_COUNT> slots_{};
+        uint64_t present_ = 0;
+        uint64_t on_surface_ = 0;
+    };
+}
@@ -0,0 +1,55 @@
+#include "frame_assembler.h"
+
+namespace Touchpad
+{
+    bool FrameAssembler::Push(const DecodedReport& report, DecodedReport& frame)
+    {
+        if (!report.has_contact_count)
+        {
+            frame = report;
+            return true;
+        }
+
+        if (report.contact_count > 0)
+        {
+            // A new frame begins before the previous one was completed
+            if (expected_contacts_ > 0)
+                dropped_frames_++;
+
+            pending_ = report;
+            pending_.contacts.Clear();
+            expected_contacts_ = report.contact_count;
+            received_contacts_ = 0;
+        }
+        else if (expected_contacts_ == 0)
+        {
+            // Continuation of a frame whose first report was never seen
+            if (!report.contacts.Empty())
+                dropped_frames_++;
+            return false;
+        }
+
+        // Slots beyond the announced contact count are unused padding
+        for (const auto& contact : report.contacts)
+        {
+            if (received_contacts_ >= expected_contacts_)
+                break;
+            pending_.contacts.Add(contact);
+            received_contacts_++;
+        }
+
+        if (received_contacts_ < expected_contacts_)
+            return false;
+
+        frame = pending_;
+        Reset();
+        return true;
+    }
+
+    void FrameAssembler::Reset()
+    {
+        pending_.contacts.Clear();
+        expected_contacts_ = 0;
+        received_contacts_ = 0;
+    }
+}
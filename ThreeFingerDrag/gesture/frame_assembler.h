@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include "../hid/report_layout.h"
+
+namespace Touchpad
+{
+    /**
+     * \brief Joins the reports of a touchpad frame into a single frame.
+     *
+     * In hybrid reporting mode a touchpad sends more contacts than fit in one report across several reports. The
+     * first report of a frame announces the total number of contacts through the Contact Count usage and the
+     * following reports carry a count of zero. Reports of devices that do not send a contact count are passed
+     * through as complete frames.
+     */
+    class FrameAssembler
+    {
+    public:
+        /**
+         * \brief Adds a decoded report to the frame being assembled.
+         * \param report The decoded report.
+         * \param frame Receives the frame once it is complete, with the contact count and scan time of its first
+         * report and the contacts of all of its reports.
+         * \return True if a complete frame was written to the output.
+         */
+        bool Push(const DecodedReport& report, DecodedReport& frame);
+
+        /**
+         * \brief Discards any partially assembled frame.
+         */
+        void Reset();
+
+        /**
+         * \brief Returns the number of frames discarded because their remaining reports never arrived.
+         */
+        uint32_t DroppedFrames() const { return dropped_frames_; }
+
+    private:
+        DecodedReport pending_;
+        int expected_contacts_ = 0;
+        int received_contacts_ = 0;
+        uint32_t dropped_frames_ = 0;
+    };
+}
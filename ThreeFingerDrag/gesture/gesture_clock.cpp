@@ -0,0 +1,97 @@
+#include "gesture_clock.h"
+#include <algorithm>
+#include <thread>
+
+namespace Touchpad
+{
+    SteadyClock& SteadyClock::Instance()
+    {
+        static SteadyClock clock;
+        return clock;
+    }
+
+    void SteadyClock::WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+                                const time_point deadline, const WakeCondition& woken)
+    {
+        condition.wait_until(lock, deadline, woken);
+    }
+
+    void SteadyClock::SleepUntil(const time_point time)
+    {
+        std::this_thread::sleep_until(time);
+    }
+
+    VirtualClock::VirtualClock(const time_point start)
+        : now_(start.time_since_epoch().count())
+    {
+    }
+
+    VirtualClock::time_point VirtualClock::Now() const
+    {
+        return time_point(std::chrono::steady_clock::duration(now_.load()));
+    }
+
+    void VirtualClock::WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+                                 const time_point deadline, const WakeCondition& woken)
+    {
+        // The waiter is added without the caller's mutex held, as AdvanceTo takes the two in the opposite order. It
+        // is added before the time is first checked, so an advance either is seen by the check or notifies after
+        // the wait has started.
+        lock.unlock();
+        AddWaiter({lock.mutex(), &condition});
+        lock.lock();
+
+        condition.wait(lock, [&] { return woken() || Now() >= deadline; });
+
+        lock.unlock();
+        RemoveWaiter(&condition);
+        lock.lock();
+    }
+
+    void VirtualClock::SleepUntil(const time_point time)
+    {
+        std::unique_lock lock(sleep_mutex_);
+        WaitUntil(lock, sleep_condition_, time, [] { return false; });
+    }
+
+    void VirtualClock::AdvanceTo(const time_point time)
+    {
+        const auto value = time.time_since_epoch().count();
+        auto current = now_.load();
+        while (current < value && !now_.compare_exchange_weak(current, value))
+        {
+        }
+
+        // Taking each waiter's mutex orders the notification after its check of the time, so it cannot be missed
+        std::lock_guard waiters_lock(waiters_mutex_);
+        for (const Waiter& waiter : waiters_)
+        {
+            {
+                std::lock_guard lock(*waiter.mutex);
+            }
+            waiter.condition->notify_all();
+        }
+    }
+
+    void VirtualClock::Advance(const std::chrono::steady_clock::duration duration)
+    {
+        AdvanceTo(Now() + duration);
+    }
+
+    void VirtualClock::AddWaiter(const Waiter& waiter)
+    {
+        std::lock_guard lock(waiters_mutex_);
+        waiters_.push_back(waiter);
+    }
+
+    void VirtualClock::RemoveWaiter(const std::condition_variable* condition)
+    {
+        std::lock_guard lock(waiters_mutex_);
+        const auto waiter = std::find_if(waiters_.begin(), waiters_.end(), [condition](const Waiter& candidate)
+        {
+            return candidate.condition == condition;
+        });
+        if (waiter != waiters_.end())
+            waiters_.erase(waiter);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Touchpad
+{
+    /**
+     * \brief The time source of the gesture pipeline: the touch processor, the timeout scheduler and the replay
+     * driver read the time and wait for deadlines through it, so that a simulation can run them on virtual time.
+     */
+    class GestureClock
+    {
+    public:
+        using time_point = std::chrono::steady_clock::time_point;
+        using WakeCondition = std::function<bool()>;
+
+        virtual ~GestureClock() = default;
+
+        virtual time_point Now() const = 0;
+
+        /**
+         * \brief Blocks on a condition variable until the clock reaches a deadline or the wake condition holds.
+         * \param lock Holds the mutex that the condition variable is notified under.
+         * \param condition The condition variable, notified whenever the wake condition may have changed.
+         * \param deadline The time to wait for.
+         * \param woken Checked with the mutex held, before waiting and after every wakeup.
+         */
+        virtual void WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+                               time_point deadline, const WakeCondition& woken) = 0;
+
+        /**
+         * \brief Blocks the calling thread until the clock reaches a time.
+         */
+        virtual void SleepUntil(time_point time) = 0;
+    };
+
+    /**
+     * \brief The steady clock of the system. Used by default everywhere a clock can be given.
+     */
+    class SteadyClock final : public GestureClock
+    {
+    public:
+        static SteadyClock& Instance();
+
+        time_point Now() const override { return std::chrono::steady_clock::now(); }
+        void WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, time_point deadline,
+                       const WakeCondition& woken) override;
+        void SleepUntil(time_point time) override;
+    };
+
+    /**
+     * \brief A clock that only moves when it is advanced, so that timeouts of any length expire as soon as the
+     * simulation reaches them instead of after the real delay.
+     *
+     * Threads waiting on the clock, such as a started TimeoutScheduler, are woken every time it is advanced. The
+     * clock never moves backwards.
+     */
+    class VirtualClock final : public GestureClock
+    {
+    public:
+        explicit VirtualClock(time_point start = time_point());
+
+        VirtualClock(const VirtualClock& other) = delete;
+        VirtualClock& operator=(const VirtualClock& other) = delete;
+
+        time_point Now() const override;
+        void WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, time_point deadline,
+                       const WakeCondition& woken) override;
+
+        /**
+         * \brief Returns once another thread has advanced the clock to the time.
+         */
+        void SleepUntil(time_point time) override;
+
+        /**
+         * \brief Moves the clock to a time, or leaves it where it is if the time has already passed, and wakes every
+         * thread waiting on it.
+         */
+        void AdvanceTo(time_point time);
+
+        void Advance(std::chrono::steady_clock::duration duration);
+
+    private:
+        struct Waiter
+        {
+            std::mutex* mutex;
+            std::condition_variable* condition;
+        };
+
+        void AddWaiter(const Waiter& waiter);
+        void RemoveWaiter(const std::condition_variable* condition);
+
+        std::atomic<std::chrono::steady_clock::duration::rep> now_;
+        std::mutex waiters_mutex_;
+        std::vector<Waiter> waiters_;
+
+        // Used by SleepUntil, which has no condition variable of its own
+        std::mutex sleep_mutex_;
+        std::condition_variable sleep_condition_;
+    };
+}
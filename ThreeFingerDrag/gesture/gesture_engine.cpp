@@ -0,0 +1,203 @@
+#include "gesture_engine.h"
+#include <cmath>
+
+namespace Touchpad
+{
+    GestureEngine::GestureEngine(const GestureSettings& settings) : settings_(settings)
+    {
+    }
+
+    GestureState GestureEngine::Step(const GestureState& state, const GestureFrame& frame,
+                                     const std::chrono::steady_clock::time_point now, GestureOutput& output) const
+    {
+        output.Clear();
+        GestureState next = state;
+
+        // A frame without any contact on the surface is a touch up
+        if (frame.touch.contacts.CountOnSurface() == 0)
+            OnTouchUp(next, frame, now, output);
+        else
+            OnTouchActivity(next, frame, now, output);
+
+        next.previous_contacts = frame.touch.contacts;
+        next.last_event = now;
+        return next;
+    }
+
+    GestureState GestureEngine::Cancel(const GestureState& state, const bool left_button_down,
+                                       GestureOutput& output) const
+    {
+        output.Clear();
+        GestureState next = state;
+        CancelGesture(next, left_button_down, output);
+        return next;
+    }
+
+    void GestureEngine::CancelGesture(GestureState& state, const bool left_button_down, GestureOutput& output)
+    {
+        if (left_button_down)
+            output.Push(OutputCommandType::LeftButtonUp);
+        state.cancellation_started = false;
+        state.gesture_started = false;
+        output.transitions |= TRANSITION_GESTURE_CANCELLED;
+    }
+
+    void GestureEngine::OnTouchActivity(GestureState& state, const GestureFrame& frame,
+                                        const std::chrono::steady_clock::time_point now,
+                                        GestureOutput& output) const
+    {
+        const TouchInputData& data = frame.touch;
+        const TouchFrame& previous_data = state.previous_contacts;
+
+        // Check if it's the initial gesture
+        const bool is_dragging = frame.left_button_down;
+        const bool is_initial_gesture = !is_dragging && data.can_perform_gesture;
+
+        // If it's the initial gesture, set the gesture start time
+        if (is_initial_gesture && !state.gesture_started)
+        {
+            state.gesture_started = true;
+            state.gesture_start = now;
+            output.transitions |= TRANSITION_GESTURE_STARTED;
+        }
+
+        // If there's no previous data, return
+        if (previous_data.Empty())
+            return;
+
+        // Calculate the time elapsed
+        const float ms_since_gesture_start = CalculateElapsedTimeMs(state.gesture_start, now);
+        const float ms_since_last_event = CalculateElapsedTimeMs(state.last_event, now);
+
+        // Prevent initial movement jitter
+        if (ms_since_last_event > GESTURE_START_THRESHOLD_MS)
+            return;
+
+        // Ignore initial movement
+        if (ms_since_gesture_start <= GESTURE_START_THRESHOLD_MS)
+            return;
+
+        // If invalid amount of fingers, and gesture is not currently performing
+        if (!data.can_perform_gesture && !is_dragging)
+            return;
+
+        // Loop through each touch contact
+        int valid_touches = 0;
+        double movement_x = 0.0;
+        double movement_y = 0.0;
+        for (int i = 0; i < TOUCH_FRAME_CAPACITY; i++)
+        {
+            if (!data.contacts.IsOccupied(i) || !previous_data.IsOccupied(i))
+                continue;
+
+            const auto& contact = data.contacts[i];
+            const auto& previous_contact = previous_data[i];
+
+            if (!contact.on_surface || !previous_contact.on_surface)
+                continue;
+
+            // Only compare identical touch contact points
+            if (contact.contact_id != previous_contact.contact_id)
+                continue;
+
+            // Ignore initial movement of contact point if inactivity, to prevent jitter
+            const float ms_since_movement = CalculateElapsedTimeMs(state.movement_times[i], now);
+            state.movement_times[i] = now;
+
+            if (ms_since_movement > INACTIVITY_THRESHOLD_MS)
+                continue;
+
+            // Cancel immediately if a previous cancellation has begun, and this is a non-gesture movement
+            if (state.cancellation_started && !data.can_perform_gesture && state.gesture_started)
+            {
+                CancelGesture(state, is_dragging, output);
+                return;
+            }
+
+            // Calculate the movement delta for the current finger
+            const double x_diff = contact.x - previous_contact.x;
+            const double y_diff = contact.y - previous_contact.y;
+
+            // Check if any movement was present
+            if (x_diff == 0.0 && y_diff == 0.0)
+                continue;
+
+            movement_x += x_diff;
+            movement_y += y_diff;
+            valid_touches++;
+        }
+
+        const auto contact_count = data.contact_count;
+
+        // Switched to one finger during gesture
+        if (contact_count == 1 && state.last_contact_count == 1)
+        {
+            const float ms_since_last_switch = CalculateElapsedTimeMs(state.last_one_finger_switch_time, now);
+
+            // After a short delay, stop continuing the gesture movement from this event in favor of
+            // default touchpad cursor movement to prevent input flooding.
+            if (ms_since_last_switch > settings_.one_finger_transition_delay_ms)
+                return;
+        }
+
+        if (state.gesture_started && state.last_contact_count > 1 && contact_count == 1)
+            state.last_one_finger_switch_time = now;
+
+        state.last_contact_count = contact_count;
+
+        // If there are not enough valid touches, return
+        if (valid_touches < MIN_VALID_TOUCH_CONTACTS)
+            return;
+
+        // Apply movement acceleration
+        const double gesture_speed = settings_.gesture_speed / 100.0;
+        const double delta_x = movement_x * gesture_speed;
+        const double delta_y = movement_y * gesture_speed;
+
+        state.cancellation_started = false;
+
+        // Move the mouse pointer by the exact delta of this frame. The output sink carries the sub-pixel remainder
+        // into the next move.
+        output.Push(OutputCommandType::MoveCursor, delta_x, delta_y);
+
+        // Start dragging if left mouse is not already down
+        if (!is_dragging)
+            output.Push(OutputCommandType::LeftButtonDown);
+
+        // Only a move of at least one pixel since the last valid movement counts as valid movement, so sensor
+        // jitter does not keep postponing the cancellation
+        state.unreported_movement_x += delta_x;
+        state.unreported_movement_y += delta_y;
+        if (std::abs(state.unreported_movement_x) + std::abs(state.unreported_movement_y) < 1.0)
+            return;
+
+        // Set timestamp for last valid movement
+        state.last_valid_movement = now;
+        if (std::abs(state.unreported_movement_x) >= 1.0)
+            state.unreported_movement_x = 0.0;
+        if (std::abs(state.unreported_movement_y) >= 1.0)
+            state.unreported_movement_y = 0.0;
+    }
+
+    void GestureEngine::OnTouchUp(GestureState& state, const GestureFrame& frame,
+                                  const std::chrono::steady_clock::time_point now, GestureOutput& output) const
+    {
+        if (state.cancellation_started || !state.gesture_started)
+            return;
+
+        // Calculate the time elapsed since the last valid gesture movement
+        const float ms_since_last_movement = CalculateElapsedTimeMs(state.last_valid_movement, now);
+
+        // If there hasn't been any movement for same amount of time we will delay, then cancel immediately
+        if (ms_since_last_movement >= static_cast<float>(settings_.cancellation_delay_ms))
+        {
+            CancelGesture(state, frame.left_button_down, output);
+            return;
+        }
+
+        state.cancellation_started = true;
+        state.cancellation_time = now;
+        state.last_valid_movement = now;
+        output.transitions |= TRANSITION_CANCELLATION_STARTED;
+    }
+}
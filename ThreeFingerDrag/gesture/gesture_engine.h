@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "../data/touch_data.h"
+#include "../mouse/output_sink.h"
+
+namespace Touchpad
+{
+    constexpr auto NUM_TOUCH_CONTACTS_REQUIRED = 3;
+    constexpr auto MIN_VALID_TOUCH_CONTACTS = 1;
+    constexpr auto INACTIVITY_THRESHOLD_MS = 100;
+    constexpr auto GESTURE_START_THRESHOLD_MS = 50;
+    constexpr auto MAX_OUTPUT_COMMANDS = 4;
+
+    constexpr uint8_t TRANSITION_GESTURE_STARTED = 0x01;
+    constexpr uint8_t TRANSITION_GESTURE_CANCELLED = 0x02;
+    constexpr uint8_t TRANSITION_CANCELLATION_STARTED = 0x04;
+
+    inline float CalculateElapsedTimeMs(const std::chrono::time_point<std::chrono::steady_clock>& start_time,
+                                        const std::chrono::time_point<std::chrono::steady_clock>& end_time)
+    {
+        const std::chrono::duration<float> elapsed = end_time - start_time;
+        return elapsed.count() * 1000.0f;
+    }
+
+    /**
+     * \brief The user settings the gesture engine depends on.
+     */
+    struct GestureSettings
+    {
+        double gesture_speed = 0.0; ///< Percentage applied to the accumulated finger movement.
+        int cancellation_delay_ms = 0;
+        int automatic_timeout_delay_ms = 0;
+        int one_finger_transition_delay_ms = 0;
+    };
+
+    /**
+     * \brief Everything the gesture engine remembers between frames.
+     */
+    struct GestureState
+    {
+        bool gesture_started = false;
+        bool cancellation_started = false;
+        int last_contact_count = 0;
+        std::chrono::steady_clock::time_point gesture_start;
+        std::chrono::steady_clock::time_point last_event;
+        std::chrono::steady_clock::time_point last_valid_movement;
+        std::chrono::steady_clock::time_point cancellation_time;
+        std::chrono::steady_clock::time_point last_one_finger_switch_time;
+        double unreported_movement_x = 0.0; ///< Scaled movement since the last valid movement.
+        double unreported_movement_y = 0.0;
+        TouchFrame previous_contacts;
+        std::array<std::chrono::steady_clock::time_point, TOUCH_FRAME_CAPACITY> movement_times{};
+    };
+
+    /**
+     * \brief A frame of touch input as seen by the gesture engine.
+     */
+    struct GestureFrame
+    {
+        TouchInputData touch; ///< All tracked contacts, in contact ID order.
+        bool left_button_down = false; ///< True if the left mouse button is held when the frame is processed.
+    };
+
+    /**
+     * \brief The mouse commands produced by a single step of the gesture engine, in the order they must be sent.
+     * The buffer is flushed to an OutputSink once per step.
+     */
+    struct GestureOutput
+    {
+        std::array<OutputCommand, MAX_OUTPUT_COMMANDS> commands{};
+        uint8_t count = 0;
+        uint8_t transitions = 0; ///< TRANSITION_* flags describing the state changes of the step.
+
+        void Clear()
+        {
+            count = 0;
+            transitions = 0;
+        }
+
+        void Push(const OutputCommandType type, const double delta_x = 0.0, const double delta_y = 0.0)
+        {
+            if (count < commands.size())
+                commands[count++] = {type, delta_x, delta_y};
+        }
+    };
+
+    /**
+     * \brief The three-finger drag state machine. Each step maps the previous state and an input to the next state
+     * and the mouse commands to send. The engine holds no state of its own besides its settings, accesses no
+     * globals and makes no system calls, so it can run on any thread and be replayed deterministically.
+     */
+    class GestureEngine
+    {
+    public:
+        explicit GestureEngine(const GestureSettings& settings = {});
+
+        void SetSettings(const GestureSettings& settings) { settings_ = settings; }
+        const GestureSettings& Settings() const { return settings_; }
+
+        /**
+         * \brief Advances the state machine by one touch frame.
+         * \param state The state after the previous step.
+         * \param frame The touch frame.
+         * \param now Time the frame was sampled.
+         * \param output Receives the mouse commands of the step. Cleared first.
+         * \return The state after the frame.
+         */
+        GestureState Step(const GestureState& state, const GestureFrame& frame,
+                          std::chrono::steady_clock::time_point now, GestureOutput& output) const;
+
+        /**
+         * \brief Cancels the gesture, releasing the left mouse button if it is held.
+         * \param state The state after the previous step.
+         * \param left_button_down True if the left mouse button is held.
+         * \param output Receives the mouse commands of the step. Cleared first.
+         * \return The state after the cancellation.
+         */
+        GestureState Cancel(const GestureState& state, bool left_button_down, GestureOutput& output) const;
+
+    private:
+        void OnTouchActivity(GestureState& state, const GestureFrame& frame,
+                             std::chrono::steady_clock::time_point now, GestureOutput& output) const;
+        void OnTouchUp(GestureState& state, const GestureFrame& frame, std::chrono::steady_clock::time_point now,
+                       GestureOutput& output) const;
+        static void CancelGesture(GestureState& state, bool left_button_down, GestureOutput& output);
+
+        GestureSettings settings_;
+    };
+}
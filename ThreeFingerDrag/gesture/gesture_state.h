@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+namespace Touchpad
+{
+    /**
+     * \brief The gesture state published by the input thread after every batch of reports or command.
+     */
+    struct GestureSnapshot
+    {
+        uint64_t sequence = 0; ///< Incremented on every publication.
+        bool gesture_started = false;
+        bool cancellation_started = false;
+        std::chrono::steady_clock::time_point last_event;
+        std::chrono::steady_clock::time_point cancellation_time;
+
+        // The delays of the settings the state was published with, so that timeouts are checked without them
+        std::chrono::milliseconds cancellation_delay{0};
+        std::chrono::milliseconds automatic_timeout_delay{0};
+    };
+
+    enum class GestureCommandType : uint8_t
+    {
+        CancelGesture
+    };
+
+    enum class CancelReason : uint8_t
+    {
+        AutomaticTimeout,
+        CancellationTimeout
+    };
+
+    /**
+     * \brief A request from another thread for the input thread to change the gesture state.
+     */
+    struct GestureCommand
+    {
+        GestureCommandType type;
+        CancelReason reason;
+        uint64_t sequence; ///< Sequence of the snapshot the request was based on. Stale requests are ignored.
+    };
+}
@@ -0,0 +1,61 @@
+#include "scan_time_clock.h"
+#include <algorithm>
+
+namespace Touchpad
+{
+    namespace
+    {
+        std::chrono::steady_clock::duration TicksToDuration(const uint64_t ticks)
+        {
+            return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                SCAN_TIME_UNIT * static_cast<int64_t>(ticks));
+        }
+    }
+
+    ScanTimeClock::time_point ScanTimeClock::Map(const uint32_t scan_time, const uint8_t bits,
+                                                 const time_point arrival_time)
+    {
+        if (!synced_ || arrival_time - last_arrival_ > SCAN_TIME_RESYNC_GAP)
+        {
+            last_scan_time_ = scan_time;
+            Resync(arrival_time);
+            return time_point(offset_ + TicksToDuration(ticks_));
+        }
+
+        const uint32_t mask = bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+        const uint32_t delta = (scan_time - last_scan_time_) & mask;
+        const auto device_elapsed = TicksToDuration(delta);
+        const auto host_elapsed = arrival_time - last_arrival_;
+        last_scan_time_ = scan_time;
+
+        // The device claims more time passed than the host saw, so the counter restarted or skipped
+        if (device_elapsed > host_elapsed + SCAN_TIME_MAX_SKEW)
+        {
+            Resync(arrival_time);
+            return time_point(offset_ + TicksToDuration(ticks_));
+        }
+
+        ticks_ += delta;
+        last_arrival_ = arrival_time;
+
+        // Track the smallest arrival latency, allowing it to grow slowly to follow clock drift
+        const auto sample_offset = arrival_time.time_since_epoch() - TicksToDuration(ticks_);
+        offset_ = std::min(offset_ + device_elapsed / SCAN_TIME_DRIFT_ALLOWANCE, sample_offset);
+
+        return time_point(offset_ + TicksToDuration(ticks_));
+    }
+
+    void ScanTimeClock::Reset()
+    {
+        synced_ = false;
+    }
+
+    void ScanTimeClock::Resync(const time_point arrival_time)
+    {
+        // Keep the tick count monotonic and move the anchor so that this frame maps to its arrival time
+        offset_ = arrival_time.time_since_epoch() - TicksToDuration(ticks_);
+        last_arrival_ = arrival_time;
+        synced_ = true;
+        resyncs_++;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+namespace Touchpad
+{
+    constexpr auto SCAN_TIME_UNIT = std::chrono::microseconds(100);
+    constexpr auto SCAN_TIME_RESYNC_GAP = std::chrono::milliseconds(500);
+    constexpr auto SCAN_TIME_MAX_SKEW = std::chrono::milliseconds(50);
+    constexpr auto SCAN_TIME_DRIFT_ALLOWANCE = 1000; // Device time may run 1/1000 slower than the host clock
+
+    /**
+     * \brief Maps the Scan Time counter of a touchpad onto the host steady clock.
+     *
+     * The counter counts in 100 microsecond units and wraps at its field width. It is unwrapped to a monotonic
+     * 64-bit tick count, which is mapped onto the host clock through the smallest observed arrival latency, so a
+     * frame is never timestamped later than it arrived. The mapping follows slow drift between the two clocks and
+     * is re-anchored on the arrival time after long gaps or when the counter jumps, for example when the device
+     * restarts it on a new touch.
+     */
+    class ScanTimeClock
+    {
+    public:
+        using time_point = std::chrono::steady_clock::time_point;
+
+        /**
+         * \brief Returns the time a frame was sampled by the device, on the host clock.
+         * \param scan_time The raw Scan Time counter of the frame.
+         * \param bits Width of the Scan Time field, at most 32.
+         * \param arrival_time Host time the frame was received.
+         */
+        time_point Map(uint32_t scan_time, uint8_t bits, time_point arrival_time);
+
+        /**
+         * \brief Forgets the current mapping, so that the next frame re-anchors the timeline.
+         */
+        void Reset();
+
+        /**
+         * \brief Returns the unwrapped counter of the last frame.
+         */
+        uint64_t Ticks() const { return ticks_; }
+
+        /**
+         * \brief Returns the number of times the timeline was re-anchored on the arrival time.
+         */
+        uint32_t Resyncs() const { return resyncs_; }
+
+    private:
+        void Resync(time_point arrival_time);
+
+        bool synced_ = false;
+        uint32_t last_scan_time_ = 0;
+        uint64_t ticks_ = 0;
+        uint32_t resyncs_ = 0;
+        time_point last_arrival_;
+        std::chrono::steady_clock::duration offset_{}; ///< Host time corresponding to tick zero.
+    };
+}
@@ -0,0 +1,127 @@
+#include "timeout_scheduler.h"
+#include <algorithm>
+
+namespace Touchpad
+{
+    TimeoutScheduler::TimeoutScheduler(TimeoutHandler handler, GestureClock& clock)
+        : handler_(std::move(handler)), clock_(clock)
+    {
+        for (auto& deadline : deadlines_)
+            deadline.store(DISARMED);
+    }
+
+    TimeoutScheduler::~TimeoutScheduler()
+    {
+        Stop();
+    }
+
+    void TimeoutScheduler::Arm(const TimeoutKind kind, const time_point deadline)
+    {
+        const rep value = deadline.time_since_epoch().count();
+        deadlines_[static_cast<size_t>(kind)].store(value);
+
+        // Only wake the thread if it would otherwise sleep past the new deadline
+        if (value < waiting_until_.load())
+        {
+            {
+                std::lock_guard lock(mutex_);
+                changed_ = true;
+            }
+            condition_.notify_one();
+        }
+    }
+
+    void TimeoutScheduler::Disarm(const TimeoutKind kind)
+    {
+        deadlines_[static_cast<size_t>(kind)].store(DISARMED);
+    }
+
+    TimeoutScheduler::time_point TimeoutScheduler::Deadline(const TimeoutKind kind) const
+    {
+        const rep value = deadlines_[static_cast<size_t>(kind)].load();
+        return value == DISARMED ? time_point::max() : time_point(std::chrono::steady_clock::duration(value));
+    }
+
+    TimeoutScheduler::time_point TimeoutScheduler::RunExpired()
+    {
+        const time_point now = clock_.Now();
+        const rep now_value = now.time_since_epoch().count();
+
+        for (size_t i = 0; i < deadlines_.size(); i++)
+        {
+            rep deadline = deadlines_[i].load();
+            if (deadline > now_value)
+                continue;
+
+            // Skip the handler if the deadline was rearmed in the meantime
+            if (deadlines_[i].compare_exchange_strong(deadline, DISARMED))
+                handler_(static_cast<TimeoutKind>(i), now);
+        }
+
+        const rep earliest = EarliestDeadline();
+        return earliest == DISARMED ? time_point::max() : time_point(std::chrono::steady_clock::duration(earliest));
+    }
+
+    void TimeoutScheduler::Start()
+    {
+        if (thread_.joinable())
+            return;
+
+        stopping_ = false;
+        thread_ = std::thread(&TimeoutScheduler::Run, this);
+    }
+
+    void TimeoutScheduler::Stop()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_one();
+
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    TimeoutScheduler::rep TimeoutScheduler::EarliestDeadline() const
+    {
+        rep earliest = DISARMED;
+        for (const auto& deadline : deadlines_)
+            earliest = std::min(earliest, deadline.load());
+        return earliest;
+    }
+
+    void TimeoutScheduler::Run()
+    {
+        std::unique_lock lock(mutex_);
+        while (!stopping_)
+        {
+            lock.unlock();
+            RunExpired();
+            lock.lock();
+
+            if (stopping_)
+                break;
+
+            // Publish the deadline being waited for, then check that no earlier one was armed while doing so. Arm
+            // stores its deadline before reading waiting_until_, so either it notifies or this check sees it.
+            changed_ = false;
+            rep earliest;
+            do
+            {
+                earliest = EarliestDeadline();
+                waiting_until_.store(earliest);
+            }
+            while (EarliestDeadline() != earliest);
+
+            const auto woken = [this] { return changed_ || stopping_; };
+            if (earliest == DISARMED)
+                condition_.wait(lock, woken);
+            else
+                clock_.WaitUntil(lock, condition_, time_point(std::chrono::steady_clock::duration(earliest)), woken);
+
+            wakeups_.fetch_add(1, std::memory_order_relaxed);
+        }
+        waiting_until_.store(DISARMED);
+    }
+}
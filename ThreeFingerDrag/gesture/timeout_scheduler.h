@@ -0,0 +1,109 @@
+#pragma once
+#include "gesture_clock.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Touchpad
+{
+    /**
+     * \brief The gesture timeouts that can be armed.
+     */
+    enum class TimeoutKind : uint8_t
+    {
+        Cancellation, ///< The cancellation delay after the fingers were lifted.
+        Automatic, ///< The automatic timeout after the last touch event of a drag.
+        Inactivity, ///< The cancellation delay after the last touch event of a drag, while no cancellation is pending.
+    };
+
+    constexpr auto TIMEOUT_KIND_COUNT = 3;
+
+    /**
+     * \brief Runs timeout handlers at their deadlines on a background thread, which sleeps until the earliest armed
+     * deadline and blocks indefinitely while none is armed.
+     *
+     * Deadlines can be armed and disarmed from any thread. The thread is only woken when a deadline moves earlier
+     * than the one it is waiting for; a deadline moved later is picked up when the thread wakes for the old one.
+     * A deadline is disarmed before its handler runs.
+     */
+    class TimeoutScheduler
+    {
+    public:
+        using time_point = std::chrono::steady_clock::time_point;
+        using TimeoutHandler = std::function<void(TimeoutKind kind, time_point now)>;
+
+        /**
+         * \brief Constructs a stopped scheduler.
+         * \param handler Called on the scheduler thread when a deadline expires.
+         * \param clock The clock that deadlines are measured on. With a VirtualClock, the scheduler thread runs the
+         * expired timeouts whenever the clock is advanced past them, and RunExpired can be driven directly.
+         */
+        explicit TimeoutScheduler(TimeoutHandler handler, GestureClock& clock = SteadyClock::Instance());
+        ~TimeoutScheduler();
+
+        TimeoutScheduler(const TimeoutScheduler& other) = delete;
+        TimeoutScheduler& operator=(const TimeoutScheduler& other) = delete;
+
+        /**
+         * \brief Sets the deadline of a timeout, replacing any deadline it already had.
+         */
+        void Arm(TimeoutKind kind, time_point deadline);
+
+        /**
+         * \brief Clears the deadline of a timeout.
+         */
+        void Disarm(TimeoutKind kind);
+
+        /**
+         * \brief Returns the deadline of a timeout, or time_point::max() if it is not armed.
+         */
+        time_point Deadline(TimeoutKind kind) const;
+
+        /**
+         * \brief Runs the handlers of all expired timeouts on the calling thread.
+         * \return The earliest deadline still armed, or time_point::max() if none is.
+         */
+        time_point RunExpired();
+
+        /**
+         * \brief Starts the scheduler thread. Its waits use the clock of the scheduler.
+         */
+        void Start();
+
+        /**
+         * \brief Stops and joins the scheduler thread.
+         */
+        void Stop();
+
+        /**
+         * \brief Returns the number of times the scheduler thread has woken up.
+         */
+        uint64_t Wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
+    private:
+        using rep = std::chrono::steady_clock::duration::rep;
+
+        static constexpr rep DISARMED = INT64_MAX;
+
+        rep EarliestDeadline() const;
+        void Run();
+
+        std::array<std::atomic<rep>, TIMEOUT_KIND_COUNT> deadlines_;
+        std::atomic<rep> waiting_until_{DISARMED};
+        std::atomic<uint64_t> wakeups_{0};
+
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool changed_ = false;
+        bool stopping_ = false;
+        std::thread thread_;
+
+        TimeoutHandler handler_;
+        GestureClock& clock_;
+    };
+}
@@ -1,46 +1,290 @@
 #include "touch_processor.h"
-#include <future>
-#include <sstream>
+#ifdef _WIN32
+#include "../hid/raw_input_device_cache.h"
+#include "../mouse/send_input_sink.h"
+#endif
+#include <ostream>
 
 namespace Touchpad
 {
-    TouchProcessor::TouchProcessor()
+    namespace
     {
-        config = GlobalConfig::GetInstance();
+        /**
+         * \brief Debug details of a received frame, formatted on the log thread.
+         */
+        struct FrameLogEntry
+        {
+            float interval_ms;
+            bool has_scan_time;
+            uint64_t scan_ticks;
+            TouchFrame contacts;
+        };
+
+        /**
+         * \brief Debug details of a gesture step, formatted on the log thread.
+         */
+        struct GestureStepLogEntry
+        {
+            bool touch_up_event;
+            float interval_ms;
+            TouchFrame contacts;
+        };
+
+        void WriteContacts(const TouchFrame& data, std::ostream& out)
+        {
+            out << "Contacts: (size = " << data.Size() << ")\n";
+            for (const auto& contact : data)
+            {
+                out << "[ID: " << contact.contact_id
+                    << ", X: " << contact.x
+                    << ", Y: " << contact.y
+                    << ", On Surface: " << (contact.on_surface ? "Yes" : "No") << "]";
+                if (contact.has_x_bounds)
+                    out << ", X Boundary: (min=" << contact.minimum_x << ", max=" << contact.maximum_x << ")";
+                if (contact.has_y_bounds)
+                    out << ", Y Boundary: (min=" << contact.minimum_y << ", max=" << contact.maximum_y << ")";
+                out << "\n";
+            }
+        }
 
-        touch_activity_event_.AddListener(std::bind(
-            &EventListeners::TouchActivityListener::OnTouchActivity,
-            &activity_listener_,
-            std::placeholders::_1));
+        void WriteFrameLogEntry(const FrameLogEntry& entry, std::ostream& out)
+        {
+            out << "[RAW REPORTED DATA]\n\n";
+            out << "Interval: " << std::to_string(entry.interval_ms) << "ms\n";
+            if (entry.has_scan_time)
+                out << "Scan time: " << entry.scan_ticks << " (x100us)\n";
+            WriteContacts(entry.contacts, out);
+        }
 
-        touch_up_event_.AddListener(std::bind(
-            &EventListeners::TouchUpListener::OnTouchUp,
-            &touch_up_listener_,
-            std::placeholders::_1));
+        void WriteGestureStepLogEntry(const GestureStepLogEntry& entry, std::ostream& out)
+        {
+            out << "[GESTURE STEP]\n\n";
+            out << "TYPE: " << (entry.touch_up_event ? "TouchUpEvent" : "TouchActivityEvent") << "\n";
+            out << "Interval: " << std::to_string(entry.interval_ms) << "ms\n";
+            WriteContacts(entry.contacts, out);
+        }
+    }
+
+#ifdef _WIN32
+    TouchProcessor::TouchProcessor()
+        : TouchProcessor(std::make_unique<RawInputDeviceCache>(), std::make_unique<SendInputSink>())
+    {
+    }
+#endif
+
+    TouchProcessor::TouchProcessor(std::unique_ptr<DeviceCache> device_cache, std::unique_ptr<OutputSink> output_sink)
+        : device_cache_(std::move(device_cache)), output_sink_(std::move(output_sink)),
+          settings_reader_(GlobalConfig::GetInstance()->Snapshots())
+    {
+        batch_.reserve(RAW_INPUT_BATCH_CAPACITY);
     }
 
     void TouchProcessor::ClearContacts()
     {
-        parsed_contacts_.clear();
+        contact_tracker_.Clear();
+    }
+
+    GestureSnapshot TouchProcessor::ReadGestureState() const
+    {
+        return published_state_.Load();
+    }
+
+    bool TouchProcessor::PostCommand(const GestureCommand& command)
+    {
+        return commands_.TryPush(command);
+    }
+
+    bool TouchProcessor::CheckTimeout(const TimeoutKind kind, const std::chrono::steady_clock::time_point now,
+                                      GestureCommand& command) const
+    {
+        const GestureSnapshot state = ReadGestureState();
+
+        bool cancel = false;
+        command = {GestureCommandType::CancelGesture, CancelReason::AutomaticTimeout, state.sequence};
+        switch (kind)
+        {
+        case TimeoutKind::Cancellation: // Cancellation timeout started by user
+            cancel = state.cancellation_started &&
+                now >= state.cancellation_time + state.cancellation_delay;
+            command.reason = CancelReason::CancellationTimeout;
+            break;
+        case TimeoutKind::Automatic: // Automatic gesture timeout (failsafe)
+            cancel = state.gesture_started && !state.cancellation_started && IsLeftButtonDown() &&
+                now >= state.last_event + state.automatic_timeout_delay;
+            break;
+        case TimeoutKind::Inactivity: // No touch event for the cancellation delay while dragging
+            cancel = state.gesture_started && !state.cancellation_started && IsLeftButtonDown() &&
+                now >= state.last_event + state.cancellation_delay;
+            break;
+        }
+        return cancel;
     }
 
+    void TouchProcessor::ProcessCommands()
+    {
+        LoadSettings();
+        const bool log_debug = settings_->log_debug;
+
+        GestureCommand command;
+        while (commands_.TryPop(command))
+        {
+            // The state changed after the command was issued, so its decision may no longer hold
+            if (command.sequence != state_sequence_)
+            {
+                if (log_debug)
+                    DEBUG("Ignored stale gesture command.");
+                continue;
+            }
+
+            switch (command.type)
+            {
+            case GestureCommandType::CancelGesture:
+                gesture_state_ = gesture_engine_.Cancel(gesture_state_, IsLeftButtonDown(), gesture_output_);
+                FlushOutput(gesture_output_);
+                ClearContacts();
+                if (trace_writer_ != nullptr)
+                    trace_writer_->WriteCancel(clock_->Now(), command.reason);
+                if (flight_recorder_ != nullptr)
+                {
+                    const auto now = clock_->Now();
+                    flight_recorder_->RecordCancel(now, command.reason);
+
+                    FlightDumpReason anomaly;
+                    if (anomaly_detector_.CheckAfterStep(gesture_state_, gesture_output_, now, anomaly))
+                        ReportAnomaly(anomaly);
+                }
+                if (trace_writer_ == nullptr && log_debug)
+                {
+                    if (command.reason == CancelReason::CancellationTimeout)
+                        DEBUG("Cancelled gesture (cancellation timeout).");
+                    else
+                        DEBUG("Cancelled gesture (automatic timeout).");
+                }
+                break;
+            }
+
+            PublishGestureState();
+        }
+
+        settings_reader_.Quiescent();
+    }
+
+    void TouchProcessor::PublishGestureState()
+    {
+        GestureSnapshot snapshot;
+        snapshot.sequence = ++state_sequence_;
+        snapshot.gesture_started = gesture_state_.gesture_started;
+        snapshot.cancellation_started = gesture_state_.cancellation_started;
+        snapshot.last_event = gesture_state_.last_event;
+        snapshot.cancellation_time = gesture_state_.cancellation_time;
+        snapshot.cancellation_delay = std::chrono::milliseconds(settings_->cancellation_delay_ms);
+        snapshot.automatic_timeout_delay = std::chrono::milliseconds(settings_->automatic_timeout_delay_ms);
+        published_state_.Store(snapshot);
+        ArmTimeouts(snapshot);
+    }
+
+    bool TouchProcessor::IsLeftButtonDown() const
+    {
+        return output_sink_->Buttons().IsLeftDown();
+    }
+
+    void TouchProcessor::SetButtonReconciler(const ButtonQuery button_query)
+    {
+        button_query_ = button_query;
+    }
+
+    void TouchProcessor::ReconcileButtonState(const std::chrono::steady_clock::time_point now)
+    {
+        if (button_query_ == nullptr ||
+            now - last_button_reconcile_ < std::chrono::milliseconds(BUTTON_RECONCILE_INTERVAL_MS))
+            return;
+
+        last_button_reconcile_ = now;
+
+        // The system may not have applied button events injected during the last interval yet
+        ButtonState& buttons = output_sink_->Buttons();
+        const uint64_t changes = buttons.Changes();
+        const bool settled = changes == reconciled_button_changes_;
+        reconciled_button_changes_ = changes;
+
+        if (settled && buttons.Reconcile(button_query_()) && settings_->log_debug)
+            DEBUG("Left mouse button state was changed outside of the gesture.");
+    }
+
+    void TouchProcessor::SetCaptureWriter(CaptureWriter* capture_writer)
+    {
+        capture_writer_ = capture_writer;
+    }
+
+    void TouchProcessor::SetTraceWriter(TraceWriter* trace_writer)
+    {
+        trace_writer_ = trace_writer;
+    }
+
+    void TouchProcessor::SetFlightRecorder(FlightRecorder* flight_recorder)
+    {
+        flight_recorder_ = flight_recorder;
+    }
+
+    void TouchProcessor::SetTimeoutScheduler(TimeoutScheduler* timeout_scheduler)
+    {
+        timeout_scheduler_ = timeout_scheduler;
+    }
+
+    void TouchProcessor::SetClock(GestureClock* clock)
+    {
+        clock_ = clock != nullptr ? clock : &SteadyClock::Instance();
+    }
+
+    void TouchProcessor::ArmTimeouts(const GestureSnapshot& snapshot) const
+    {
+        if (timeout_scheduler_ == nullptr)
+            return;
+
+        // The cancellation started by lifting the fingers also covers the automatic and inactivity timeouts, as all
+        // are measured from the touch up event.
+        if (snapshot.cancellation_started)
+        {
+            timeout_scheduler_->Arm(TimeoutKind::Cancellation,
+                                    snapshot.cancellation_time + snapshot.cancellation_delay);
+            timeout_scheduler_->Disarm(TimeoutKind::Automatic);
+            timeout_scheduler_->Disarm(TimeoutKind::Inactivity);
+        }
+        else if (snapshot.gesture_started)
+        {
+            timeout_scheduler_->Disarm(TimeoutKind::Cancellation);
+            timeout_scheduler_->Arm(TimeoutKind::Automatic, snapshot.last_event + snapshot.automatic_timeout_delay);
+            timeout_scheduler_->Arm(TimeoutKind::Inactivity, snapshot.last_event + snapshot.cancellation_delay);
+        }
+        else
+        {
+            timeout_scheduler_->Disarm(TimeoutKind::Cancellation);
+            timeout_scheduler_->Disarm(TimeoutKind::Automatic);
+            timeout_scheduler_->Disarm(TimeoutKind::Inactivity);
+        }
+    }
+
+    void TouchProcessor::RemoveDevice(const DeviceHandle device)
+    {
+        device_cache_->Remove(device);
+        if (capture_writer_ != nullptr)
+            capture_writer_->WriteDeviceRemoved(device);
+        device_streams_.erase(device);
+    }
+
+#ifdef _WIN32
     /**
      * \brief Retrieves touchpad input data from a raw input handle.
      * \param hRawInputHandle Handle to the raw input.
-     * \return A struct containing the touchpad input data.
      */
     void TouchProcessor::ProcessRawInput(const HRAWINPUT hRawInputHandle)
     {
-        const bool log_debug = config->LogDebug();
-
-        // Initialize touchpad input data struct with default values.
-        TouchInputData data{};
+        LoadSettings();
+        const bool log_debug = settings_->log_debug;
+        receive_start_ = LatencyStamp();
 
         // Initialize variable to hold size of raw input.
-        UINT size = sizeof(RAWINPUT);
-
-        // Get process heap handle.
-        const HANDLE hHeap = GetProcessHeap();
+        UINT size = 0;
 
         // Get size of raw input data.
         GetRawInputData(hRawInputHandle, RID_INPUT, nullptr, &size, sizeof(RAWINPUTHEADER));
@@ -49,332 +293,331 @@ namespace Touchpad
         {
             if (log_debug)
                 DEBUG("No data present.");
+            settings_reader_.Quiescent();
             return;
         }
 
-        // Allocate memory for raw input data.
-        auto* raw_input = static_cast<RAWINPUT*>(HeapAlloc(hHeap, 0, size));
+        // Reuse the raw input buffer between reports, only growing it when a larger report arrives.
+        if (raw_input_buffer_.size() < size)
+            raw_input_buffer_.resize(size);
 
-        if (raw_input == nullptr)
-            return;
+        auto* raw_input = reinterpret_cast<RAWINPUT*>(raw_input_buffer_.data());
 
         // Get raw input data.
         if (GetRawInputData(hRawInputHandle, RID_INPUT, raw_input, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-
             1))
         {
-            HeapFree(hHeap, 0, raw_input);
             ERROR("Could not retrieve raw input data from the HID device.");
+            settings_reader_.Quiescent();
             return;
         }
 
-        // Get size of pre-parsed data buffer.
-        UINT buffer_size;
-        GetRawInputDeviceInfo(raw_input->header.hDevice, RIDI_PREPARSEDDATA, nullptr, &buffer_size);
+        const auto arrival_time = clock_->Now();
 
-        if (buffer_size == 0)
-        {
-            HeapFree(hHeap, 0, raw_input);
-            ERROR("Could not retrieve pre-parsed data buffer from the HID device.");
-            return;
-        }
+        batch_.clear();
+        AppendRawInput(raw_input, arrival_time);
+        DrainRawInputBuffer(arrival_time);
 
-        // Allocate memory for pre-parsed data buffer.
-        const auto pre_parsed_data = static_cast<PHIDP_PREPARSED_DATA>(HeapAlloc(hHeap, 0, buffer_size));
+        // Leaves the settings quiescent once the batch is processed
+        ProcessReports(batch_.data(), batch_.size());
+    }
 
-        // Get pre-parsed data buffer.
-        GetRawInputDeviceInfo(raw_input->header.hDevice, RIDI_PREPARSEDDATA, pre_parsed_data, &buffer_size);
+    void TouchProcessor::AppendRawInput(const RAWINPUT* raw_input, const std::chrono::steady_clock::time_point arrival_time)
+    {
+        if (raw_input->header.dwType != RIM_TYPEHID)
+            return;
 
-        // Get capabilities of HID device.
-        HIDP_CAPS caps;
-        if (HidP_GetCaps(pre_parsed_data, &caps) != HIDP_STATUS_SUCCESS)
+        // A single raw input may carry several reports of the same size
+        const RAWHID& hid = raw_input->data.hid;
+        for (DWORD i = 0; i < hid.dwCount; i++)
         {
-            HeapFree(hHeap, 0, raw_input);
-            HeapFree(hHeap, 0, pre_parsed_data);
-            ERROR("Could not retrieve capabilities from the HID device.");
-            return;
+            batch_.push_back({
+                reinterpret_cast<DeviceHandle>(raw_input->header.hDevice),
+                hid.bRawData + static_cast<size_t>(i) * hid.dwSizeHid,
+                hid.dwSizeHid,
+                arrival_time
+            });
         }
+    }
 
-        // Get number of input value caps.
-        USHORT length = caps.NumberInputValueCaps;
+    void TouchProcessor::DrainRawInputBuffer(const std::chrono::steady_clock::time_point arrival_time)
+    {
+        UINT size = 0;
+        if (GetRawInputBuffer(nullptr, &size, sizeof(RAWINPUTHEADER)) != 0 || size == 0)
+            return;
+
+        // The returned size covers a single input, so make room for several queued inputs per call.
+        size *= RAW_INPUT_BATCH_CAPACITY;
+        if (raw_input_batch_buffer_.size() < size)
+            raw_input_batch_buffer_.resize(size);
 
-        // Allocate memory for input value caps.
-        const auto value_caps = static_cast<PHIDP_VALUE_CAPS>(HeapAlloc(hHeap, 0, sizeof(HIDP_VALUE_CAPS) * length));
+        auto* raw_input = reinterpret_cast<RAWINPUT*>(raw_input_batch_buffer_.data());
+        const UINT count = GetRawInputBuffer(raw_input, &size, sizeof(RAWINPUTHEADER));
 
-        // Get input value caps.
-        if (HidP_GetValueCaps(HidP_Input, value_caps, &length, pre_parsed_data) != HIDP_STATUS_SUCCESS)
+        if (count == static_cast<UINT>(-1))
         {
-            HeapFree(hHeap, 0, raw_input);
-            HeapFree(hHeap, 0, pre_parsed_data);
-            HeapFree(hHeap, 0, value_caps);
-            ERROR("Could not retrieve input value caps from the HID device.");
+            ERROR("Could not retrieve buffered raw input data.");
             return;
         }
 
-        if (log_debug)
-            DEBUG("Data Length = " + std::to_string(length));
+        for (UINT i = 0; i < count; i++)
+        {
+            AppendRawInput(raw_input, arrival_time);
+            raw_input = NEXTRAWINPUTBLOCK(raw_input);
+        }
+    }
+#endif
 
-        // Initialize vector to hold touchpad contact data.
-        std::vector<TouchContact> received_contacts;
+    void TouchProcessor::ProcessReport(const DeviceHandle device, const uint8_t* report, const size_t size,
+                                       const std::chrono::steady_clock::time_point arrival_time)
+    {
+        const RawReport raw_report{device, report, size, arrival_time};
+        ProcessReports(&raw_report, 1);
+    }
+
+    void TouchProcessor::ProcessReports(const RawReport* reports, const size_t count)
+    {
+        LoadSettings();
+
+        if (count > 0)
+            ReconcileButtonState(reports[count - 1].arrival_time);
+
+        // Batches that did not come from ProcessRawInput start here
+        uint64_t stamp = LatencyStamp();
+        batch_start_ = receive_start_ != 0 ? receive_start_ : stamp;
+        if (receive_start_ != 0)
+            RecordLatency(Metrics::LatencyStage::Receive, receive_start_, stamp);
+        receive_start_ = 0;
 
-        // Loop through input value caps and retrieve touchpad data.
-        ULONG value;
-        TouchContact parsed_contact{INIT_VALUE, INIT_VALUE, INIT_VALUE, false};
-        for (USHORT i = 0; i < length; i++)
+        bool has_pending_frame = false;
+        int pending_surface_count = 0;
+        std::chrono::steady_clock::time_point pending_time;
+
+        for (size_t i = 0; i < count; i++)
         {
-            auto current_cap = value_caps[i];
-            if (HidP_GetUsageValue(
-                HidP_Input,
-                current_cap.UsagePage,
-                current_cap.LinkCollection,
-                current_cap.NotRange.Usage,
-                &value,
-                pre_parsed_data,
-                (PCHAR)raw_input->data.hid.bRawData,
-                raw_input->data.hid.dwSizeHid
-            ) != HIDP_STATUS_SUCCESS)
-            {
+            std::chrono::steady_clock::time_point frame_time;
+            const bool assembled = AssembleFrame(reports[i], frame_time);
+
+            const uint64_t decoded = LatencyStamp();
+            RecordLatency(Metrics::LatencyStage::Decode, stamp, decoded);
+            stamp = decoded;
+
+            if (!assembled)
                 continue;
-            }
 
-            const USAGE usage_page = current_cap.UsagePage;
-            const USAGE usage = current_cap.Range.UsageMin;
-            switch (current_cap.LinkCollection)
+            // Raise the events of the frames so far before the number of contacts on the surface changes, so
+            // that touch up and finger count transitions are seen in order.
+            const int surface_count = received_frame_.contacts.CountOnSurface();
+            if (has_pending_frame && surface_count != pending_surface_count)
             {
-            default:
-                switch (usage_page)
-                {
-                case HID_USAGE_PAGE_GENERIC:
-                    if (current_cap.NotRange.Usage == HID_USAGE_GENERIC_X)
-                    {
-                        parsed_contact.minimum_x = current_cap.LogicalMin;
-                        parsed_contact.maximum_x = current_cap.LogicalMax;
-                        parsed_contact.has_x_bounds = true;
-                    }
-                    else if (current_cap.NotRange.Usage == HID_USAGE_GENERIC_Y)
-                    {
-                        parsed_contact.minimum_y = current_cap.LogicalMin;
-                        parsed_contact.maximum_y = current_cap.LogicalMax;
-                        parsed_contact.has_y_bounds = true;
-                    }
-                    switch (usage)
-                    {
-                    case USAGE_DIGITIZER_X_COORDINATE:
-                        parsed_contact.x = static_cast<int>(value);
-                        break;
-                    case USAGE_DIGITIZER_Y_COORDINATE:
-                        parsed_contact.y = static_cast<int>(value);
-                        break;
-                    default: break;
-                    }
-                    break;
-                case HID_USAGE_PAGE_DIGITIZER:
-                    if (usage == USAGE_DIGITIZER_CONTACT_ID)
-                        parsed_contact.contact_id = static_cast<int>(value);
-                    break;
-                default: break;
-                }
-                break;
+                StepGesture(pending_time);
+                stamp = LatencyStamp();
             }
 
-            // If all contact fields are populated, add contact to list and reset fields.
-            if (parsed_contact.contact_id != INIT_VALUE && parsed_contact.x != INIT_VALUE && parsed_contact.y !=
-                INIT_VALUE)
-            {
-                const ULONG maxNumButtons =
-                    HidP_MaxUsageListLength(HidP_Input, HID_USAGE_PAGE_DIGITIZER, pre_parsed_data);
-                USAGE* buttonUsageArray = (USAGE*)malloc(sizeof(USAGE) * maxNumButtons);
-                ULONG _maxNumButtons = maxNumButtons;
-
-                if (HidP_GetUsages(
-                    HidP_Input,
-                    HID_USAGE_PAGE_DIGITIZER,
-                    current_cap.LinkCollection,
-                    buttonUsageArray,
-                    &_maxNumButtons,
-                    pre_parsed_data,
-                    (PCHAR)raw_input->data.hid.bRawData,
-                    raw_input->data.hid.dwSizeHid) == HIDP_STATUS_SUCCESS)
-                {
-                    for (ULONG usageIdx = 0; usageIdx < maxNumButtons; usageIdx++)
-                    {
-                        // Determine if this contact point is on the touchpad surface
-                        if (buttonUsageArray[usageIdx] == HID_USAGE_DIGITIZER_TIP_SWITCH)
-                        {
-                            parsed_contact.on_surface = true;
-                            break;
-                        }
-                    }
-
-                    free(buttonUsageArray);
-                }
+            // Positions are absolute, so merging consecutive frames folds their movement into one delta
+            UpdateTouchContactsState(received_frame_.contacts);
 
-                received_contacts.emplace_back(parsed_contact);
+            const uint64_t tracked = LatencyStamp();
+            RecordLatency(Metrics::LatencyStage::Track, stamp, tracked);
+            stamp = tracked;
 
-                parsed_contact = {INIT_VALUE, INIT_VALUE, INIT_VALUE, false};
-            }
+            has_pending_frame = true;
+            pending_surface_count = surface_count;
+            pending_time = frame_time;
         }
-        // Free allocated memory.
-        HeapFree(hHeap, 0, raw_input);
-        HeapFree(hHeap, 0, pre_parsed_data);
-        HeapFree(hHeap, 0, value_caps);
-
-        const auto interval = EventListeners::CalculateElapsedTimeMs(
-            config->GetLastEvent(), std::chrono::high_resolution_clock::now());
-
-        // Clear any old contact data if enough time has passed
-        if (interval > config->GetCancellationDelayMs())
-            ClearContacts();
 
-        if (log_debug)
+        if (has_pending_frame)
         {
-            std::ostringstream debug;
-            debug << "[RAW REPORTED DATA]\n\n";
-            debug << "Interval: " << std::to_string(interval) << "ms\n";
-            debug << DebugPoints(received_contacts);
-            DEBUG(debug.str());
+            StepGesture(pending_time);
+            PublishGestureState();
         }
 
-        UpdateTouchContactsState(received_contacts);
-        RaiseEventsIfNeeded();
+        // No reference to the settings is kept past the batch
+        settings_reader_.Quiescent();
     }
 
-    void TouchProcessor::UpdateTouchContactsState(const std::vector<TouchContact>& received_contacts)
+    bool TouchProcessor::AssembleFrame(const RawReport& report, std::chrono::steady_clock::time_point& frame_time)
     {
-        std::lock_guard lock(contacts_mutex_);
-        std::unordered_map<int, TouchContact> id_to_contact_map;
+        const bool log_debug = settings_->log_debug;
 
-        for (const auto& contact : parsed_contacts_)
+        // Look up the report layout of the device, which is only compiled on its first report.
+        const DeviceInfo* device_info = device_cache_->Find(report.device);
+
+        if (device_info == nullptr)
+            return false;
+
+        const bool decoded = DecodeReport(device_info->layout, report.data, report.size, decoded_report_);
+
+        if (capture_writer_ != nullptr)
+            capture_writer_->WriteReport(report.device, *device_info, report.data, report.size,
+                                         report.arrival_time, decoded_report_.scan_time,
+                                         decoded_report_.scan_time_bits);
+
+        // Counted rather than logged, as a device may send them at its report rate
+        if (!decoded)
         {
-            id_to_contact_map[contact.contact_id] = contact;
+            unknown_reports_++;
+            return false;
         }
 
-        // Validate each received contact and filter out unwanted data
-        for (const auto& received_contact : received_contacts)
-        {
-            if (received_contact.contact_id > CONTACT_ID_MAXIMUM || received_contact.contact_id < 0)
-                continue;
+        // In hybrid mode a frame spans several reports; wait until all of its contacts have arrived.
+        DeviceStream& stream = device_streams_[report.device];
+        if (!stream.frame_assembler.Push(decoded_report_, received_frame_))
+            return false;
 
-            if (received_contact.x == 0 || received_contact.y == 0)
-                continue;
+        // Time the frame by when the device sampled it rather than when the message was handled.
+        frame_time = received_frame_.scan_time_bits > 0
+                         ? stream.scan_time_clock.Map(received_frame_.scan_time, received_frame_.scan_time_bits,
+                                                      report.arrival_time)
+                         : report.arrival_time;
 
-            if (received_contact.has_x_bounds)
-            {
-                const auto min_x = received_contact.minimum_x;
-                const auto max_x = received_contact.maximum_x;
-                if (!ValueWithinRange(received_contact.x, min_x, max_x))
-                    continue;
-            }
-            if (received_contact.has_y_bounds)
-            {
-                const auto min_y = received_contact.minimum_y;
-                const auto max_y = received_contact.maximum_y;
-                if (!ValueWithinRange(received_contact.y, min_y, max_y))
-                    continue;
-            }
-            id_to_contact_map[received_contact.contact_id] = received_contact;
-        }
+        // Measured from the previous frame rather than the last raised event, which lags behind within a batch
+        const auto interval = CalculateElapsedTimeMs(last_frame_time_, frame_time);
+        last_frame_time_ = frame_time;
 
-        parsed_contacts_.clear();
-        for (const auto& pair : id_to_contact_map)
+        // Clear any old contact data if enough time has passed
+        if (interval > settings_->cancellation_delay_ms)
+            ClearContacts();
+
+        // Only the values are copied here; the trace is decoded offline and the message formatted on the log thread
+        const bool has_scan_time = received_frame_.scan_time_bits > 0;
+        const uint64_t scan_ticks = stream.scan_time_clock.Ticks();
+        if (flight_recorder_ != nullptr)
+            flight_recorder_->RecordFrame(frame_time, has_scan_time, scan_ticks, received_frame_.contacts);
+        if (trace_writer_ != nullptr)
+            trace_writer_->WriteFrame(frame_time, has_scan_time, scan_ticks, received_frame_.contacts);
+        else if (log_debug)
         {
-            parsed_contacts_.push_back(pair.second);
+            const FrameLogEntry entry{interval, has_scan_time, scan_ticks, received_frame_.contacts};
+            DEBUG_DEFERRED(WriteFrameLogEntry, entry);
         }
 
-        std::sort(parsed_contacts_.begin(), parsed_contacts_.end(), [](const TouchContact& a, const TouchContact& b)
-        {
-            return a.contact_id < b.contact_id;
-        });
+        return true;
     }
 
-    void TouchProcessor::RaiseEventsIfNeeded()
+    void TouchProcessor::UpdateTouchContactsState(const TouchFrame& received_contacts)
     {
-        std::lock_guard lock(contacts_mutex_);
-        const int current_contact_count = CountTouchPointsMakingContact(parsed_contacts_);
-        const bool has_contact = current_contact_count > 0;
-        const auto time = std::chrono::high_resolution_clock::now();
+        contact_tracker_.Merge(received_contacts);
+    }
 
-        // Construct the TouchInputData object
-        TouchInputData touchInputData;
-        touchInputData.contacts = parsed_contacts_;
-        touchInputData.contact_count = parsed_contacts_.size();
-        touchInputData.can_perform_gesture = current_contact_count ==
-            EventListeners::NUM_TOUCH_CONTACTS_REQUIRED;
+    void TouchProcessor::StepGesture(const std::chrono::steady_clock::time_point time)
+    {
+        const int current_contact_count = contact_tracker_.CountOnSurface();
 
-        // Determine if a touch up event should be raised
-        const int previous_contact_count = CountTouchPointsMakingContact(config->GetPreviousTouchContacts());
-        const bool previous_has_contact = previous_contact_count > 0;
-        const bool touch_up_event = !has_contact && previous_has_contact || !has_contact && !previous_has_contact;
+        // Construct the frame seen by the gesture engine
+        GestureFrame frame;
+        contact_tracker_.Snapshot(frame.touch.contacts);
+        frame.touch.contact_count = contact_tracker_.Size();
+        frame.touch.can_perform_gesture = current_contact_count == NUM_TOUCH_CONTACTS_REQUIRED;
+        frame.left_button_down = IsLeftButtonDown();
 
-        if (touch_up_event)
-        {
-            touch_up_event_.RaiseEvent(TouchUpEventArgs(time, &touchInputData, config->GetPreviousTouchContacts()));
-        }
-        else if (has_contact)
+        // Optionally, log the event details for debugging
+        if (trace_writer_ == nullptr && settings_->log_debug)
+            LogEventDetails(current_contact_count == 0, time, frame.touch.contacts);
+
+        // Checked before the step, which moves the time of the last event
+        FlightDumpReason anomaly;
+        const bool stuck = flight_recorder_ != nullptr &&
+            anomaly_detector_.CheckBeforeStep(gesture_state_, frame.left_button_down, time, anomaly);
+
+        const uint64_t step_start = LatencyStamp();
+        gesture_state_ = gesture_engine_.Step(gesture_state_, frame, time, gesture_output_);
+        const uint64_t stepped = LatencyStamp();
+        RecordLatency(Metrics::LatencyStage::Gesture, step_start, stepped);
+
+        FlushOutput(gesture_output_);
+        if (gesture_output_.count > 0)
         {
-            touch_activity_event_.RaiseEvent(
-                TouchActivityEventArgs(time, &touchInputData, config->GetPreviousTouchContacts()));
+            const uint64_t flushed = LatencyStamp();
+            RecordLatency(Metrics::LatencyStage::Output, stepped, flushed);
+            RecordLatency(Metrics::LatencyStage::EndToEnd, batch_start_, flushed);
         }
 
-        // Optionally, log the event details for debugging
-        if (config->LogDebug())
+        TraceStep(time, current_contact_count);
+        if (flight_recorder_ != nullptr)
         {
-            LogEventDetails(touch_up_event, time);
+            if (stuck)
+                ReportAnomaly(anomaly);
+            if (anomaly_detector_.CheckAfterStep(gesture_state_, gesture_output_, time, anomaly))
+                ReportAnomaly(anomaly);
         }
 
-        config->SetPreviousTouchContacts(parsed_contacts_);
-        config->SetLastEvent(time);
+        contact_tracker_.RemoveLifted();
+    }
+
+    void TouchProcessor::TraceStep(const std::chrono::steady_clock::time_point time, const int surface_count) const
+    {
+        if (trace_writer_ == nullptr && flight_recorder_ == nullptr)
+            return;
 
-        const auto it = std::remove_if(parsed_contacts_.begin(), parsed_contacts_.end(),
-                                       [](const TouchContact& tc) { return !tc.on_surface; });
-        parsed_contacts_.erase(it, parsed_contacts_.end());
+        const auto event = surface_count == 0 ? TraceEventType::TouchUp : TraceEventType::TouchActivity;
+        const bool left_button_down = IsLeftButtonDown();
+        if (trace_writer_ != nullptr)
+            trace_writer_->WriteStep(time, event, surface_count, gesture_state_, left_button_down, gesture_output_);
+        if (flight_recorder_ != nullptr)
+            flight_recorder_->RecordStep(time, event, surface_count, gesture_state_, left_button_down, gesture_output_);
     }
 
-    void TouchProcessor::LogEventDetails(bool touch_up_event,
-                                         const std::chrono::high_resolution_clock::time_point& time) const
+    void TouchProcessor::ReportAnomaly(const FlightDumpReason reason) const
     {
-        std::stringstream debug;
-        debug << "[RAISED EVENT]\n\n";
-        debug << "TYPE: ";
-        if (touch_up_event)
-            debug << "TouchUpEvent";
+        const std::string anomaly = FlightRecorder::ReasonName(reason);
+        if (flight_recorder_->Dump(reason))
+            WARNING("Detected a " + anomaly + " anomaly, saved the recent touch events to '" +
+                flight_recorder_->DumpPath(reason) + "'.");
         else
-            debug << "TouchActivityEvent";
-        debug << "\n";
-        debug << "Interval: " << std::to_string(EventListeners::CalculateElapsedTimeMs(config->GetLastEvent(), time)) <<
-            "ms\n";
-        debug << DebugPoints(parsed_contacts_);
-        DEBUG(debug.str());
+            WARNING("Detected a " + anomaly + " anomaly, but could not save the recent touch events.");
     }
 
-    std::string TouchProcessor::DebugPoints(const std::vector<TouchContact>& data)
+    void TouchProcessor::SetLatencyMeasurement(const bool enabled)
     {
-        std::ostringstream oss;
-        oss << "Contacts: (size = " << data.size() << ")\n";
-        for (const auto& contact : data)
-        {
-            oss << "[ID: " << contact.contact_id
-                << ", X: " << contact.x
-                << ", Y: " << contact.y
-                << ", On Surface: " << (contact.on_surface ? "Yes" : "No") << "]";
-            if (contact.has_x_bounds)
-                oss << ", X Boundary: (min=" << contact.minimum_x << ", max=" << contact.maximum_x << ")";
-            if (contact.has_y_bounds)
-                oss << ", Y Boundary: (min=" << contact.minimum_y << ", max=" << contact.maximum_y << ")";
-            oss << "\n";
-        }
-        return oss.str();
+        measure_latency_ = enabled;
     }
 
-    int TouchProcessor::CountTouchPointsMakingContact(const std::vector<TouchContact>& points)
+    void TouchProcessor::RecordLatency(const Metrics::LatencyStage stage, const uint64_t start, const uint64_t end)
     {
-        return std::count_if(points.begin(), points.end(), [](const TouchContact& p)
-        {
-            return p.on_surface;
-        });
+        if (measure_latency_)
+            latency_.Record(stage, end - start);
+    }
+
+    void TouchProcessor::FlushOutput(const GestureOutput& output) const
+    {
+        // All commands of the step go out as a single batch
+        if (output.count > 0)
+            output_sink_->Send(output.commands.data(), output.count);
+
+        if (trace_writer_ != nullptr || !settings_->log_debug)
+            return;
+
+        if (output.transitions & TRANSITION_GESTURE_STARTED)
+            DEBUG("Started gesture.");
+        if (output.transitions & TRANSITION_CANCELLATION_STARTED)
+            DEBUG("Started gesture cancellation.");
+        if (output.transitions & TRANSITION_GESTURE_CANCELLED)
+            DEBUG("Cancelled gesture.");
     }
 
-    bool TouchProcessor::ValueWithinRange(const int value, const int minimum, const int maximum)
+    void TouchProcessor::LoadSettings()
+    {
+        settings_ = &settings_reader_.Load();
+        if (settings_->version == applied_settings_version_)
+            return;
+
+        GestureSettings settings;
+        settings.gesture_speed = settings_->gesture_speed;
+        settings.cancellation_delay_ms = settings_->cancellation_delay_ms;
+        settings.automatic_timeout_delay_ms = settings_->automatic_timeout_delay_ms;
+        settings.one_finger_transition_delay_ms = settings_->one_finger_transition_delay_ms;
+        gesture_engine_.SetSettings(settings);
+        applied_settings_version_ = settings_->version;
+    }
+
+    void TouchProcessor::LogEventDetails(bool touch_up_event,
+                                         const std::chrono::steady_clock::time_point& time,
+                                         const TouchFrame& contacts) const
     {
-        return value < maximum && value > minimum;
+        const GestureStepLogEntry entry{
+            touch_up_event, CalculateElapsedTimeMs(gesture_state_.last_event, time), contacts
+        };
+        DEBUG_DEFERRED(WriteGestureStepLogEntry, entry);
     }
 }
@@ -1,39 +1,203 @@
 #pragma once
+#ifdef _WIN32
 #include "../framework.h"
-#include "event_listeners.h"
+#endif
+#include "../config/globalconfig.h"
+#include "../logging/logger.h"
+#include "contact_tracker.h"
+#include "gesture_engine.h"
+#include "frame_assembler.h"
+#include "gesture_clock.h"
+#include "scan_time_clock.h"
+#include "gesture_state.h"
+#include "timeout_scheduler.h"
+#include "../hid/device_cache.h"
+#include "../capture/capture_writer.h"
+#include "../trace/anomaly_detector.h"
+#include "../trace/flight_recorder.h"
+#include "../trace/trace_writer.h"
+#include "../mouse/output_sink.h"
+#include "../metrics/pipeline_latency.h"
+#include "../sync/seqlock.h"
+#include "../sync/spsc_queue.h"
+#include <memory>
+#include <unordered_map>
 #include <vector>
-#include <mutex>
 
 namespace Touchpad
 {
-    constexpr auto INIT_VALUE = 65535;
-    constexpr auto CONTACT_ID_MAXIMUM = 64;
-    constexpr auto CONTACT_ID_MINIMUM = 0;
-    constexpr auto USAGE_PAGE_DIGITIZER_VALUES = 0x01;
-    constexpr auto USAGE_PAGE_DIGITIZER_INFO = 0x0D;
-    constexpr auto USAGE_DIGITIZER_SCAN_TIME = 0x56;
-    constexpr auto USAGE_DIGITIZER_CONTACT_COUNT = 0x54;
-    constexpr auto USAGE_DIGITIZER_CONTACT_ID = 0x51;
-    constexpr auto USAGE_DIGITIZER_X_COORDINATE = 0x30;
-    constexpr auto USAGE_DIGITIZER_Y_COORDINATE = 0x31;
+    constexpr auto RAW_INPUT_BATCH_CAPACITY = 32;
+    constexpr auto GESTURE_COMMAND_CAPACITY = 16;
+    constexpr auto BUTTON_RECONCILE_INTERVAL_MS = 250;
 
+    /**
+     * \brief A single HID input report waiting to be processed.
+     */
+    struct RawReport
+    {
+        DeviceHandle device;
+        const uint8_t* data; ///< The report bytes, starting with the report ID.
+        size_t size;
+        std::chrono::steady_clock::time_point arrival_time;
+    };
 
     /**
      * \brief Class that processes touch input data to enable three-finger drag functionality.
+     *
+     * All processing and all gesture state changes happen on the input thread. Other threads read the gesture
+     * state through ReadGestureState and request changes through PostCommand.
+     *
+     * Only the raw input entry point and the default devices are specific to Windows. Elsewhere, reports are fed
+     * through ProcessReports.
      */
     class TouchProcessor
     {
     public:
+#ifdef _WIN32
         TouchProcessor();
+#endif
 
         /**
-         * @brief Retrieves touch data from the given raw input handle.
+         * @brief Constructs a touch processor that looks up device descriptor data in the given cache.
+         * @param device_cache The cache of per-device HID data.
+         * @param output_sink Receives the mouse commands of the gesture.
+         */
+        TouchProcessor(std::unique_ptr<DeviceCache> device_cache, std::unique_ptr<OutputSink> output_sink);
+
+#ifdef _WIN32
+        /**
+         * @brief Retrieves touch data from the given raw input handle, together with any raw input still queued
+         * for the thread, and processes it as a single batch.
          * @param hRawInputHandle Handle to the raw input data.
-         * @return The retrieved touch data.
          */
         void ProcessRawInput(HRAWINPUT hRawInputHandle);
+#endif
+
+        /**
+         * @brief Decodes a batch of HID input reports in one pass. Movement within the batch is folded into a
+         * single activity event, while changes in the number of contacts on the surface, including touch up,
+         * raise their events in order.
+         * @param reports The reports, in the order they were received.
+         * @param count Number of reports.
+         */
+        void ProcessReports(const RawReport* reports, size_t count);
+
+        /**
+         * @brief Decodes a single HID input report of a touchpad device and raises any resulting touch events.
+         * @param device Handle of the device that sent the report.
+         * @param report The report bytes, starting with the report ID.
+         * @param size Size of the report in bytes.
+         * @param arrival_time Host time the report was received, used when the device does not send a scan time.
+         */
+        void ProcessReport(DeviceHandle device, const uint8_t* report, size_t size,
+                           std::chrono::steady_clock::time_point arrival_time);
+
+        /**
+         * @brief Forgets all tracked contacts. Must only be called from the input thread.
+         */
         void ClearContacts();
 
+        /**
+         * @brief Returns the most recently published gesture state. May be called from any thread.
+         */
+        GestureSnapshot ReadGestureState() const;
+
+        /**
+         * @brief Queues a command for the input thread, which runs it on its next call to ProcessCommands.
+         * Must only be called from a single thread other than the input thread.
+         * @return False if the command queue is full.
+         */
+        bool PostCommand(const GestureCommand& command);
+
+        /**
+         * @brief Checks whether an expired gesture timeout still applies to the published gesture state, which may
+         * have changed after the timeout was armed. May be called from any thread.
+         * @param kind The expired timeout.
+         * @param now The time the timeout expired at.
+         * @param command Receives the command to post if the gesture has to be cancelled.
+         * @return True if the gesture has to be cancelled.
+         */
+        bool CheckTimeout(TimeoutKind kind, std::chrono::steady_clock::time_point now,
+                          GestureCommand& command) const;
+
+        /**
+         * @brief Runs any queued commands that are still based on the current gesture state. Must only be called
+         * from the input thread.
+         */
+        void ProcessCommands();
+
+        /**
+         * @brief Returns true if the left mouse button is held down by the gesture. A single atomic load that may
+         * be called from any thread.
+         */
+        bool IsLeftButtonDown() const;
+
+        /**
+         * @brief Sets the query used to catch physical clicks that override the injected button state. The state
+         * is compared against it at most every BUTTON_RECONCILE_INTERVAL_MS, and only once no button change has
+         * been injected for a whole interval, so that our own events have been applied by the system.
+         * @param button_query The query, or nullptr to rely on the injected state alone.
+         */
+        void SetButtonReconciler(ButtonQuery button_query);
+
+        /**
+         * @brief Sets the scheduler whose gesture timeouts are rearmed every time the gesture state is published.
+         * @param timeout_scheduler The scheduler, or nullptr to stop arming timeouts.
+         */
+        void SetTimeoutScheduler(TimeoutScheduler* timeout_scheduler);
+
+        /**
+         * @brief Sets the clock that reports are stamped with on arrival and that cancellations are timed by. The
+         * gesture itself is timed by the arrival times of the reports.
+         * @param clock The clock, or nullptr to use the steady clock. Must only be changed on the input thread.
+         */
+        void SetClock(GestureClock* clock);
+
+        /**
+         * @brief Returns the latency histograms of the pipeline stages. May be read from any thread.
+         */
+        const Metrics::PipelineLatency& Latency() const { return latency_; }
+
+        /**
+         * @brief Turns the latency measurement of the pipeline stages on or off. It is on by default.
+         * Must only be called from the input thread.
+         */
+        void SetLatencyMeasurement(bool enabled);
+
+        /**
+         * @brief Returns the number of reports whose report ID is not part of the layout of their device. Must only be
+         * read from the input thread.
+         */
+        uint64_t UnknownReports() const { return unknown_reports_; }
+
+        /**
+         * @brief Sets the writer that every raw report is captured to, together with the layout of its device.
+         * @param capture_writer The writer, or nullptr to stop capturing. Must only be changed on the input thread.
+         */
+        void SetCaptureWriter(CaptureWriter* capture_writer);
+
+        /**
+         * @brief Sets the writer that the debug details of every frame, gesture step and cancellation are traced to.
+         * While a writer is set, these details are no longer written to the debug log.
+         * @param trace_writer The writer, or nullptr to stop tracing. Must only be changed on the input thread.
+         */
+        void SetTraceWriter(TraceWriter* trace_writer);
+
+        /**
+         * @brief Sets the recorder that keeps the last frames, gesture steps and cancellations in memory. While a
+         * recorder is set, the steps are also checked for anomalies, each of which dumps the recorder.
+         * @param flight_recorder The recorder, or nullptr to stop recording. Must only be changed on the input
+         * thread.
+         */
+        void SetFlightRecorder(FlightRecorder* flight_recorder);
+
+        /**
+         * @brief Drops any cached descriptor data of a device that has been removed from the system, together with
+         * the frame it was assembling and its scan time baseline. The state of other devices is kept.
+         * @param device Handle of the removed device.
+         */
+        void RemoveDevice(DeviceHandle device);
+
         TouchProcessor(const TouchProcessor& other) = delete; // Disallow copy constructor
         TouchProcessor(TouchProcessor&& other) noexcept = delete; // Disallow move constructor
         TouchProcessor& operator=(const TouchProcessor& other) = delete; // Disallow copy assignment
@@ -41,22 +205,69 @@ namespace Touchpad
         ~TouchProcessor() = default; // Default destructor
 
     private:
-        void UpdateTouchContactsState(const std::vector<TouchContact>& received_contacts);
-        void RaiseEventsIfNeeded();
-        void LogEventDetails(bool touch_up_event, const std::chrono::high_resolution_clock::time_point& time) const;
-        
-        static bool ValueWithinRange(int value, int minimum, int maximum);
-        static std::string DebugPoints(const std::vector<TouchContact>& data);
-        static int CountTouchPointsMakingContact(const std::vector<TouchContact>& points);
-
-        EventListeners::TouchActivityListener activity_listener_;
-        EventListeners::TouchUpListener touch_up_listener_;
-
-        Event<TouchActivityEventArgs> touch_activity_event_;
-        Event<TouchUpEventArgs> touch_up_event_;
-        std::vector<TouchContact> parsed_contacts_;
-        mutable std::mutex contacts_mutex_;
-
-        GlobalConfig* config;
+        /**
+         * \brief State that a touchpad carries from one of its reports to the next.
+         */
+        struct DeviceStream
+        {
+            FrameAssembler frame_assembler;
+            ScanTimeClock scan_time_clock;
+        };
+
+#ifdef _WIN32
+        void AppendRawInput(const RAWINPUT* raw_input, std::chrono::steady_clock::time_point arrival_time);
+        void DrainRawInputBuffer(std::chrono::steady_clock::time_point arrival_time);
+#endif
+        bool AssembleFrame(const RawReport& report, std::chrono::steady_clock::time_point& frame_time);
+        void UpdateTouchContactsState(const TouchFrame& received_contacts);
+        void StepGesture(std::chrono::steady_clock::time_point time);
+        void FlushOutput(const GestureOutput& output) const;
+        void LoadSettings();
+        void PublishGestureState();
+        void ReconcileButtonState(std::chrono::steady_clock::time_point now);
+        uint64_t LatencyStamp() const { return measure_latency_ ? Metrics::TickClock::Now() : 0; }
+        void RecordLatency(Metrics::LatencyStage stage, uint64_t start, uint64_t end);
+        void ArmTimeouts(const GestureSnapshot& snapshot) const;
+        void TraceStep(std::chrono::steady_clock::time_point time, int surface_count) const;
+        void ReportAnomaly(FlightDumpReason reason) const;
+        void LogEventDetails(bool touch_up_event, const std::chrono::steady_clock::time_point& time,
+                             const TouchFrame& contacts) const;
+
+        GestureEngine gesture_engine_;
+        GestureState gesture_state_;
+        GestureOutput gesture_output_;
+        ContactTracker contact_tracker_;
+        // Created on the first report of a device, so that other devices never join its frames or move its timeline
+        std::unordered_map<DeviceHandle, DeviceStream> device_streams_;
+        DecodedReport decoded_report_;
+        DecodedReport received_frame_;
+        uint64_t unknown_reports_ = 0;
+        std::chrono::steady_clock::time_point last_frame_time_;
+        std::unique_ptr<DeviceCache> device_cache_;
+        std::unique_ptr<OutputSink> output_sink_;
+        std::vector<uint8_t> raw_input_buffer_;
+        std::vector<uint8_t> raw_input_batch_buffer_;
+        std::vector<RawReport> batch_;
+        uint64_t state_sequence_ = 0;
+        Sync::SeqLock<GestureSnapshot> published_state_;
+        Sync::SpscQueue<GestureCommand, GESTURE_COMMAND_CAPACITY> commands_;
+        TimeoutScheduler* timeout_scheduler_ = nullptr;
+        GestureClock* clock_ = &SteadyClock::Instance();
+        CaptureWriter* capture_writer_ = nullptr;
+        TraceWriter* trace_writer_ = nullptr;
+        FlightRecorder* flight_recorder_ = nullptr;
+        AnomalyDetector anomaly_detector_;
+        Metrics::PipelineLatency latency_;
+        bool measure_latency_ = true;
+        uint64_t receive_start_ = 0;
+        uint64_t batch_start_ = 0;
+        ButtonQuery button_query_ = nullptr;
+        std::chrono::steady_clock::time_point last_button_reconcile_;
+        uint64_t reconciled_button_changes_ = 0;
+
+        // The settings are loaded at the start of every batch or command run and released at its end
+        GlobalConfig::SettingsReader settings_reader_;
+        const SettingsSnapshot* settings_ = nullptr;
+        uint64_t applied_settings_version_ = UINT64_MAX;
     };
 }
@@ -0,0 +1,27 @@
+#include "device_cache.h"
+
+namespace Touchpad
+{
+    void StaticDeviceCache::Insert(const DeviceHandle device, DeviceInfo info)
+    {
+        devices_[device] = std::move(info);
+    }
+
+    DeviceInfo* StaticDeviceCache::Find(const DeviceHandle device)
+    {
+        const auto it = devices_.find(device);
+        if (it == devices_.end())
+            return nullptr;
+        return &it->second;
+    }
+
+    void StaticDeviceCache::Remove(const DeviceHandle device)
+    {
+        devices_.erase(device);
+    }
+
+    void StaticDeviceCache::Clear()
+    {
+        devices_.clear();
+    }
+}
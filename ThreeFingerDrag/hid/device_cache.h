@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "report_layout.h"
+
+namespace Touchpad
+{
+    /**
+     * \brief Platform independent key for a touchpad device. On Windows this holds the raw input device handle.
+     */
+    using DeviceHandle = std::uintptr_t;
+
+    /**
+     * \brief What the descriptor bytes of a device hold.
+     */
+    enum class DescriptorFormat : uint8_t
+    {
+        None, ///< The bytes the layout was compiled from are not known.
+        ReportDescriptor, ///< The raw HID report descriptor, compiled by CompileReportDescriptor.
+        PreparsedData ///< The pre-parsed HID data of Windows, compiled through the HidP functions.
+    };
+
+    /**
+     * \brief Everything about a touchpad device that does not change between its reports.
+     */
+    struct DeviceInfo
+    {
+        ReportLayout layout; ///< Bit locations of the touchpad fields within the reports of the device.
+        DescriptorFormat descriptor_format = DescriptorFormat::None;
+        std::vector<uint8_t> descriptor; ///< The bytes the layout was compiled from, kept for captures.
+    };
+
+    /**
+     * \brief Lookup of per-device descriptor data, keyed by device handle.
+     */
+    class DeviceCache
+    {
+    public:
+        virtual ~DeviceCache() = default;
+
+        /**
+         * \brief Retrieves the descriptor data of a device, building it on first use if the cache is able to.
+         * \param device The device handle the report originated from.
+         * \return The cached device data, or nullptr if the device could not be described.
+         */
+        virtual DeviceInfo* Find(DeviceHandle device) = 0;
+
+        /**
+         * \brief Drops the cached data of a device, e.g. after it has been removed from the system.
+         * \param device The device handle to drop.
+         */
+        virtual void Remove(DeviceHandle device) = 0;
+
+        /**
+         * \brief Drops all cached device data.
+         */
+        virtual void Clear() = 0;
+    };
+
+    /**
+     * \brief Device cache that only knows about devices explicitly inserted into it, such as descriptors captured
+     * from real hardware and loaded by a test or benchmark build.
+     */
+    class StaticDeviceCache : public DeviceCache
+    {
+    public:
+        void Insert(DeviceHandle device, DeviceInfo info);
+
+        DeviceInfo* Find(DeviceHandle device) override;
+        void Remove(DeviceHandle device) override;
+        void Clear() override;
+
+    protected:
+        std::unordered_map<DeviceHandle, DeviceInfo> devices_;
+    };
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace Touchpad
+{
+    constexpr auto USAGE_PAGE_DIGITIZER_VALUES = 0x01;
+    constexpr auto USAGE_PAGE_DIGITIZER_INFO = 0x0D;
+    constexpr auto USAGE_DIGITIZER_TOUCH_PAD = 0x05;
+    constexpr auto USAGE_DIGITIZER_FINGER = 0x22;
+    constexpr auto USAGE_DIGITIZER_TIP_SWITCH = 0x42;
+    constexpr auto USAGE_DIGITIZER_CONFIDENCE = 0x47;
+    constexpr auto USAGE_DIGITIZER_SCAN_TIME = 0x56;
+    constexpr auto USAGE_DIGITIZER_CONTACT_COUNT = 0x54;
+    constexpr auto USAGE_DIGITIZER_CONTACT_ID = 0x51;
+    constexpr auto USAGE_DIGITIZER_X_COORDINATE = 0x30;
+    constexpr auto USAGE_DIGITIZER_Y_COORDINATE = 0x31;
+}
@@ -0,0 +1,220 @@
+#include "raw_input_device_cache.h"
+#include "../framework.h"
+#include "../config/globalconfig.h"
+#include "../logging/logger.h"
+
+namespace Touchpad
+{
+    namespace
+    {
+        constexpr ULONG MAIN_ITEM_VARIABLE = 0x02;
+
+        /**
+         * \brief Finds the first bit that differs between two report buffers of equal size.
+         */
+        bool FindChangedBit(const std::vector<CHAR>& baseline, const std::vector<CHAR>& probe, uint32_t& bit_offset)
+        {
+            for (size_t i = 0; i < baseline.size(); i++)
+            {
+                const auto changed = static_cast<uint8_t>(baseline[i] ^ probe[i]);
+                if (changed == 0)
+                    continue;
+
+                uint32_t bit = 0;
+                while (!(changed >> bit & 1))
+                    bit++;
+                bit_offset = static_cast<uint32_t>(i * 8 + bit);
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * \brief Locates every touchpad value of the device within its input reports. The HID parser does not expose
+         * bit offsets, so each value is written into an empty report with HidP_SetUsageValue and the changed bits
+         * are located. This only runs once per device.
+         */
+        void AddValueFields(const PHIDP_PREPARSED_DATA pre_parsed_data, const HIDP_CAPS& caps,
+                            ReportLayoutBuilder& builder)
+        {
+            USHORT length = caps.NumberInputValueCaps;
+            std::vector<HIDP_VALUE_CAPS> value_caps(length);
+            if (HidP_GetValueCaps(HidP_Input, value_caps.data(), &length, pre_parsed_data) != HIDP_STATUS_SUCCESS)
+            {
+                ERROR("Could not retrieve input value caps from the HID device.");
+                return;
+            }
+
+            const ULONG report_length = caps.InputReportByteLength;
+            std::vector<CHAR> baseline(report_length);
+            std::vector<CHAR> probe(report_length);
+
+            for (USHORT i = 0; i < length; i++)
+            {
+                const auto& cap = value_caps[i];
+                ReportFieldKind kind;
+
+                if (cap.IsRange || cap.ReportCount > 1 || !(cap.BitField & MAIN_ITEM_VARIABLE))
+                    continue;
+                if (!ClassifyUsage(cap.UsagePage, cap.NotRange.Usage, kind))
+                    continue;
+                if (HidP_InitializeReportForID(HidP_Input, cap.ReportID, pre_parsed_data, baseline.data(),
+                                               report_length) != HIDP_STATUS_SUCCESS)
+                    continue;
+
+                probe = baseline;
+                const ULONG all_bits = cap.BitSize >= 32 ? 0xFFFFFFFF : (1ul << cap.BitSize) - 1;
+
+                if (HidP_SetUsageValue(HidP_Input, cap.UsagePage, cap.LinkCollection, cap.NotRange.Usage, 0,
+                                       pre_parsed_data, baseline.data(), report_length) != HIDP_STATUS_SUCCESS ||
+                    HidP_SetUsageValue(HidP_Input, cap.UsagePage, cap.LinkCollection, cap.NotRange.Usage, all_bits,
+                                       pre_parsed_data, probe.data(), report_length) != HIDP_STATUS_SUCCESS)
+                    continue;
+
+                uint32_t bit_offset;
+                if (!FindChangedBit(baseline, probe, bit_offset))
+                    continue;
+
+                builder.AddField(cap.ReportID, cap.LinkCollection, kind, bit_offset, cap.BitSize,
+                                 cap.LogicalMin, cap.LogicalMax);
+            }
+        }
+
+        /**
+         * \brief Locates the tip switch bit of every contact collection, the same way as AddValueFields.
+         */
+        void AddTipSwitchFields(const PHIDP_PREPARSED_DATA pre_parsed_data, const HIDP_CAPS& caps,
+                                ReportLayoutBuilder& builder)
+        {
+            USHORT length = caps.NumberInputButtonCaps;
+            std::vector<HIDP_BUTTON_CAPS> button_caps(length);
+            if (HidP_GetButtonCaps(HidP_Input, button_caps.data(), &length, pre_parsed_data) != HIDP_STATUS_SUCCESS)
+            {
+                ERROR("Could not retrieve input button caps from the HID device.");
+                return;
+            }
+
+            const ULONG report_length = caps.InputReportByteLength;
+            std::vector<CHAR> baseline(report_length);
+            std::vector<CHAR> probe(report_length);
+
+            for (USHORT i = 0; i < length; i++)
+            {
+                const auto& cap = button_caps[i];
+
+                if (cap.UsagePage != HID_USAGE_PAGE_DIGITIZER || !(cap.BitField & MAIN_ITEM_VARIABLE))
+                    continue;
+
+                const bool has_tip_switch = cap.IsRange
+                                                ? cap.Range.UsageMin <= HID_USAGE_DIGITIZER_TIP_SWITCH &&
+                                                HID_USAGE_DIGITIZER_TIP_SWITCH <= cap.Range.UsageMax
+                                                : cap.NotRange.Usage == HID_USAGE_DIGITIZER_TIP_SWITCH;
+                if (!has_tip_switch)
+                    continue;
+
+                if (HidP_InitializeReportForID(HidP_Input, cap.ReportID, pre_parsed_data, baseline.data(),
+                                               report_length) != HIDP_STATUS_SUCCESS)
+                    continue;
+
+                probe = baseline;
+                USAGE usage = HID_USAGE_DIGITIZER_TIP_SWITCH;
+                ULONG usage_count = 1;
+
+                if (HidP_SetUsages(HidP_Input, HID_USAGE_PAGE_DIGITIZER, cap.LinkCollection, &usage, &usage_count,
+                                   pre_parsed_data, probe.data(), report_length) != HIDP_STATUS_SUCCESS)
+                    continue;
+
+                uint32_t bit_offset;
+                if (!FindChangedBit(baseline, probe, bit_offset))
+                    continue;
+
+                builder.AddField(cap.ReportID, cap.LinkCollection, ReportFieldKind::TipSwitch, bit_offset, 1, 0, 1);
+            }
+        }
+    }
+
+    DeviceInfo* RawInputDeviceCache::Find(const DeviceHandle device)
+    {
+        DeviceInfo* cached = StaticDeviceCache::Find(device);
+        if (cached == nullptr)
+        {
+            // Devices that cannot be described are cached too, so that they are only queried once
+            DeviceInfo info;
+            BuildDeviceInfo(device, info);
+            Insert(device, std::move(info));
+            cached = StaticDeviceCache::Find(device);
+        }
+        return cached->layout.Empty() ? nullptr : cached;
+    }
+
+    /**
+     * \brief Compiles the report layout of a raw input device from its pre-parsed HID data.
+     * \param device The raw input device handle.
+     * \param info The structure to fill.
+     * \return True if the device could be described.
+     */
+    bool RawInputDeviceCache::BuildDeviceInfo(const DeviceHandle device, DeviceInfo& info)
+    {
+        const auto device_handle = reinterpret_cast<HANDLE>(device);
+
+        // Get size of pre-parsed data buffer.
+        UINT buffer_size = 0;
+        GetRawInputDeviceInfo(device_handle, RIDI_PREPARSEDDATA, nullptr, &buffer_size);
+
+        if (buffer_size == 0)
+        {
+            ERROR("Could not retrieve pre-parsed data buffer from the HID device.");
+            return false;
+        }
+
+        // Get pre-parsed data buffer.
+        std::vector<BYTE> pre_parsed_buffer(buffer_size);
+        if (GetRawInputDeviceInfo(device_handle, RIDI_PREPARSEDDATA, pre_parsed_buffer.data(), &buffer_size) ==
+            static_cast<UINT>(-1))
+        {
+            ERROR("Could not retrieve pre-parsed data from the HID device.");
+            return false;
+        }
+
+        if (!CompilePreparsedData(pre_parsed_buffer.data(), pre_parsed_buffer.size(), info.layout))
+            return false;
+
+        info.descriptor_format = DescriptorFormat::PreparsedData;
+        info.descriptor.assign(pre_parsed_buffer.begin(), pre_parsed_buffer.end());
+
+        if (GlobalConfig::GetInstance()->LogDebug())
+            DEBUG("Compiled HID report layout. Fields = " + std::to_string(info.layout.fields.size()));
+
+        return true;
+    }
+
+    bool RawInputDeviceCache::CompilePreparsedData(const uint8_t* pre_parsed_data, const size_t size,
+                                                   ReportLayout& layout)
+    {
+        // The HidP functions take the buffer as is; it only has to be suitably aligned
+        std::vector<BYTE> buffer(pre_parsed_data, pre_parsed_data + size);
+        const auto data = reinterpret_cast<PHIDP_PREPARSED_DATA>(buffer.data());
+
+        // Get capabilities of HID device.
+        HIDP_CAPS caps;
+        if (HidP_GetCaps(data, &caps) != HIDP_STATUS_SUCCESS)
+        {
+            ERROR("Could not retrieve capabilities from the HID device.");
+            return false;
+        }
+
+        ReportLayoutBuilder builder;
+        AddValueFields(data, caps, builder);
+        AddTipSwitchFields(data, caps, builder);
+
+        // Raw input always prefixes a report with its report ID, or zero if the device does not number its reports
+        layout = builder.Build(true);
+
+        if (layout.Empty())
+        {
+            ERROR("The HID device does not report any touchpad contact data.");
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "device_cache.h"
+
+namespace Touchpad
+{
+    /**
+     * \brief Device cache backed by the Windows raw input API. The report layout of a device is compiled from its
+     * pre-parsed data on its first report and reused until the device is removed. Raw input does not expose the
+     * report descriptor itself, so the pre-parsed data is kept as the descriptor of the device.
+     */
+    class RawInputDeviceCache : public StaticDeviceCache
+    {
+    public:
+        DeviceInfo* Find(DeviceHandle device) override;
+
+        /**
+         * \brief Compiles the report layout of a device from its pre-parsed HID data, e.g. as stored in a capture.
+         * \param pre_parsed_data The pre-parsed data bytes.
+         * \param size Size of the pre-parsed data in bytes.
+         * \param layout Receives the compiled layout.
+         * \return True if the data describes at least one touchpad field.
+         */
+        static bool CompilePreparsedData(const uint8_t* pre_parsed_data, size_t size, ReportLayout& layout);
+
+    private:
+        static bool BuildDeviceInfo(DeviceHandle device, DeviceInfo& info);
+    };
+}
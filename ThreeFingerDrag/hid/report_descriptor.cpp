@@ -0,0 +1,352 @@
+#include "report_descriptor.h"
+#include <array>
+#include <vector>
+
+namespace Touchpad
+{
+    namespace
+    {
+        constexpr auto MAX_COLLECTION_DEPTH = 32;
+        constexpr auto MAX_GLOBAL_STACK_DEPTH = 8;
+        constexpr auto MAX_LOCAL_USAGES = 256;
+        constexpr uint32_t MAX_REPORT_BITS = 0xFFFF;
+        constexpr uint8_t LONG_ITEM_PREFIX = 0xFE;
+        constexpr uint8_t COLLECTION_APPLICATION = 0x01;
+
+        enum ItemType : uint8_t
+        {
+            ITEM_TYPE_MAIN = 0,
+            ITEM_TYPE_GLOBAL = 1,
+            ITEM_TYPE_LOCAL = 2
+        };
+
+        enum MainTag : uint8_t
+        {
+            MAIN_INPUT = 0x8,
+            MAIN_OUTPUT = 0x9,
+            MAIN_COLLECTION = 0xA,
+            MAIN_FEATURE = 0xB,
+            MAIN_END_COLLECTION = 0xC
+        };
+
+        enum GlobalTag : uint8_t
+        {
+            GLOBAL_USAGE_PAGE = 0x0,
+            GLOBAL_LOGICAL_MINIMUM = 0x1,
+            GLOBAL_LOGICAL_MAXIMUM = 0x2,
+            GLOBAL_REPORT_SIZE = 0x7,
+            GLOBAL_REPORT_ID = 0x8,
+            GLOBAL_REPORT_COUNT = 0x9,
+            GLOBAL_PUSH = 0xA,
+            GLOBAL_POP = 0xB
+        };
+
+        enum LocalTag : uint8_t
+        {
+            LOCAL_USAGE = 0x0,
+            LOCAL_USAGE_MINIMUM = 0x1,
+            LOCAL_USAGE_MAXIMUM = 0x2
+        };
+
+        enum InputFlags : uint32_t
+        {
+            INPUT_CONSTANT = 0x01,
+            INPUT_VARIABLE = 0x02
+        };
+
+        struct GlobalState
+        {
+            uint16_t usage_page = 0;
+            int32_t logical_min = 0;
+            uint32_t logical_max_raw = 0;
+            uint8_t logical_max_size = 0;
+            uint32_t report_size = 0;
+            uint32_t report_count = 0;
+            uint8_t report_id = 0;
+        };
+
+        struct LocalUsage
+        {
+            uint32_t value;
+            bool extended; ///< True if the usage page is part of the value.
+        };
+
+        struct LocalState
+        {
+            std::vector<LocalUsage> usages;
+            LocalUsage usage_min{};
+            LocalUsage usage_max{};
+            bool has_usage_min = false;
+            bool has_usage_max = false;
+
+            void Clear()
+            {
+                usages.clear();
+                has_usage_min = false;
+                has_usage_max = false;
+            }
+        };
+
+        struct CollectionState
+        {
+            uint32_t contact_collection; ///< Key of the enclosing finger collection, or NO_COLLECTION.
+            bool touchpad; ///< True if inside a touchpad application collection.
+        };
+
+        struct ParsedField
+        {
+            uint8_t report_id;
+            uint32_t collection;
+            ReportFieldKind kind;
+            uint32_t bit_offset;
+            uint32_t bit_width;
+            int32_t logical_min;
+            int32_t logical_max;
+        };
+
+        uint32_t ResolveUsage(const LocalUsage& usage, const uint16_t usage_page)
+        {
+            if (usage.extended)
+                return usage.value;
+            return static_cast<uint32_t>(usage_page) << 16 | (usage.value & 0xFFFF);
+        }
+
+        int32_t SignExtend(const uint32_t value, const uint8_t size)
+        {
+            switch (size)
+            {
+            case 1: return static_cast<int8_t>(value);
+            case 2: return static_cast<int16_t>(value);
+            default: return static_cast<int32_t>(value);
+            }
+        }
+
+        /**
+         * \brief Interprets the logical maximum as signed only if the logical minimum is negative, matching the
+         * way most devices encode unsigned ranges such as 0..255 in a single byte.
+         */
+        int32_t ResolveLogicalMaximum(const GlobalState& global)
+        {
+            if (global.logical_min < 0)
+                return SignExtend(global.logical_max_raw, global.logical_max_size);
+            if (global.logical_max_raw > INT32_MAX)
+                return INT32_MAX;
+            return static_cast<int32_t>(global.logical_max_raw);
+        }
+
+        /**
+         * \brief Returns the usage assigned to the given field index of a main item, or false if there is none.
+         */
+        bool UsageForIndex(const LocalState& local, const uint16_t usage_page, const uint32_t index, uint32_t& usage)
+        {
+            if (!local.usages.empty())
+            {
+                // Trailing fields reuse the last declared usage
+                const size_t usage_index = index < local.usages.size() ? index : local.usages.size() - 1;
+                usage = ResolveUsage(local.usages[usage_index], usage_page);
+                return true;
+            }
+
+            if (local.has_usage_min && local.has_usage_max)
+            {
+                const uint32_t minimum = ResolveUsage(local.usage_min, usage_page);
+                const uint32_t maximum = ResolveUsage(local.usage_max, usage_page);
+                if (maximum < minimum)
+                    return false;
+                usage = index <= maximum - minimum ? minimum + index : maximum;
+                return true;
+            }
+            return false;
+        }
+    }
+
+    bool CompileReportDescriptor(const uint8_t* descriptor, const size_t size, ReportLayout& layout)
+    {
+        GlobalState global;
+        LocalState local;
+        std::vector<GlobalState> global_stack;
+        std::vector<CollectionState> collections;
+        std::vector<ParsedField> parsed_fields;
+        std::array<uint32_t, 256> input_bits{};
+        uint32_t next_contact_collection = 0;
+        bool uses_report_ids = false;
+
+        size_t position = 0;
+        while (position < size)
+        {
+            const uint8_t prefix = descriptor[position++];
+
+            // Long items carry no information relevant to touchpads, skip over them
+            if (prefix == LONG_ITEM_PREFIX)
+            {
+                if (position + 2 > size)
+                    return false;
+                position += 2 + static_cast<size_t>(descriptor[position]);
+                if (position > size)
+                    return false;
+                continue;
+            }
+
+            const uint8_t size_code = prefix & 0x03;
+            const uint8_t data_size = size_code == 3 ? 4 : size_code;
+            const auto type = static_cast<uint8_t>(prefix >> 2 & 0x03);
+            const auto tag = static_cast<uint8_t>(prefix >> 4);
+
+            if (position + data_size > size)
+                return false;
+
+            uint32_t data = 0;
+            for (uint8_t i = 0; i < data_size; i++)
+                data |= static_cast<uint32_t>(descriptor[position + i]) << (i * 8);
+            position += data_size;
+
+            switch (type)
+            {
+            case ITEM_TYPE_MAIN:
+                switch (tag)
+                {
+                case MAIN_COLLECTION:
+                    {
+                        if (collections.size() >= MAX_COLLECTION_DEPTH)
+                            return false;
+
+                        uint32_t usage = 0;
+                        UsageForIndex(local, global.usage_page, 0, usage);
+
+                        CollectionState state = collections.empty()
+                                                    ? CollectionState{NO_COLLECTION, false}
+                                                    : collections.back();
+
+                        const uint32_t touchpad_usage = USAGE_PAGE_DIGITIZER_INFO << 16 | USAGE_DIGITIZER_TOUCH_PAD;
+                        const uint32_t finger_usage = USAGE_PAGE_DIGITIZER_INFO << 16 | USAGE_DIGITIZER_FINGER;
+
+                        if ((data & 0xFF) == COLLECTION_APPLICATION)
+                            state.touchpad = usage == touchpad_usage;
+                        else if (state.touchpad && usage == finger_usage)
+                            state.contact_collection = next_contact_collection++;
+
+                        collections.push_back(state);
+                        break;
+                    }
+                case MAIN_END_COLLECTION:
+                    if (collections.empty())
+                        return false;
+                    collections.pop_back();
+                    break;
+                case MAIN_INPUT:
+                    {
+                        const uint64_t total_bits = static_cast<uint64_t>(global.report_size) * global.report_count;
+                        uint32_t& cursor = input_bits[global.report_id];
+                        if (cursor + total_bits > MAX_REPORT_BITS)
+                            return false;
+
+                        const bool touchpad = !collections.empty() && collections.back().touchpad;
+                        if (touchpad && global.report_size > 0 && !(data & INPUT_CONSTANT) && data & INPUT_VARIABLE)
+                        {
+                            for (uint32_t i = 0; i < global.report_count; i++)
+                            {
+                                uint32_t usage;
+                                ReportFieldKind kind;
+                                if (!UsageForIndex(local, global.usage_page, i, usage))
+                                    break;
+                                if (!ClassifyUsage(static_cast<uint16_t>(usage >> 16),
+                                                   static_cast<uint16_t>(usage & 0xFFFF), kind))
+                                    continue;
+
+                                parsed_fields.push_back({
+                                    global.report_id, collections.back().contact_collection, kind,
+                                    cursor + i * global.report_size, global.report_size,
+                                    global.logical_min, ResolveLogicalMaximum(global)
+                                });
+                            }
+                        }
+                        cursor += static_cast<uint32_t>(total_bits);
+                        break;
+                    }
+                case MAIN_OUTPUT:
+                case MAIN_FEATURE:
+                default:
+                    break;
+                }
+                // Local items only apply to the main item that follows them
+                local.Clear();
+                break;
+
+            case ITEM_TYPE_GLOBAL:
+                switch (tag)
+                {
+                case GLOBAL_USAGE_PAGE:
+                    global.usage_page = static_cast<uint16_t>(data);
+                    break;
+                case GLOBAL_LOGICAL_MINIMUM:
+                    global.logical_min = SignExtend(data, data_size);
+                    break;
+                case GLOBAL_LOGICAL_MAXIMUM:
+                    global.logical_max_raw = data;
+                    global.logical_max_size = data_size;
+                    break;
+                case GLOBAL_REPORT_SIZE:
+                    global.report_size = data;
+                    break;
+                case GLOBAL_REPORT_ID:
+                    global.report_id = static_cast<uint8_t>(data);
+                    uses_report_ids = true;
+                    break;
+                case GLOBAL_REPORT_COUNT:
+                    global.report_count = data;
+                    break;
+                case GLOBAL_PUSH:
+                    if (global_stack.size() >= MAX_GLOBAL_STACK_DEPTH)
+                        return false;
+                    global_stack.push_back(global);
+                    break;
+                case GLOBAL_POP:
+                    if (global_stack.empty())
+                        return false;
+                    global = global_stack.back();
+                    global_stack.pop_back();
+                    break;
+                default:
+                    break;
+                }
+                break;
+
+            case ITEM_TYPE_LOCAL:
+                switch (tag)
+                {
+                case LOCAL_USAGE:
+                    if (local.usages.size() < MAX_LOCAL_USAGES)
+                        local.usages.push_back({data, data_size == 4});
+                    break;
+                case LOCAL_USAGE_MINIMUM:
+                    local.usage_min = {data, data_size == 4};
+                    local.has_usage_min = true;
+                    break;
+                case LOCAL_USAGE_MAXIMUM:
+                    local.usage_max = {data, data_size == 4};
+                    local.has_usage_max = true;
+                    break;
+                default:
+                    break;
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        // Reports that are numbered carry their report ID in the first byte
+        const uint32_t prefix_bits = uses_report_ids ? 8 : 0;
+
+        ReportLayoutBuilder builder;
+        for (const auto& field : parsed_fields)
+        {
+            builder.AddField(field.report_id, field.collection, field.kind, field.bit_offset + prefix_bits,
+                             field.bit_width, field.logical_min, field.logical_max);
+        }
+
+        layout = builder.Build(uses_report_ids);
+        return !layout.Empty();
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "report_layout.h"
+
+namespace Touchpad
+{
+    /**
+     * \brief Compiles the raw HID report descriptor of a precision touchpad into a report layout.
+     *
+     * Only variable input items inside a Digitizer / Touch Pad application collection are compiled. Every
+     * Digitizer / Finger collection becomes a contact slot. Malformed or truncated descriptors are rejected
+     * without reading past the end of the buffer.
+     *
+     * \param descriptor The report descriptor bytes.
+     * \param size Size of the descriptor in bytes.
+     * \param layout Receives the compiled layout.
+     * \return True if the descriptor was well formed and describes at least one touchpad field.
+     */
+    bool CompileReportDescriptor(const uint8_t* descriptor, size_t size, ReportLayout& layout);
+}
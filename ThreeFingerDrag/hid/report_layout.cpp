@@ -0,0 +1,285 @@
+#include "report_layout.h"
+#include <algorithm>
+#include <array>
+
+namespace Touchpad
+{
+    namespace
+    {
+        constexpr uint32_t MAX_FIELD_BITS = 32;
+        constexpr uint32_t MAX_REPORT_BITS = 0xFFFF;
+
+        const ReportTable* FindTable(const ReportLayout& layout, const uint8_t* report, const size_t size)
+        {
+            if (!layout.has_report_id_prefix)
+                return layout.reports.empty() ? nullptr : &layout.reports.front();
+
+            if (size == 0)
+                return nullptr;
+
+            for (const auto& table : layout.reports)
+            {
+                if (table.report_id == report[0])
+                    return &table;
+            }
+            return nullptr;
+        }
+
+        /**
+         * \brief Reads a little-endian bit field of up to 32 bits. The caller guarantees it lies within the report.
+         */
+        uint32_t ExtractBits(const uint8_t* report, const uint32_t bit_offset, const uint32_t bit_width)
+        {
+            const uint32_t first_byte = bit_offset / 8;
+            const uint32_t last_byte = (bit_offset + bit_width - 1) / 8;
+
+            uint64_t raw = 0;
+            for (uint32_t i = first_byte; i <= last_byte; i++)
+                raw |= static_cast<uint64_t>(report[i]) << ((i - first_byte) * 8);
+
+            raw >>= bit_offset % 8;
+            const uint64_t mask = (1ull << bit_width) - 1;
+            return static_cast<uint32_t>(raw & mask);
+        }
+
+        /**
+         * \brief Sign extends a raw field value if its logical range allows negative values.
+         */
+        int32_t ToLogicalValue(const uint32_t raw, const ReportField& field)
+        {
+            if (field.logical_min >= 0 || field.bit_width >= MAX_FIELD_BITS)
+                return static_cast<int32_t>(raw);
+
+            const uint32_t sign_bit = 1u << (field.bit_width - 1);
+            if (raw & sign_bit)
+                return static_cast<int32_t>(raw | ~((sign_bit << 1) - 1));
+            return static_cast<int32_t>(raw);
+        }
+
+        struct SlotValues
+        {
+            const ReportField* x_field;
+            const ReportField* y_field;
+            int contact_id;
+            int x;
+            int y;
+            bool has_contact_id;
+            bool on_surface;
+        };
+    }
+
+    bool ClassifyUsage(const uint16_t usage_page, const uint16_t usage, ReportFieldKind& kind)
+    {
+        if (usage_page == USAGE_PAGE_DIGITIZER_VALUES)
+        {
+            switch (usage)
+            {
+            case USAGE_DIGITIZER_X_COORDINATE:
+                kind = ReportFieldKind::X;
+                return true;
+            case USAGE_DIGITIZER_Y_COORDINATE:
+                kind = ReportFieldKind::Y;
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        if (usage_page == USAGE_PAGE_DIGITIZER_INFO)
+        {
+            switch (usage)
+            {
+            case USAGE_DIGITIZER_CONTACT_ID:
+                kind = ReportFieldKind::ContactId;
+                return true;
+            case USAGE_DIGITIZER_TIP_SWITCH:
+                kind = ReportFieldKind::TipSwitch;
+                return true;
+            case USAGE_DIGITIZER_CONTACT_COUNT:
+                kind = ReportFieldKind::ContactCount;
+                return true;
+            case USAGE_DIGITIZER_SCAN_TIME:
+                kind = ReportFieldKind::ScanTime;
+                return true;
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool IsContactField(const ReportFieldKind kind)
+    {
+        return kind != ReportFieldKind::ContactCount && kind != ReportFieldKind::ScanTime;
+    }
+
+    void ReportLayoutBuilder::AddField(const uint8_t report_id, const uint32_t collection, const ReportFieldKind kind,
+                                       const uint32_t bit_offset, const uint32_t bit_width,
+                                       const int32_t logical_min, const int32_t logical_max)
+    {
+        // Fields the decoder cannot extract are left out rather than failing the whole descriptor
+        if (bit_width == 0 || bit_width > MAX_FIELD_BITS || bit_offset + bit_width > MAX_REPORT_BITS)
+            return;
+
+        if (IsContactField(kind) && collection == NO_COLLECTION)
+            return;
+
+        pending_.push_back({
+            report_id, collection, kind, static_cast<uint16_t>(bit_offset), static_cast<uint8_t>(bit_width),
+            logical_min, logical_max
+        });
+    }
+
+    ReportLayout ReportLayoutBuilder::Build(const bool has_report_id_prefix) const
+    {
+        ReportLayout layout;
+        layout.has_report_id_prefix = has_report_id_prefix;
+
+        // Assign slots per report ID, in the order contact collections first appear
+        struct SlotKey
+        {
+            uint8_t report_id;
+            uint32_t collection;
+        };
+        std::vector<SlotKey> slot_keys;
+
+        for (const auto& pending : pending_)
+        {
+            uint8_t slot = FRAME_SLOT;
+            if (IsContactField(pending.kind))
+            {
+                int report_slots = 0;
+                int found = -1;
+                for (const auto& key : slot_keys)
+                {
+                    if (key.report_id != pending.report_id)
+                        continue;
+                    if (key.collection == pending.collection)
+                    {
+                        found = report_slots;
+                        break;
+                    }
+                    report_slots++;
+                }
+
+                if (found < 0)
+                {
+                    if (report_slots >= MAX_REPORT_SLOTS)
+                        continue;
+                    slot_keys.push_back({pending.report_id, pending.collection});
+                    found = report_slots;
+                }
+                slot = static_cast<uint8_t>(found);
+            }
+
+            layout.fields.push_back({
+                pending.report_id, slot, pending.kind, pending.bit_width, pending.bit_offset,
+                pending.logical_min, pending.logical_max
+            });
+        }
+
+        std::stable_sort(layout.fields.begin(), layout.fields.end(), [](const ReportField& a, const ReportField& b)
+        {
+            if (a.report_id != b.report_id)
+                return a.report_id < b.report_id;
+            return a.slot < b.slot;
+        });
+
+        for (size_t i = 0; i < layout.fields.size(); i++)
+        {
+            const auto& field = layout.fields[i];
+            if (layout.reports.empty() || layout.reports.back().report_id != field.report_id)
+                layout.reports.push_back({field.report_id, 0, static_cast<uint16_t>(i), 0});
+
+            auto& table = layout.reports.back();
+            table.field_count++;
+            if (field.slot != FRAME_SLOT && field.slot >= table.slot_count)
+                table.slot_count = static_cast<uint8_t>(field.slot + 1);
+        }
+
+        return layout;
+    }
+
+    bool DecodeReport(const ReportLayout& layout, const uint8_t* report, const size_t size, DecodedReport& decoded)
+    {
+        decoded.contacts.Clear();
+        decoded.contact_count = 0;
+        decoded.has_contact_count = false;
+        decoded.scan_time = 0;
+        decoded.scan_time_bits = 0;
+
+        const ReportTable* table = FindTable(layout, report, size);
+        if (table == nullptr)
+            return false;
+
+        std::array<SlotValues, MAX_REPORT_SLOTS> slots{};
+        const size_t report_bits = size * 8;
+
+        for (uint16_t i = 0; i < table->field_count; i++)
+        {
+            const auto& field = layout.fields[table->first_field + i];
+
+            // Skip fields that a short report does not contain
+            if (field.bit_offset + field.bit_width > report_bits)
+                continue;
+
+            const uint32_t raw = ExtractBits(report, field.bit_offset, field.bit_width);
+            const int32_t value = ToLogicalValue(raw, field);
+
+            if (field.slot == FRAME_SLOT)
+            {
+                if (field.kind == ReportFieldKind::ContactCount)
+                {
+                    decoded.contact_count = value;
+                    decoded.has_contact_count = true;
+                }
+                else if (field.kind == ReportFieldKind::ScanTime)
+                {
+                    // The counter wraps at its field width, so keep the unsigned raw value
+                    decoded.scan_time = raw;
+                    decoded.scan_time_bits = field.bit_width;
+                }
+                continue;
+            }
+
+            auto& slot = slots[field.slot];
+            switch (field.kind)
+            {
+            case ReportFieldKind::ContactId:
+                slot.contact_id = value;
+                slot.has_contact_id = true;
+                break;
+            case ReportFieldKind::X:
+                slot.x = value;
+                slot.x_field = &field;
+                break;
+            case ReportFieldKind::Y:
+                slot.y = value;
+                slot.y_field = &field;
+                break;
+            case ReportFieldKind::TipSwitch:
+                slot.on_surface = value != 0;
+                break;
+            default:
+                break;
+            }
+        }
+
+        for (uint8_t i = 0; i < table->slot_count; i++)
+        {
+            const auto& slot = slots[i];
+
+            // Only report contacts for which all coordinate fields were present
+            if (!slot.has_contact_id || slot.x_field == nullptr || slot.y_field == nullptr)
+                continue;
+
+            decoded.contacts.Add({
+                slot.contact_id, slot.x, slot.y, slot.on_surface,
+                true, true,
+                slot.x_field->logical_min, slot.x_field->logical_max,
+                slot.y_field->logical_min, slot.y_field->logical_max
+            });
+        }
+        return true;
+    }
+}
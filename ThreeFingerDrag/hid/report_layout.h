@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../data/touch_data.h"
+#include "hid_usages.h"
+
+namespace Touchpad
+{
+    constexpr auto MAX_REPORT_SLOTS = 16;
+    constexpr uint8_t FRAME_SLOT = 0xFF;
+    constexpr uint32_t NO_COLLECTION = 0xFFFFFFFF;
+
+    /**
+     * \brief The touchpad values a report field can hold.
+     */
+    enum class ReportFieldKind : uint8_t
+    {
+        ContactId,
+        X,
+        Y,
+        TipSwitch,
+        ContactCount,
+        ScanTime
+    };
+
+    /**
+     * \brief Location of a single value within an input report.
+     */
+    struct ReportField
+    {
+        uint8_t report_id;
+        uint8_t slot; ///< Contact slot the value belongs to, or FRAME_SLOT for values describing the whole report.
+        ReportFieldKind kind;
+        uint8_t bit_width;
+        uint16_t bit_offset; ///< Offset from the first byte of the report, including the report ID byte if present.
+        int32_t logical_min;
+        int32_t logical_max;
+    };
+
+    /**
+     * \brief The range of fields belonging to one report ID.
+     */
+    struct ReportTable
+    {
+        uint8_t report_id;
+        uint8_t slot_count;
+        uint16_t first_field;
+        uint16_t field_count;
+    };
+
+    /**
+     * \brief A touchpad report descriptor compiled into a flat table of bit locations.
+     */
+    struct ReportLayout
+    {
+        std::vector<ReportField> fields; ///< Sorted by report ID, then slot.
+        std::vector<ReportTable> reports;
+        bool has_report_id_prefix = false; ///< True if the first byte of every report is its report ID.
+
+        bool Empty() const { return fields.empty(); }
+    };
+
+    /**
+     * \brief The values of a single decoded input report.
+     */
+    struct DecodedReport
+    {
+        TouchFrame contacts; ///< Every contact slot of the report with an ID, X and Y value, in slot order.
+        int contact_count = 0; ///< Value of the Contact Count usage. Zero in continuation reports of a frame.
+        bool has_contact_count = false; ///< True if the report carries the Contact Count usage.
+        uint32_t scan_time = 0; ///< Raw Scan Time counter in 100 microsecond units, wrapping at its field width.
+        uint8_t scan_time_bits = 0; ///< Width of the Scan Time field, or 0 if the report does not carry it.
+    };
+
+    /**
+     * \brief Returns true and the field kind if the given usage is one the touchpad decoder reads.
+     * \param usage_page The HID usage page.
+     * \param usage The HID usage ID.
+     * \param kind Receives the field kind.
+     */
+    bool ClassifyUsage(uint16_t usage_page, uint16_t usage, ReportFieldKind& kind);
+
+    /**
+     * \brief Returns true if the field kind describes a single contact rather than the whole report.
+     */
+    bool IsContactField(ReportFieldKind kind);
+
+    /**
+     * \brief Collects report fields in any order and compiles them into a ReportLayout. Contact fields are grouped
+     * into slots by a collection key, such as a HID link collection index.
+     */
+    class ReportLayoutBuilder
+    {
+    public:
+        /**
+         * \brief Adds a field to the layout.
+         * \param report_id The report ID the field is sent in.
+         * \param collection Key of the collection grouping the fields of one contact, or NO_COLLECTION.
+         * \param kind The field kind.
+         * \param bit_offset Offset of the field from the first byte of the report.
+         * \param bit_width Width of the field in bits, at most 32.
+         * \param logical_min The logical minimum of the field.
+         * \param logical_max The logical maximum of the field.
+         */
+        void AddField(uint8_t report_id, uint32_t collection, ReportFieldKind kind, uint32_t bit_offset,
+                      uint32_t bit_width, int32_t logical_min, int32_t logical_max);
+
+        /**
+         * \brief Assigns contact slots in order of first appearance and builds the per report ID tables.
+         * \param has_report_id_prefix True if reports start with their report ID byte.
+         */
+        ReportLayout Build(bool has_report_id_prefix) const;
+
+    private:
+        struct PendingField
+        {
+            uint8_t report_id;
+            uint32_t collection;
+            ReportFieldKind kind;
+            uint16_t bit_offset;
+            uint8_t bit_width;
+            int32_t logical_min;
+            int32_t logical_max;
+        };
+
+        std::vector<PendingField> pending_;
+    };
+
+    /**
+     * \brief Extracts the touch contacts of a report by walking a compiled layout. Performs no system calls.
+     * \param layout The compiled layout of the device that sent the report.
+     * \param report The report bytes, as delivered by the device.
+     * \param size Size of the report in bytes.
+     * \param decoded Receives the decoded values. Cleared first.
+     * \return False if the report ID is unknown to the layout.
+     */
+    bool DecodeReport(const ReportLayout& layout, const uint8_t* report, size_t size, DecodedReport& decoded);
+}
@@ -1,9 +1,48 @@
 #include "logger.h"
-#include <sstream>
 #include <iomanip>
 #include <ctime>
 
+#ifdef _WIN32
 #include "../application.h"
+#endif
+
+namespace
+{
+    std::string LogFolderPath()
+    {
+#ifdef _WIN32
+        return Application::GetConfigurationFolderPath();
+#else
+        // Headless builds have no configuration folder
+        return std::filesystem::current_path().u8string();
+#endif
+    }
+
+    bool ToLocalTime(const std::time_t time, std::tm& local_time)
+    {
+#ifdef _WIN32
+        return localtime_s(&local_time, &time) == 0;
+#else
+        return localtime_r(&time, &local_time) != nullptr;
+#endif
+    }
+
+    const char* LevelName(const LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Info:
+            return "[INFO]";
+        case LogLevel::Debug:
+            return "[DEBUG]";
+        case LogLevel::Warning:
+            return "[WARNING]";
+        case LogLevel::Error:
+            return "[ERROR]";
+        }
+        return "";
+    }
+}
 
 Logger& Logger::GetInstance()
 {
@@ -13,13 +52,16 @@ Logger& Logger::GetInstance()
 
 Logger::Logger(const std::string& logFileName)
 {
-    log_file_path_ = Application::GetConfigurationFolderPath();
+    log_file_path_ = LogFolderPath();
 
     // Check if the folder exists, and create it if necessary
     if (!std::filesystem::exists(log_file_path_))
         std::filesystem::create_directory(log_file_path_);
 
-    log_file_path_ += "\\" + logFileName;
+    const std::filesystem::path file_name(logFileName);
+    log_file_stem_ = (std::filesystem::path(log_file_path_) / file_name.stem()).u8string();
+    log_file_extension_ = file_name.extension().string();
+    log_file_path_ = GenerationPath(0);
 
     // Check if the log file exists, and create it if necessary
     if (!std::filesystem::exists(log_file_path_))
@@ -29,71 +71,230 @@ Logger::Logger(const std::string& logFileName)
     }
 
     log_file_.open(log_file_path_, std::ios::out | std::ios::app);
+    log_file_opened_ = std::chrono::system_clock::now();
+
+    // A file left over from a previous run may already be over the limit
+    std::error_code error;
+    if (std::filesystem::file_size(log_file_path_, error) >= static_cast<uintmax_t>(LOG_FILE_MAX_SIZE))
+        Rotate(rotation_policy_.retained_generations);
+
+    thread_ = std::thread(&Logger::Run, this);
 }
 
-void Logger::WriteLog(const std::string& type, const std::string& message)
+Logger::~Logger()
 {
-    // Check if the log file has exceeded the threshold size of 5 MB
-    const std::streampos current_pos = log_file_.tellp();
-    const std::streampos max_size = 5 * 1024 * 1024; // 5MB
-    if (current_pos >= max_size)
     {
-        // Truncate the log file to zero size
-        log_file_.close();
-        std::ofstream file(log_file_path_, std::ios::out | std::ios::trunc);
-        file.close();
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
     }
+    wake_condition_.notify_one();
 
-    // Get the current system time
-    const auto now = std::chrono::system_clock::now();
-    const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+    if (thread_.joinable())
+        thread_.join();
 
-    // Convert the time to a string
-    std::tm time_info;
-    if (localtime_s(&time_info, &now_time) == 0)
+    log_file_.close();
+}
+
+void Logger::Info(std::string message)
+{
+    Log(LogLevel::Info, std::move(message));
+}
+
+void Logger::Debug(std::string message)
+{
+    Log(LogLevel::Debug, std::move(message));
+}
+
+void Logger::Warning(std::string message)
+{
+    Log(LogLevel::Warning, std::move(message));
+}
+
+void Logger::Error(std::string message)
+{
+    Log(LogLevel::Error, std::move(message));
+}
+
+void Logger::SetOverflowPolicy(const LogOverflowPolicy policy)
+{
+    overflow_policy_.store(policy, std::memory_order_relaxed);
+}
+
+void Logger::SetRotationPolicy(const LogRotationPolicy& policy)
+{
+    std::lock_guard lock(mutex_);
+    rotation_policy_ = policy;
+}
+
+void Logger::Flush()
+{
+    std::unique_lock lock(mutex_);
+    const uint64_t target = ++flush_requested_;
+    wake_condition_.notify_one();
+    flushed_condition_.wait(lock, [&] { return flushed_ >= target; });
+}
+
+void Logger::Log(const LogLevel level, std::string message)
+{
+    Push([&](LogRecord& record)
     {
-        std::stringstream ss;
-        ss << std::put_time(&time_info, "%y-%m-%d %H:%M:%S");
-        const std::string timestamp_str = ss.str();
+        record.level = level;
+        record.time = std::chrono::system_clock::now();
+        record.message = std::move(message);
+        record.format = nullptr;
+    });
+}
+
+void Logger::WakeLogThread()
+{
+    {
+        std::lock_guard lock(mutex_);
+    }
+    wake_condition_.notify_one();
+}
+
+void Logger::Run()
+{
+    std::unique_lock lock(mutex_);
+    for (;;)
+    {
+        const uint64_t flush_target = flush_requested_;
+        const bool stopping = stopping_;
+        lock.unlock();
+
+        if (WriteRecords() || flush_target != flushed_)
+            log_file_.flush();
+
+        lock.lock();
+        if (flush_target != flushed_)
+        {
+            flushed_ = flush_target;
+            flushed_condition_.notify_all();
+        }
 
-        // Write the log message to the file with the timestamp
-        if (!type.empty())
-            log_file_ << timestamp_str << " " << type << " " << message << '\n';
-        else
-            log_file_ << timestamp_str << ": " << message << '\n';
+        if (stopping)
+            break;
 
+        // Producers only notify while this flag is set, so an idle logger costs them nothing. A record pushed
+        // while the flag is being set is caught by the fence pair or, at worst, by the periodic wake up.
+        log_thread_waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake_condition_.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS), [this]
+        {
+            return stopping_ || flush_requested_ != flushed_ || !ring_.Empty();
+        });
+        log_thread_waiting_.store(false, std::memory_order_relaxed);
     }
-    else
+}
+
+bool Logger::WriteRecords()
+{
+    if (ring_.Empty() && DroppedRecords() == reported_dropped_records_)
+        return false;
+
+    LogRotationPolicy policy;
     {
-        // Write the log message to the file without the timestamp
-        if (!type.empty())
-            log_file_ << type << " - " << message << '\n';
-        else
-            log_file_ << ": " <<  message << '\n';
+        std::lock_guard lock(mutex_);
+        policy = rotation_policy_;
     }
+    RotateIfNeeded(policy);
+
+    while (ring_.TryPop([this, &policy](LogRecord& record)
+    {
+        WriteLog(record);
+
+        // Free the message here rather than on the next producer to use the slot
+        record.message = std::string();
+
+        // A burst is split across generations rather than growing the file past its limit
+        if (log_file_.tellp() >= policy.max_file_size)
+            Rotate(policy.retained_generations);
+    }))
+    {
+    }
+
+    const uint64_t dropped = DroppedRecords();
+    if (dropped != reported_dropped_records_)
+    {
+        LogRecord note;
+        note.level = LogLevel::Warning;
+        note.time = std::chrono::system_clock::now();
+        note.message = std::to_string(dropped - reported_dropped_records_) +
+            " log records were dropped because the log buffer was full.";
+        WriteLog(note);
+        reported_dropped_records_ = dropped;
+    }
+    return true;
 }
 
-void Logger::Info(const std::string& message)
+void Logger::WriteLog(const LogRecord& record)
 {
-    WriteLog("[INFO]", message);
+    const char* type = LevelName(record.level);
+    const char* timestamp = Timestamp(record.time);
+
+    // Write the log message to the file with the timestamp, or without it if the time could not be converted
+    if (timestamp != nullptr)
+        log_file_ << timestamp << " " << type << " ";
+    else
+        log_file_ << type << " - ";
+
+    if (record.format != nullptr)
+        record.format(record.payload, log_file_);
+    else
+        log_file_ << record.message;
+    log_file_ << '\n';
 }
 
-void Logger::Debug(const std::string& message)
+void Logger::RotateIfNeeded(const LogRotationPolicy& policy)
 {
-    WriteLog("[DEBUG]", message);
+    // Check if the log file has exceeded the threshold size or age
+    const bool too_large = log_file_.tellp() >= policy.max_file_size;
+    const bool too_old = std::chrono::system_clock::now() - log_file_opened_ >= policy.max_file_age;
+    if (too_large || too_old)
+        Rotate(policy.retained_generations);
 }
 
-void Logger::Warning(const std::string& message)
+void Logger::Rotate(const int retained_generations)
 {
-    WriteLog("[WARNING]", message);
+    log_file_.close();
+
+    // Renaming fails for generations that do not exist yet, and if the file is held open elsewhere. The current
+    // file is truncated below in either case, so it can never grow past its limit.
+    std::error_code error;
+    if (retained_generations > 0)
+    {
+        std::filesystem::remove(GenerationPath(retained_generations), error);
+        for (int generation = retained_generations - 1; generation >= 0; generation--)
+            std::filesystem::rename(GenerationPath(generation), GenerationPath(generation + 1), error);
+    }
+
+    log_file_.open(log_file_path_, std::ios::out | std::ios::trunc);
+    log_file_opened_ = std::chrono::system_clock::now();
+    rotations_.fetch_add(1, std::memory_order_relaxed);
 }
 
-void Logger::Error(const std::string& message)
+std::string Logger::GenerationPath(const int generation) const
 {
-    WriteLog("[ERROR]", message);
+    if (generation == 0)
+        return log_file_stem_ + log_file_extension_;
+    return log_file_stem_ + "." + std::to_string(generation) + log_file_extension_;
 }
 
-Logger::~Logger()
+const char* Logger::Timestamp(const std::chrono::system_clock::time_point time)
 {
-    log_file_.close();
+    // Records arrive in bursts, so the converted time is reused until the second changes
+    const std::time_t now_time = std::chrono::system_clock::to_time_t(time);
+    if (now_time == timestamp_second_ && timestamp_[0] != '\0')
+        return timestamp_;
+
+    std::tm time_info;
+    if (!ToLocalTime(now_time, time_info) ||
+        std::strftime(timestamp_, sizeof(timestamp_), "%y-%m-%d %H:%M:%S", &time_info) == 0)
+    {
+        timestamp_[0] = '\0';
+        return nullptr;
+    }
+
+    timestamp_second_ = now_time;
+    return timestamp_;
 }
@@ -2,11 +2,72 @@
 
 #include <fstream>
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <thread>
 #include <filesystem>
+#include <type_traits>
+#include "../sync/mpsc_ring.h"
+
+constexpr auto LOG_RING_CAPACITY = 1024;
+constexpr auto LOG_PAYLOAD_SIZE = 512;
+constexpr auto LOG_FLUSH_INTERVAL_MS = 100;
+constexpr std::streamoff LOG_FILE_MAX_SIZE = 5 * 1024 * 1024; // 5MB
+constexpr auto LOG_RETAINED_GENERATIONS = 3;
+constexpr auto LOG_FILE_MAX_AGE_HOURS = 24;
+
+enum class LogLevel : uint8_t
+{
+    Info,
+    Debug,
+    Warning,
+    Error
+};
+
+/**
+ * @brief What a producer does when the log ring is full.
+ */
+enum class LogOverflowPolicy : uint8_t
+{
+    Drop, ///< Drop the record and count it, never stalling the caller.
+    Block ///< Wait for the log thread to make room.
+};
+
+/**
+ * @brief When the log file is rotated, and how many rotated files are kept.
+ */
+struct LogRotationPolicy
+{
+    std::streamoff max_file_size = LOG_FILE_MAX_SIZE; ///< Rotate once the file reaches this size.
+    std::chrono::seconds max_file_age = std::chrono::hours(LOG_FILE_MAX_AGE_HOURS); ///< Rotate files this old.
+    int retained_generations = LOG_RETAINED_GENERATIONS; ///< Number of rotated files kept, e.g. log.1.txt.
+};
+
+/**
+ * @brief A log line waiting in the ring. Holds either a preformatted message, or a payload that is formatted on the
+ * log thread.
+ */
+struct LogRecord
+{
+    using FormatFunction = void (*)(const void* payload, std::ostream& out);
+
+    LogLevel level = LogLevel::Info;
+    std::chrono::system_clock::time_point time;
+    std::string message;
+    FormatFunction format = nullptr;
+    alignas(std::max_align_t) unsigned char payload[LOG_PAYLOAD_SIZE];
+};
 
 /**
  * @brief A logger class for writing log messages to a file.
+ *
+ * Logging only timestamps the message and pushes it into a lock-free ring shared by all threads. A background
+ * thread formats the records and writes them to the file. Once the file grows too large or too old, the same thread
+ * rotates it: log.txt becomes log.1.txt, log.1.txt becomes log.2.txt, and so on, keeping a fixed number of
+ * generations. Rotating stalls no caller; records logged meanwhile wait in the ring.
  */
 class Logger
 {
@@ -15,35 +76,86 @@ public:
      * @brief Writes an info log message to the file.
      * @param message The log message.
      */
-    void Info(const std::string& message);
+    void Info(std::string message);
 
     /**
      * @brief Writes a debug log message to the file.
      * @param message The log message.
      */
-    void Debug(const std::string& message);
+    void Debug(std::string message);
 
     /**
      * @brief Writes a warning log message to the file.
      * @param message The log message.
      */
-    void Warning(const std::string& message);
+    void Warning(std::string message);
 
     /**
      * @brief Writes an error log message to the file.
      * @param message The log message.
      */
-    void Error(const std::string& message);
+    void Error(std::string message);
+
+    /**
+     * @brief Writes a log message that is only formatted on the log thread, so the caller only pays for copying
+     * the payload.
+     * @tparam Format The function writing the message of the payload.
+     * @param level The log level.
+     * @param payload A trivially copyable value of at most LOG_PAYLOAD_SIZE bytes.
+     */
+    template <auto Format, typename T>
+    void Deferred(const LogLevel level, const T& payload)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Deferred log payloads are copied bytewise.");
+        static_assert(sizeof(T) <= LOG_PAYLOAD_SIZE, "Deferred log payload is too large.");
+
+        Push([&](LogRecord& record)
+        {
+            record.level = level;
+            record.time = std::chrono::system_clock::now();
+            record.message.clear();
+            record.format = [](const void* stored, std::ostream& out)
+            {
+                T value;
+                std::memcpy(static_cast<void*>(&value), stored, sizeof(T));
+                Format(value, out);
+            };
+            std::memcpy(record.payload, &payload, sizeof(T));
+        });
+    }
+
+    /**
+     * @brief Sets what happens to records logged while the ring is full. Defaults to dropping them.
+     */
+    void SetOverflowPolicy(LogOverflowPolicy policy);
+
+    /**
+     * @brief Sets when the log file is rotated, taking effect with the next records written.
+     */
+    void SetRotationPolicy(const LogRotationPolicy& policy);
+
+    /**
+     * @brief Returns the number of times the log file has been rotated.
+     */
+    uint64_t Rotations() const { return rotations_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the number of records dropped because the ring was full.
+     */
+    uint64_t DroppedRecords() const { return dropped_records_.load(std::memory_order_relaxed); }
 
     /**
-     * @brief Destructor that closes the log file.
+     * @brief Blocks until every record logged before the call has been written to the file.
+     */
+    void Flush();
+
+    /**
+     * @brief Destructor that writes the remaining records and closes the log file.
      */
     ~Logger();
 
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
-    Logger(Logger&&) noexcept = default;
-    Logger& operator=(Logger&&) noexcept = default;
 
     /**
      * @brief Returns the singleton instance of the logger.
@@ -53,24 +165,105 @@ public:
 
 private:
     /**
-     * @brief Constructs the logger and opens the file for writing log lines to.
+     * @brief Constructs the logger, opens the file for writing log lines to and starts the log thread.
      *
      * If the folder or file do not exist, they will be created.
      */
     Logger(const std::string& logFileName);
 
+    Sync::MpscRing<LogRecord, LOG_RING_CAPACITY> ring_; ///< Records waiting for the log thread.
+    std::atomic<LogOverflowPolicy> overflow_policy_{LogOverflowPolicy::Drop};
+    std::atomic<uint64_t> dropped_records_{0};
+    std::atomic<bool> log_thread_waiting_{false};
+    std::atomic<uint64_t> rotations_{0};
+
+    std::mutex mutex_;
+    std::condition_variable wake_condition_; ///< Wakes the log thread.
+    std::condition_variable flushed_condition_; ///< Signals Flush callers.
+    uint64_t flush_requested_ = 0;
+    uint64_t flushed_ = 0;
+    bool stopping_ = false;
+    LogRotationPolicy rotation_policy_;
+    std::thread thread_;
+
+    // Only used by the log thread
     std::ofstream log_file_; ///< The log file stream.
     std::string log_file_path_; ///< The path to the log file.
+    std::string log_file_stem_; ///< The path to the log file without its extension.
+    std::string log_file_extension_;
+    std::chrono::system_clock::time_point log_file_opened_; ///< Start of the current generation.
+    uint64_t reported_dropped_records_ = 0;
+    std::time_t timestamp_second_ = 0;
+    char timestamp_[32] = {};
+
+    void Log(LogLevel level, std::string message);
+
+    template <typename Fill>
+    void Push(Fill&& fill);
+
+    void WakeLogThread();
+
+    /**
+     * @brief Runs on the log thread, writing records until the logger is destroyed.
+     */
+    void Run();
+
+    /**
+     * @brief Writes all records currently in the ring.
+     * @return True if anything was written.
+     */
+    bool WriteRecords();
 
     /**
      * @brief Writes a log message to the file with the specified log type.
-     * @param type The log type, such as [INFO], [DEBUG], [WARNING], or [ERROR].
-     * @param message The log message.
+     * @param record The record to write.
+     */
+    void WriteLog(const LogRecord& record);
+
+    /**
+     * @brief Rotates the log file once it exceeds the size or age limit of a policy.
+     */
+    void RotateIfNeeded(const LogRotationPolicy& policy);
+
+    /**
+     * @brief Closes the log file, shifts every retained generation up by one, dropping the oldest, and starts a
+     * new log file.
      */
-    void WriteLog(const std::string& type, const std::string& message);
+    void Rotate(int retained_generations);
+
+    std::string GenerationPath(int generation) const;
+
+    const char* Timestamp(std::chrono::system_clock::time_point time);
 };
 
+template <typename Fill>
+void Logger::Push(Fill&& fill)
+{
+    while (!ring_.TryPush(fill))
+    {
+        if (overflow_policy_.load(std::memory_order_relaxed) == LogOverflowPolicy::Drop)
+        {
+            dropped_records_.fetch_add(1, std::memory_order_relaxed);
+
+            // A log thread that is not waiting is already draining the full ring, so a burst of drops does not
+            // take the mutex for every record
+            if (log_thread_waiting_.load(std::memory_order_relaxed))
+                WakeLogThread();
+            return;
+        }
+
+        WakeLogThread();
+        std::this_thread::yield();
+    }
+
+    // Pairs with the fence in Run, so that either the log thread sees the record or this sees it waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (log_thread_waiting_.load(std::memory_order_relaxed))
+        WakeLogThread();
+}
+
 #define INFO(msg)       Logger::GetInstance().Info(msg)
 #define DEBUG(msg)      Logger::GetInstance().Debug(msg)
 #define WARNING(msg)    Logger::GetInstance().Warning(msg)
 #define ERROR(msg)      Logger::GetInstance().Error(msg)
+#define DEBUG_DEFERRED(format, payload) Logger::GetInstance().Deferred<format>(LogLevel::Debug, payload)
@@ -0,0 +1,55 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Metrics
+{
+    void HistogramSnapshot::Merge(const HistogramSnapshot& other)
+    {
+        for (size_t i = 0; i < counts.size(); i++)
+            counts[i] += other.counts[i];
+        total += other.total;
+        max = std::max(max, other.max);
+    }
+
+    uint64_t HistogramSnapshot::Percentile(const double percentile) const
+    {
+        if (total == 0)
+            return 0;
+
+        // The rank of the value, counting from 1
+        const double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total))));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            seen += counts[i];
+            if (seen < rank)
+                continue;
+
+            const uint64_t bucket_end = i + 1 < counts.size() ? HistogramBucketStart(i + 1) - 1 : UINT64_MAX;
+            return std::min(bucket_end, max);
+        }
+        return max;
+    }
+
+    HistogramSnapshot LatencyHistogram::Snapshot() const
+    {
+        HistogramSnapshot snapshot;
+        for (size_t i = 0; i < counts_.size(); i++)
+        {
+            snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+            snapshot.total += snapshot.counts[i];
+        }
+        snapshot.max = max_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void LatencyHistogram::Reset()
+    {
+        for (auto& count : counts_)
+            count.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "../data/bit_utils.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Metrics
+{
+    constexpr auto HISTOGRAM_SUB_BUCKET_BITS = 4;
+    constexpr auto HISTOGRAM_SUB_BUCKETS = 1 << HISTOGRAM_SUB_BUCKET_BITS;
+    constexpr auto HISTOGRAM_BUCKETS = (64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS;
+
+    /**
+     * \brief Returns the log-linear bucket of a value. Values below HISTOGRAM_SUB_BUCKETS have a bucket each, above
+     * that every power of two is split into HISTOGRAM_SUB_BUCKETS linear buckets, which bounds the relative error
+     * of a bucket to 1 / HISTOGRAM_SUB_BUCKETS.
+     */
+    inline size_t HistogramBucket(const uint64_t value)
+    {
+        if (value < HISTOGRAM_SUB_BUCKETS)
+            return static_cast<size_t>(value);
+
+        const int shift = HighestSetBit(value) - HISTOGRAM_SUB_BUCKET_BITS;
+        return static_cast<size_t>(shift + 1) * HISTOGRAM_SUB_BUCKETS +
+            static_cast<size_t>(value >> shift & (HISTOGRAM_SUB_BUCKETS - 1));
+    }
+
+    /**
+     * \brief Returns the smallest value that falls into a bucket.
+     */
+    inline uint64_t HistogramBucketStart(const size_t bucket)
+    {
+        if (bucket < HISTOGRAM_SUB_BUCKETS * 2)
+            return bucket;
+
+        const size_t shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+        const uint64_t sub_bucket = bucket % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS;
+        return sub_bucket << shift;
+    }
+
+    /**
+     * \brief A copy of the counts of a histogram, which percentiles are computed from.
+     */
+    struct HistogramSnapshot
+    {
+        std::array<uint64_t, HISTOGRAM_BUCKETS> counts{};
+        uint64_t total = 0;
+        uint64_t max = 0;
+
+        /**
+         * \brief Adds the counts of another snapshot, e.g. of the same measurement taken on another thread.
+         */
+        void Merge(const HistogramSnapshot& other);
+
+        /**
+         * \brief Returns the value below which the given fraction of the recorded values fall, as the upper end of
+         * its bucket, but no more than the largest value recorded. Returns 0 if nothing was recorded.
+         * \param percentile The percentile, between 0 and 100.
+         */
+        uint64_t Percentile(double percentile) const;
+    };
+
+    /**
+     * \brief A fixed-size log-linear histogram of latencies, or any other unsigned values.
+     *
+     * Recording is lock-free and wait-free: each thread records into histograms of its own, with plain relaxed
+     * stores rather than atomic read-modify-write instructions. Any thread may take a snapshot at any time.
+     */
+    class LatencyHistogram
+    {
+    public:
+        /**
+         * \brief Records a value. Must only be called from the thread owning the histogram.
+         */
+        void Record(const uint64_t value)
+        {
+            std::atomic<uint64_t>& count = counts_[HistogramBucket(value)];
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            if (value > max_.load(std::memory_order_relaxed))
+                max_.store(value, std::memory_order_relaxed);
+        }
+
+        /**
+         * \brief Copies the counts. Counts recorded while the copy is taken may or may not be included.
+         */
+        HistogramSnapshot Snapshot() const;
+
+        /**
+         * \brief Clears the counts. Must only be called from the thread owning the histogram.
+         */
+        void Reset();
+
+    private:
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> counts_{};
+        std::atomic<uint64_t> max_{0};
+    };
+}
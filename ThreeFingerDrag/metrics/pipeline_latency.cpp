@@ -0,0 +1,63 @@
+#include "pipeline_latency.h"
+#include <iomanip>
+#include <sstream>
+
+namespace Metrics
+{
+    StageLatency PipelineLatency::Percentiles(const LatencyStage stage) const
+    {
+        const HistogramSnapshot snapshot = Snapshot(stage);
+        return {
+            snapshot.total,
+            TickClock::ToNanoseconds(snapshot.Percentile(50)),
+            TickClock::ToNanoseconds(snapshot.Percentile(99)),
+            TickClock::ToNanoseconds(snapshot.Percentile(99.9)),
+            TickClock::ToNanoseconds(snapshot.max)
+        };
+    }
+
+    std::string PipelineLatency::Summary() const
+    {
+        std::ostringstream summary;
+        summary << std::fixed << std::setprecision(1);
+
+        for (size_t i = 0; i < LATENCY_STAGE_COUNT; i++)
+        {
+            const auto stage = static_cast<LatencyStage>(i);
+            const StageLatency latency = Percentiles(stage);
+            summary << std::left << std::setw(10) << StageName(stage) << std::right
+                << " n=" << latency.count
+                << " p50=" << latency.p50 / 1000.0 << "us"
+                << " p99=" << latency.p99 / 1000.0 << "us"
+                << " p99.9=" << latency.p999 / 1000.0 << "us"
+                << " max=" << latency.max / 1000.0 << "us\n";
+        }
+        return summary.str();
+    }
+
+    void PipelineLatency::Reset()
+    {
+        for (auto& histogram : histograms_)
+            histogram.Reset();
+    }
+
+    const char* PipelineLatency::StageName(const LatencyStage stage)
+    {
+        switch (stage)
+        {
+        case LatencyStage::Receive:
+            return "receive";
+        case LatencyStage::Decode:
+            return "decode";
+        case LatencyStage::Track:
+            return "track";
+        case LatencyStage::Gesture:
+            return "gesture";
+        case LatencyStage::Output:
+            return "output";
+        case LatencyStage::EndToEnd:
+            return "end-to-end";
+        }
+        return "unknown";
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "latency_histogram.h"
+#include "tick_clock.h"
+#include <string>
+
+namespace Metrics
+{
+    /**
+     * \brief The stages a batch of touchpad reports passes through on the input thread.
+     */
+    enum class LatencyStage : uint8_t
+    {
+        Receive, ///< Retrieving the raw input of a WM_INPUT message and draining the queued input.
+        Decode, ///< Decoding and assembling a single report.
+        Track, ///< Merging a frame into the tracked contacts.
+        Gesture, ///< A single step of the gesture engine.
+        Output, ///< Injecting the commands of a step.
+        EndToEnd ///< From the start of receiving a batch until a step of it has injected its commands.
+    };
+
+    constexpr auto LATENCY_STAGE_COUNT = 6;
+
+    /**
+     * \brief Percentiles of a single stage, in nanoseconds.
+     */
+    struct StageLatency
+    {
+        uint64_t count;
+        double p50;
+        double p99;
+        double p999;
+        double max;
+    };
+
+    /**
+     * \brief Latency histograms of every stage of the touch pipeline, measured in TickClock ticks. Recorded by the
+     * input thread only, and readable from any thread.
+     */
+    class PipelineLatency
+    {
+    public:
+        void Record(const LatencyStage stage, const uint64_t ticks)
+        {
+            histograms_[static_cast<size_t>(stage)].Record(ticks);
+        }
+
+        HistogramSnapshot Snapshot(const LatencyStage stage) const
+        {
+            return histograms_[static_cast<size_t>(stage)].Snapshot();
+        }
+
+        /**
+         * \brief Returns the percentiles of a stage converted to nanoseconds.
+         */
+        StageLatency Percentiles(LatencyStage stage) const;
+
+        /**
+         * \brief Returns a line per stage with its count, p50, p99, p99.9 and max, for the log.
+         */
+        std::string Summary() const;
+
+        /**
+         * \brief Clears all stages. Must only be called from the input thread.
+         */
+        void Reset();
+
+        static const char* StageName(LatencyStage stage);
+
+    private:
+        std::array<LatencyHistogram, LATENCY_STAGE_COUNT> histograms_;
+    };
+}
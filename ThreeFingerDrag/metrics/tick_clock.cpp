@@ -0,0 +1,41 @@
+#include "tick_clock.h"
+#include <thread>
+
+namespace Metrics
+{
+#ifdef TFD_TICK_CLOCK_TSC
+    namespace
+    {
+        struct ClockSample
+        {
+            uint64_t ticks;
+            std::chrono::steady_clock::time_point time;
+
+            static ClockSample Take()
+            {
+                return {TickClock::Now(), std::chrono::steady_clock::now()};
+            }
+        };
+
+        // Taken during static initialization, so that calibration can usually measure over the process lifetime
+        const ClockSample origin = ClockSample::Take();
+    }
+#endif
+
+    double TickClock::NanosecondsPerTick()
+    {
+#ifdef TFD_TICK_CLOCK_TSC
+        static const double nanoseconds_per_tick = []
+        {
+            std::this_thread::sleep_until(origin.time + std::chrono::milliseconds(CALIBRATION_PERIOD_MS));
+
+            const ClockSample now = ClockSample::Take();
+            const auto elapsed = std::chrono::duration<double, std::nano>(now.time - origin.time).count();
+            return elapsed / static_cast<double>(now.ticks - origin.ticks);
+        }();
+        return nanoseconds_per_tick;
+#else
+        return 1.0;
+#endif
+    }
+}
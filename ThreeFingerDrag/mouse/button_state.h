@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace Touchpad
+{
+    /**
+     * \brief Returns true if the left mouse button is currently held down, as seen by the system.
+     */
+    using ButtonQuery = bool (*)();
+
+    /**
+     * \brief The mouse button state injected by an output sink. The sink updates it as it sends button commands
+     * from the input thread, while any thread may read it with a single atomic load.
+     */
+    class ButtonState
+    {
+    public:
+        bool IsLeftDown() const { return left_down_.load(std::memory_order_acquire); }
+
+        /**
+         * \brief Records an injected left button change. Must only be called from the thread sending the commands.
+         */
+        void SetLeftDown(const bool down)
+        {
+            left_down_.store(down, std::memory_order_release);
+            changes_.store(changes_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * \brief Returns the number of injected button changes, to tell whether any were sent since an earlier call.
+         */
+        uint64_t Changes() const { return changes_.load(std::memory_order_relaxed); }
+
+        /**
+         * \brief Adopts the button state observed in the system, for example after a physical click released the
+         * button while a gesture was holding it. Must only be called from the thread sending the commands.
+         * \param observed_down True if the system reports the left button as held down.
+         * \return True if the observed state differed from the injected one.
+         */
+        bool Reconcile(const bool observed_down)
+        {
+            if (observed_down == IsLeftDown())
+                return false;
+
+            left_down_.store(observed_down, std::memory_order_release);
+            reconciliations_.store(reconciliations_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /**
+         * \brief Returns the number of times the state had to be corrected by Reconcile.
+         */
+        uint64_t Reconciliations() const { return reconciliations_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<bool> left_down_{false};
+        std::atomic<uint64_t> changes_{0};
+        std::atomic<uint64_t> reconciliations_{0};
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "button_state.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Touchpad
+{
+    enum class OutputCommandType : uint8_t
+    {
+        MoveCursor,
+        LeftButtonDown,
+        LeftButtonUp
+    };
+
+    /**
+     * \brief A single mouse command. The deltas are only used by MoveCursor.
+     */
+    struct OutputCommand
+    {
+        OutputCommandType type;
+        double delta_x;
+        double delta_y;
+    };
+
+    /**
+     * \brief Receives the mouse commands produced by the gesture engine and injects them into the system.
+     */
+    class OutputSink
+    {
+    public:
+        virtual ~OutputSink() = default;
+
+        /**
+         * \brief Sends the commands of one frame, in order, as a single batch. Button commands update Buttons.
+         * \param commands The commands to send.
+         * \param count Number of commands.
+         */
+        virtual void Send(const OutputCommand* commands, size_t count) = 0;
+
+        /**
+         * \brief Returns the button state injected by this sink.
+         */
+        ButtonState& Buttons() { return buttons_; }
+        const ButtonState& Buttons() const { return buttons_; }
+
+    protected:
+        ButtonState buttons_;
+    };
+}
@@ -0,0 +1,29 @@
+#include "recording_sink.h"
+
+namespace Touchpad
+{
+    RecordingSink::RecordingSink(const size_t capacity)
+    {
+        commands_.reserve(capacity);
+    }
+
+    void RecordingSink::Send(const OutputCommand* commands, const size_t count)
+    {
+        commands_.insert(commands_.end(), commands, commands + count);
+        flushes_++;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (commands[i].type == OutputCommandType::LeftButtonDown)
+                buttons_.SetLeftDown(true);
+            else if (commands[i].type == OutputCommandType::LeftButtonUp)
+                buttons_.SetLeftDown(false);
+        }
+    }
+
+    void RecordingSink::Clear()
+    {
+        commands_.clear();
+        flushes_ = 0;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "output_sink.h"
+#include <vector>
+
+namespace Touchpad
+{
+    /**
+     * \brief Keeps the commands it is sent in memory instead of injecting them, for replays and benchmarks.
+     */
+    class RecordingSink : public OutputSink
+    {
+    public:
+        /**
+         * \param capacity Number of commands to reserve room for up front.
+         */
+        explicit RecordingSink(size_t capacity = 0);
+
+        void Send(const OutputCommand* commands, size_t count) override;
+
+        const std::vector<OutputCommand>& Commands() const { return commands_; }
+
+        /**
+         * \brief Returns the number of batches sent.
+         */
+        size_t Flushes() const { return flushes_; }
+
+        void Clear();
+
+    private:
+        std::vector<OutputCommand> commands_;
+        size_t flushes_ = 0;
+    };
+}
@@ -0,0 +1,69 @@
+#include "send_input_sink.h"
+#include "../framework.h"
+#include "../logging/logger.h"
+#include <array>
+
+namespace Touchpad
+{
+    namespace
+    {
+        INPUT MouseInput(const DWORD flags, const LONG dx = 0, const LONG dy = 0)
+        {
+            INPUT input = {};
+            input.type = INPUT_MOUSE;
+            input.mi.dx = dx;
+            input.mi.dy = dy;
+            input.mi.dwFlags = flags;
+            return input;
+        }
+
+        bool Flush(INPUT* inputs, size_t& count)
+        {
+            const UINT sent = SendInput(static_cast<UINT>(count), inputs, sizeof(INPUT));
+            const bool all_sent = sent == count;
+            count = 0;
+
+            if (!all_sent)
+                ERROR("SendInput could not inject all mouse input.");
+            return all_sent;
+        }
+    }
+
+    void SendInputSink::Send(const OutputCommand* commands, const size_t count)
+    {
+        std::array<INPUT, MAX_BATCHED_INPUTS> inputs;
+        size_t input_count = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const OutputCommand& command = commands[i];
+            switch (command.type)
+            {
+            case OutputCommandType::MoveCursor:
+                {
+                    // Relative mouse move of the whole pixels, keeping the fraction for the next move
+                    int32_t pixels_x;
+                    int32_t pixels_y;
+                    if (subpixel_.Take(command.delta_x, command.delta_y, pixels_x, pixels_y))
+                        inputs[input_count++] = MouseInput(MOUSEEVENTF_MOVE, pixels_x, pixels_y);
+                }
+                break;
+            case OutputCommandType::LeftButtonDown:
+                inputs[input_count++] = MouseInput(MOUSEEVENTF_LEFTDOWN);
+                buttons_.SetLeftDown(true);
+                break;
+            case OutputCommandType::LeftButtonUp:
+                inputs[input_count++] = MouseInput(MOUSEEVENTF_LEFTUP);
+                buttons_.SetLeftDown(false);
+                subpixel_.Reset();
+                break;
+            }
+
+            if (input_count == inputs.size() && !Flush(inputs.data(), input_count))
+                return;
+        }
+
+        if (input_count > 0)
+            Flush(inputs.data(), input_count);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "output_sink.h"
+#include "subpixel_accumulator.h"
+
+namespace Touchpad
+{
+    constexpr auto MAX_BATCHED_INPUTS = 8;
+
+    /**
+     * \brief Injects mouse commands through SendInput, packing the commands of a frame into a single call.
+     * Moves are sent in whole pixels, with the sub-pixel remainder carried into the next move.
+     */
+    class SendInputSink : public OutputSink
+    {
+    public:
+        void Send(const OutputCommand* commands, size_t count) override;
+
+    private:
+        SubpixelAccumulator subpixel_;
+    };
+}
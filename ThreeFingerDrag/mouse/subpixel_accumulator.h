@@ -0,0 +1,54 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+namespace Touchpad
+{
+    constexpr int64_t SUBPIXEL_SCALE = 1 << 16;
+
+    /**
+     * \brief Converts fractional cursor deltas to whole pixels, carrying the sub-pixel remainder of each axis in
+     * fixed point into the next move so that slow movement is not lost to truncation.
+     */
+    class SubpixelAccumulator
+    {
+    public:
+        /**
+         * \brief Adds a delta and takes the whole pixels accumulated so far.
+         * \param delta_x The horizontal delta in pixels.
+         * \param delta_y The vertical delta in pixels.
+         * \param pixels_x Receives the whole pixels to move horizontally.
+         * \param pixels_y Receives the whole pixels to move vertically.
+         * \return True if there is any whole pixel movement.
+         */
+        bool Take(const double delta_x, const double delta_y, int32_t& pixels_x, int32_t& pixels_y)
+        {
+            pixels_x = TakeAxis(residual_x_, delta_x);
+            pixels_y = TakeAxis(residual_y_, delta_y);
+            return pixels_x != 0 || pixels_y != 0;
+        }
+
+        /**
+         * \brief Drops the carried remainder, for example when a drag ends.
+         */
+        void Reset()
+        {
+            residual_x_ = 0;
+            residual_y_ = 0;
+        }
+
+    private:
+        static int32_t TakeAxis(int64_t& residual, const double delta)
+        {
+            residual += std::llround(delta * SUBPIXEL_SCALE);
+
+            // Truncate towards zero, so the remainder keeps the sign of the movement
+            const int64_t pixels = residual / SUBPIXEL_SCALE;
+            residual -= pixels * SUBPIXEL_SCALE;
+            return static_cast<int32_t>(pixels);
+        }
+
+        int64_t residual_x_ = 0;
+        int64_t residual_y_ = 0;
+    };
+}
@@ -0,0 +1,118 @@
+#include "uinput_sink.h"
+
+#ifdef __linux__
+#include "../logging/logger.h"
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace Touchpad
+{
+    namespace
+    {
+        constexpr auto MAX_EVENTS_PER_WRITE = 32;
+        constexpr auto MAX_EVENTS_PER_COMMAND = 3;
+
+        void Emit(input_event* events, size_t& count, const uint16_t type, const uint16_t code, const int32_t value)
+        {
+            input_event& event = events[count++];
+            std::memset(&event, 0, sizeof(event));
+            event.type = type;
+            event.code = code;
+            event.value = value;
+        }
+    }
+
+    UinputSink::UinputSink(const char* device_path)
+    {
+        fd_ = open(device_path, O_WRONLY | O_NONBLOCK);
+        if (fd_ < 0)
+        {
+            ERROR("Could not open the uinput device.");
+            return;
+        }
+
+        uinput_setup setup = {};
+        setup.id.bustype = BUS_VIRTUAL;
+        std::strncpy(setup.name, UINPUT_DEVICE_NAME, UINPUT_MAX_NAME_SIZE - 1);
+
+        const bool created = ioctl(fd_, UI_SET_EVBIT, EV_KEY) >= 0 &&
+            ioctl(fd_, UI_SET_KEYBIT, BTN_LEFT) >= 0 &&
+            ioctl(fd_, UI_SET_EVBIT, EV_REL) >= 0 &&
+            ioctl(fd_, UI_SET_RELBIT, REL_X) >= 0 &&
+            ioctl(fd_, UI_SET_RELBIT, REL_Y) >= 0 &&
+            ioctl(fd_, UI_DEV_SETUP, &setup) >= 0 &&
+            ioctl(fd_, UI_DEV_CREATE) >= 0;
+
+        if (!created)
+        {
+            ERROR("Could not create the uinput virtual mouse.");
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    UinputSink::~UinputSink()
+    {
+        if (fd_ < 0)
+            return;
+
+        ioctl(fd_, UI_DEV_DESTROY);
+        close(fd_);
+    }
+
+    void UinputSink::Send(const OutputCommand* commands, const size_t count)
+    {
+        if (fd_ < 0)
+            return;
+
+        std::array<input_event, MAX_EVENTS_PER_WRITE> events;
+        size_t event_count = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const OutputCommand& command = commands[i];
+            switch (command.type)
+            {
+            case OutputCommandType::MoveCursor:
+                {
+                    int32_t pixels_x;
+                    int32_t pixels_y;
+                    if (!subpixel_.Take(command.delta_x, command.delta_y, pixels_x, pixels_y))
+                        break;
+                    if (pixels_x != 0)
+                        Emit(events.data(), event_count, EV_REL, REL_X, pixels_x);
+                    if (pixels_y != 0)
+                        Emit(events.data(), event_count, EV_REL, REL_Y, pixels_y);
+                }
+                break;
+            case OutputCommandType::LeftButtonDown:
+                Emit(events.data(), event_count, EV_KEY, BTN_LEFT, 1);
+                buttons_.SetLeftDown(true);
+                break;
+            case OutputCommandType::LeftButtonUp:
+                Emit(events.data(), event_count, EV_KEY, BTN_LEFT, 0);
+                buttons_.SetLeftDown(false);
+                subpixel_.Reset();
+                break;
+            }
+
+            // Close the report of this command, unless it produced no events
+            if (event_count > 0 && events[event_count - 1].type != EV_SYN)
+                Emit(events.data(), event_count, EV_SYN, SYN_REPORT, 0);
+
+            // Flush when the next command might not fit, or after the last command
+            if (event_count > 0 && (event_count + MAX_EVENTS_PER_COMMAND > events.size() || i + 1 == count))
+            {
+                const auto size = static_cast<ssize_t>(event_count * sizeof(input_event));
+                if (write(fd_, events.data(), event_count * sizeof(input_event)) != size)
+                    ERROR("Could not write all events to the uinput device.");
+                event_count = 0;
+            }
+        }
+    }
+}
+#endif
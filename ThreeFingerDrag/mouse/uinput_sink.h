@@ -0,0 +1,36 @@
+#pragma once
+#include "output_sink.h"
+#include "subpixel_accumulator.h"
+
+namespace Touchpad
+{
+    constexpr auto UINPUT_DEVICE_PATH = "/dev/uinput";
+    constexpr auto UINPUT_DEVICE_NAME = "ThreeFingerDrag virtual mouse";
+
+    /**
+     * \brief Injects mouse commands through a Linux uinput virtual mouse, writing the events of a frame with a single
+     * write call. Each command is followed by its own synchronization event so that consumers see them in order.
+     * Moves are sent in whole pixels, with the sub-pixel remainder carried into the next move.
+     */
+    class UinputSink : public OutputSink
+    {
+    public:
+        /**
+         * \brief Creates the virtual mouse. Sending is a no-op if it could not be created.
+         * \param device_path Path of the uinput device node.
+         */
+        explicit UinputSink(const char* device_path = UINPUT_DEVICE_PATH);
+        ~UinputSink() override;
+
+        UinputSink(const UinputSink& other) = delete;
+        UinputSink& operator=(const UinputSink& other) = delete;
+
+        bool IsOpen() const { return fd_ >= 0; }
+
+        void Send(const OutputCommand* commands, size_t count) override;
+
+    private:
+        int fd_ = -1;
+        SubpixelAccumulator subpixel_;
+    };
+}
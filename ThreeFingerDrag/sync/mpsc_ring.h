@@ -0,0 +1,107 @@
+#pragma once
+#include "spsc_queue.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Sync
+{
+    /**
+     * \brief A bounded lock-free ring between any number of producer threads and one consumer thread.
+     *
+     * Every slot carries a sequence number telling whose turn it is: producers claim the next slot with a single
+     * compare-and-swap and fill it in place, then publish it by advancing its sequence. Elements are never copied
+     * through the ring, and slots keep their element between uses, so elements can reuse their storage.
+     *
+     * \tparam T The element type, default constructible.
+     * \tparam Capacity Maximum number of queued elements, a power of two.
+     */
+    template <typename T, size_t Capacity>
+    class MpscRing
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+    public:
+        MpscRing()
+        {
+            for (size_t i = 0; i < Capacity; i++)
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        /**
+         * \brief Claims the next slot and fills it in place. May be called from any thread.
+         * \param fill Called with the element of the claimed slot, only if a slot could be claimed.
+         * \return False if the ring is full.
+         */
+        template <typename Fill>
+        bool TryPush(Fill&& fill)
+        {
+            size_t position = tail_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Slot& slot = slots_[position & (Capacity - 1)];
+                const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<intptr_t>(sequence - position);
+
+                if (difference == 0)
+                {
+                    // The slot is free for this position; claim it unless another producer got there first
+                    if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        fill(slot.value);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    // The consumer has not read the element a lap behind yet
+                    return false;
+                }
+                else
+                {
+                    position = tail_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * \brief Hands the oldest element to a function and frees its slot. Must only be called from the consumer
+         * thread.
+         * \param consume Called with the element, only if one is available.
+         * \return False if the ring is empty, or its oldest slot is still being filled.
+         */
+        template <typename Consume>
+        bool TryPop(Consume&& consume)
+        {
+            Slot& slot = slots_[head_ & (Capacity - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != head_ + 1)
+                return false;
+
+            consume(slot.value);
+            slot.sequence.store(head_ + Capacity, std::memory_order_release);
+            head_++;
+            return true;
+        }
+
+        /**
+         * \brief Returns true if TryPop would find no element. Must only be called from the consumer thread.
+         */
+        bool Empty() const
+        {
+            return slots_[head_ & (Capacity - 1)].sequence.load(std::memory_order_acquire) != head_ + 1;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            T value{};
+        };
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0}; ///< Next position to claim, shared by producers.
+        alignas(CACHE_LINE_SIZE) size_t head_ = 0; ///< Next position to read, owned by the consumer.
+        alignas(CACHE_LINE_SIZE) std::array<Slot, Capacity> slots_;
+    };
+}
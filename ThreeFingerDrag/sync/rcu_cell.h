@@ -0,0 +1,186 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Sync
+{
+    /**
+     * \brief Publishes immutable values to reader threads by swapping a pointer, reclaiming replaced values once
+     * every reader has passed a quiescent state (QSBR).
+     *
+     * Readers register once, then read the current value with a single acquire load and announce a quiescent state
+     * with a single store whenever they hold no reference to a value, such as at the end of a batch of input. They
+     * never lock or wait. Writers copy the current value, modify the copy and publish it; they are serialized by a
+     * mutex and free the values that no reader can still see. A reader that stops announcing quiescent states only
+     * delays that until it does.
+     *
+     * Threads that are not registered readers must use Copy, which takes the writer lock.
+     */
+    template <typename T, size_t MaxReaders = 16>
+    class RcuCell
+    {
+    public:
+        /**
+         * \brief A registered reader. Must only be used by one thread at a time.
+         */
+        class Reader
+        {
+        public:
+            explicit Reader(RcuCell& cell) : cell_(cell), slot_(cell.Register())
+            {
+            }
+
+            ~Reader() { cell_.Unregister(slot_); }
+
+            Reader(const Reader& other) = delete;
+            Reader& operator=(const Reader& other) = delete;
+
+            /**
+             * \brief Returns the current value, which stays valid until the next call to Quiescent.
+             */
+            const T& Load() const { return *cell_.current_.load(std::memory_order_acquire); }
+
+            /**
+             * \brief Announces that this reader holds no reference to any value loaded before.
+             */
+            void Quiescent() const { cell_.Quiescent(slot_); }
+
+        private:
+            RcuCell& cell_;
+            int slot_;
+        };
+
+        explicit RcuCell(const T& initial = T())
+            : current_(new T(initial))
+        {
+            for (auto& epoch : reader_epochs_)
+                epoch.store(FREE_SLOT);
+        }
+
+        ~RcuCell()
+        {
+            delete current_.load();
+            for (const auto& retired : retired_)
+                delete retired.second;
+        }
+
+        RcuCell(const RcuCell& other) = delete;
+        RcuCell& operator=(const RcuCell& other) = delete;
+
+        /**
+         * \brief Returns a copy of the current value. May be called from any thread.
+         */
+        T Copy() const
+        {
+            std::lock_guard lock(writer_mutex_);
+            return *current_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * \brief Publishes a copy of the current value after applying a modification to it. May be called from any
+         * thread; concurrent updates are applied one after the other.
+         * \param modify Called with the copy, with the writer lock held.
+         */
+        template <typename Modify>
+        void Update(Modify&& modify)
+        {
+            std::lock_guard lock(writer_mutex_);
+            auto next = std::make_unique<T>(*current_.load(std::memory_order_relaxed));
+            modify(*next);
+
+            T* previous = current_.exchange(next.release(), std::memory_order_seq_cst);
+            const uint64_t epoch = epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+            retired_.emplace_back(epoch, previous);
+            Reclaim();
+        }
+
+        /**
+         * \brief Returns the number of replaced values that readers may still see.
+         */
+        size_t RetiredCount() const
+        {
+            std::lock_guard lock(writer_mutex_);
+            return retired_.size();
+        }
+
+    private:
+        static constexpr uint64_t FREE_SLOT = 0;
+
+        int Register()
+        {
+            for (size_t i = 0; i < reader_epochs_.size(); i++)
+            {
+                // Published before the reader first loads the value, and ordered against the writer's scan of the
+                // slots, so that the writer either sees the reader or the reader sees the new value
+                uint64_t expected = FREE_SLOT;
+                if (reader_epochs_[i].compare_exchange_strong(expected, epoch_.load(), std::memory_order_seq_cst))
+                {
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    return static_cast<int>(i);
+                }
+            }
+
+            // Without a slot the reader cannot announce quiescent states, so nothing is reclaimed while it exists
+            unslotted_readers_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return -1;
+        }
+
+        void Unregister(const int slot)
+        {
+            if (slot < 0)
+                unslotted_readers_.fetch_sub(1);
+            else
+                reader_epochs_[slot].store(FREE_SLOT, std::memory_order_release);
+        }
+
+        void Quiescent(const int slot)
+        {
+            if (slot >= 0)
+                reader_epochs_[slot].store(epoch_.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        /**
+         * \brief Frees the retired values that every reader has passed. Called with the writer lock held.
+         */
+        void Reclaim()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (unslotted_readers_.load() > 0)
+                return;
+
+            uint64_t oldest = UINT64_MAX;
+            for (const auto& epoch : reader_epochs_)
+            {
+                const uint64_t value = epoch.load(std::memory_order_acquire);
+                if (value != FREE_SLOT && value < oldest)
+                    oldest = value;
+            }
+
+            // A value retired at epoch E was replaced before E was published, so readers at E or later cannot see it
+            size_t kept = 0;
+            for (auto& retired : retired_)
+            {
+                if (retired.first <= oldest)
+                    delete retired.second;
+                else
+                    retired_[kept++] = retired;
+            }
+            retired_.resize(kept);
+        }
+
+        std::atomic<T*> current_;
+        std::atomic<uint64_t> epoch_{1};
+        std::array<std::atomic<uint64_t>, MaxReaders> reader_epochs_;
+        std::atomic<int> unslotted_readers_{0};
+
+        mutable std::mutex writer_mutex_;
+        std::vector<std::pair<uint64_t, T*>> retired_;
+    };
+}
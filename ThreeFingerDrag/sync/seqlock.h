@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Sync
+{
+    /**
+     * \brief Publishes a value from a single writer thread to any number of reader threads without locking.
+     *
+     * The writer never waits. Readers retry while a write is in progress, so they always observe a complete value.
+     * The value is stored as atomic words, which keeps concurrent reads and writes free of data races.
+     */
+    template <typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "SeqLock values must be trivially copyable.");
+
+    public:
+        SeqLock() = default;
+
+        explicit SeqLock(const T& value)
+        {
+            Store(value);
+        }
+
+        /**
+         * \brief Publishes a new value. Must only be called from the writer thread.
+         */
+        void Store(const T& value)
+        {
+            std::array<uint64_t, WORD_COUNT> buffer{};
+            std::memcpy(buffer.data(), &value, sizeof(T));
+
+            const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < WORD_COUNT; i++)
+                words_[i].store(buffer[i], std::memory_order_relaxed);
+
+            sequence_.store(sequence + 2, std::memory_order_release);
+        }
+
+        /**
+         * \brief Returns the most recently published value. May be called from any thread.
+         */
+        T Load() const
+        {
+            std::array<uint64_t, WORD_COUNT> buffer{};
+            while (true)
+            {
+                const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+
+                // A write is in progress
+                if (sequence & 1)
+                    continue;
+
+                for (size_t i = 0; i < WORD_COUNT; i++)
+                    buffer[i] = words_[i].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) == sequence)
+                    break;
+            }
+
+            T value;
+            std::memcpy(static_cast<void*>(&value), buffer.data(), sizeof(T));
+            return value;
+        }
+
+    private:
+        static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        std::atomic<uint32_t> sequence_{0};
+        std::array<std::atomic<uint64_t>, WORD_COUNT> words_{};
+    };
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Sync
+{
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * \brief A bounded lock-free queue between exactly one producer thread and one consumer thread.
+     * \tparam T The element type.
+     * \tparam Capacity Maximum number of queued elements, a power of two.
+     */
+    template <typename T, size_t Capacity>
+    class SpscQueue
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+    public:
+        /**
+         * \brief Appends an element. Must only be called from the producer thread.
+         * \return False if the queue is full.
+         */
+        bool TryPush(const T& value)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) == Capacity)
+                return false;
+
+            slots_[tail & (Capacity - 1)] = value;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * \brief Removes the oldest element. Must only be called from the consumer thread.
+         * \return False if the queue is empty.
+         */
+        bool TryPop(T& value)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+                return false;
+
+            value = slots_[head & (Capacity - 1)];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0}; ///< Next element to read, written by the consumer.
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0}; ///< Next slot to write, written by the producer.
+        alignas(CACHE_LINE_SIZE) std::array<T, Capacity> slots_{};
+    };
+}
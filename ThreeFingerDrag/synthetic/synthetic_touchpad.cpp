@@ -0,0 +1,189 @@
+#include "synthetic_touchpad.h"
+#include "../hid/hid_usages.h"
+#include "../hid/report_descriptor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Touchpad
+{
+    namespace
+    {
+        // Short item prefixes, without their size bits
+        constexpr uint8_t ITEM_INPUT = 0x80;
+        constexpr uint8_t ITEM_COLLECTION = 0xA0;
+        constexpr uint8_t ITEM_END_COLLECTION = 0xC0;
+        constexpr uint8_t ITEM_USAGE_PAGE = 0x04;
+        constexpr uint8_t ITEM_LOGICAL_MINIMUM = 0x14;
+        constexpr uint8_t ITEM_LOGICAL_MAXIMUM = 0x24;
+        constexpr uint8_t ITEM_REPORT_SIZE = 0x74;
+        constexpr uint8_t ITEM_REPORT_ID = 0x84;
+        constexpr uint8_t ITEM_REPORT_COUNT = 0x94;
+        constexpr uint8_t ITEM_USAGE = 0x08;
+
+        constexpr uint8_t COLLECTION_APPLICATION = 0x01;
+        constexpr uint8_t COLLECTION_LOGICAL = 0x02;
+        constexpr uint8_t INPUT_DATA_VARIABLE = 0x02;
+        constexpr uint8_t INPUT_CONSTANT_VARIABLE = 0x03;
+
+        /**
+         * \brief Appends descriptor items and keeps track of the bit offset of the next input field.
+         */
+        class DescriptorWriter
+        {
+        public:
+            explicit DescriptorWriter(std::vector<uint8_t>& bytes) : bytes_(bytes)
+            {
+            }
+
+            void Item(const uint8_t prefix, const uint32_t value)
+            {
+                if (value <= UINT8_MAX)
+                {
+                    bytes_.push_back(prefix | 1);
+                    bytes_.push_back(static_cast<uint8_t>(value));
+                }
+                else if (value <= UINT16_MAX)
+                {
+                    bytes_.push_back(prefix | 2);
+                    bytes_.push_back(static_cast<uint8_t>(value));
+                    bytes_.push_back(static_cast<uint8_t>(value >> 8));
+                }
+                else
+                {
+                    bytes_.push_back(prefix | 3);
+                    for (int i = 0; i < 4; i++)
+                        bytes_.push_back(static_cast<uint8_t>(value >> (i * 8)));
+                }
+            }
+
+            void EndCollection() { bytes_.push_back(ITEM_END_COLLECTION); }
+
+            /**
+             * \brief Declares a single input field of the given usage and returns its bit offset.
+             */
+            uint16_t Input(const uint8_t usage, const uint32_t bits, const uint32_t logical_maximum)
+            {
+                Item(ITEM_LOGICAL_MAXIMUM, logical_maximum);
+                Item(ITEM_REPORT_SIZE, bits);
+                Item(ITEM_USAGE, usage);
+                Item(ITEM_INPUT, INPUT_DATA_VARIABLE);
+                return Advance(bits);
+            }
+
+            void Padding(const uint32_t bits)
+            {
+                Item(ITEM_REPORT_SIZE, bits);
+                Item(ITEM_INPUT, INPUT_CONSTANT_VARIABLE);
+                Advance(bits);
+            }
+
+            uint32_t BitOffset() const { return bit_offset_; }
+
+        private:
+            uint16_t Advance(const uint32_t bits)
+            {
+                const auto offset = static_cast<uint16_t>(bit_offset_);
+                bit_offset_ += bits;
+                return offset;
+            }
+
+            std::vector<uint8_t>& bytes_;
+            uint32_t bit_offset_ = 8; ///< Fields start after the report ID byte.
+        };
+
+        void InsertBits(uint8_t* report, const uint32_t bit_offset, const uint32_t bit_width, const uint32_t value)
+        {
+            for (uint32_t i = 0; i < bit_width; i++)
+            {
+                const uint32_t bit = bit_offset + i;
+                if (value >> i & 1)
+                    report[bit / 8] |= static_cast<uint8_t>(1u << bit % 8);
+            }
+        }
+    }
+
+    SyntheticTouchpad::SyntheticTouchpad(const SyntheticTouchpadConfig& config)
+        : config_(config)
+    {
+        if (config_.slots < 1 || config_.slots > MAX_REPORT_SLOTS || config_.width < 1 || config_.height < 1 ||
+            config_.width > INT16_MAX || config_.height > INT16_MAX)
+            return;
+
+        BuildDescriptor();
+        valid_ = CompileReportDescriptor(descriptor_.data(), descriptor_.size(), layout_);
+    }
+
+    void SyntheticTouchpad::BuildDescriptor()
+    {
+        DescriptorWriter writer(descriptor_);
+        writer.Item(ITEM_USAGE_PAGE, USAGE_PAGE_DIGITIZER_INFO);
+        writer.Item(ITEM_USAGE, USAGE_DIGITIZER_TOUCH_PAD);
+        writer.Item(ITEM_COLLECTION, COLLECTION_APPLICATION);
+        writer.Item(ITEM_REPORT_ID, SYNTHETIC_REPORT_ID);
+        writer.Item(ITEM_LOGICAL_MINIMUM, 0);
+        writer.Item(ITEM_REPORT_COUNT, 1);
+
+        for (int slot = 0; slot < config_.slots; slot++)
+        {
+            SlotOffsets offsets{};
+            writer.Item(ITEM_USAGE, USAGE_DIGITIZER_FINGER);
+            writer.Item(ITEM_COLLECTION, COLLECTION_LOGICAL);
+            offsets.confidence = writer.Input(USAGE_DIGITIZER_CONFIDENCE, 1, 1);
+            offsets.tip_switch = writer.Input(USAGE_DIGITIZER_TIP_SWITCH, 1, 1);
+            writer.Padding(2);
+            offsets.contact_id = writer.Input(USAGE_DIGITIZER_CONTACT_ID, SYNTHETIC_CONTACT_ID_BITS,
+                                              SYNTHETIC_CONTACT_ID_COUNT - 1);
+            writer.Item(ITEM_USAGE_PAGE, USAGE_PAGE_DIGITIZER_VALUES);
+            offsets.x = writer.Input(USAGE_DIGITIZER_X_COORDINATE, 16, config_.width);
+            offsets.y = writer.Input(USAGE_DIGITIZER_Y_COORDINATE, 16, config_.height);
+            writer.Item(ITEM_USAGE_PAGE, USAGE_PAGE_DIGITIZER_INFO);
+            writer.EndCollection();
+            slot_offsets_.push_back(offsets);
+        }
+
+        if (config_.scan_time)
+            scan_time_offset_ = writer.Input(USAGE_DIGITIZER_SCAN_TIME, SYNTHETIC_SCAN_TIME_BITS, UINT16_MAX);
+        contact_count_offset_ = writer.Input(USAGE_DIGITIZER_CONTACT_COUNT, 8, TOUCH_FRAME_CAPACITY);
+        writer.EndCollection();
+
+        report_size_ = (writer.BitOffset() + 7) / 8;
+    }
+
+    int SyntheticTouchpad::ReportsPerFrame(const int contact_count) const
+    {
+        return std::max(1, (contact_count + config_.slots - 1) / config_.slots);
+    }
+
+    int SyntheticTouchpad::EncodeFrame(const SyntheticContact* contacts, const int count, const uint32_t scan_time,
+                                       uint8_t* reports) const
+    {
+        const int report_count = ReportsPerFrame(count);
+        std::memset(reports, 0, report_count * report_size_);
+
+        for (int r = 0; r < report_count; r++)
+        {
+            uint8_t* report = reports + r * report_size_;
+            report[0] = SYNTHETIC_REPORT_ID;
+
+            for (int slot = 0; slot < config_.slots; slot++)
+            {
+                const int index = r * config_.slots + slot;
+                if (index >= count)
+                    break;
+
+                const SyntheticContact& contact = contacts[index];
+                const SlotOffsets& offsets = slot_offsets_[slot];
+                InsertBits(report, offsets.confidence, 1, 1);
+                InsertBits(report, offsets.tip_switch, 1, contact.on_surface ? 1 : 0);
+                InsertBits(report, offsets.contact_id, SYNTHETIC_CONTACT_ID_BITS, contact.contact_id);
+                InsertBits(report, offsets.x, 16, static_cast<uint32_t>(std::clamp(contact.x, 0, config_.width)));
+                InsertBits(report, offsets.y, 16, static_cast<uint32_t>(std::clamp(contact.y, 0, config_.height)));
+            }
+
+            if (config_.scan_time)
+                InsertBits(report, scan_time_offset_, SYNTHETIC_SCAN_TIME_BITS, scan_time);
+            InsertBits(report, contact_count_offset_, 8, r == 0 ? static_cast<uint32_t>(count) : 0);
+        }
+        return report_count;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "../hid/report_layout.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Touchpad
+{
+    constexpr uint8_t SYNTHETIC_REPORT_ID = 1;
+    constexpr auto SYNTHETIC_CONTACT_ID_BITS = 4;
+    constexpr auto SYNTHETIC_CONTACT_ID_COUNT = 1 << SYNTHETIC_CONTACT_ID_BITS;
+    constexpr auto SYNTHETIC_SCAN_TIME_BITS = 16;
+
+    /**
+     * \brief Shape of a synthetic precision touchpad.
+     */
+    struct SyntheticTouchpadConfig
+    {
+        int slots = 5; ///< Contacts per report. Frames with more contacts are split across reports (hybrid mode).
+        int width = 4000; ///< Logical maximum of X.
+        int height = 2500; ///< Logical maximum of Y.
+        bool scan_time = true; ///< True if reports carry the Scan Time usage.
+    };
+
+    /**
+     * \brief A contact of a synthetic frame, in logical units.
+     */
+    struct SyntheticContact
+    {
+        int contact_id;
+        int x;
+        int y;
+        bool on_surface;
+    };
+
+    /**
+     * \brief A precision touchpad that exists only as a report descriptor and an encoder of its input reports.
+     *
+     * The descriptor follows the layout of real precision touchpads: one report ID, a Finger collection per slot
+     * with Confidence, Tip Switch, a 4-bit Contact ID, X and Y, then Scan Time and Contact Count. Its layout is
+     * compiled by the same descriptor compiler real devices go through, while reports are encoded from the bit
+     * offsets recorded when the descriptor was built, so that decoding them checks the compiler and decoder
+     * rather than repeating them.
+     */
+    class SyntheticTouchpad
+    {
+    public:
+        explicit SyntheticTouchpad(const SyntheticTouchpadConfig& config);
+
+        /**
+         * \brief Returns false if the descriptor could not be compiled, which only happens for an invalid config.
+         */
+        bool IsValid() const { return valid_; }
+
+        const SyntheticTouchpadConfig& Config() const { return config_; }
+        const std::vector<uint8_t>& Descriptor() const { return descriptor_; }
+        const ReportLayout& Layout() const { return layout_; }
+
+        /**
+         * \brief Size of every report in bytes, including the report ID.
+         */
+        size_t ReportSize() const { return report_size_; }
+
+        /**
+         * \brief Returns the number of reports a frame with the given number of contacts is split into.
+         */
+        int ReportsPerFrame(int contact_count) const;
+
+        /**
+         * \brief Encodes a frame into ReportsPerFrame consecutive reports of ReportSize bytes. The first report
+         * carries the number of contacts of the whole frame and the following ones a contact count of zero, as
+         * in hybrid mode. All reports carry the scan time.
+         * \param contacts The contacts of the frame.
+         * \param count Number of contacts.
+         * \param scan_time Scan Time counter of the frame, in 100 microsecond units. Wraps at its field width.
+         * \param reports Receives the reports.
+         * \return The number of reports written.
+         */
+        int EncodeFrame(const SyntheticContact* contacts, int count, uint32_t scan_time, uint8_t* reports) const;
+
+    private:
+        struct SlotOffsets
+        {
+            uint16_t confidence;
+            uint16_t tip_switch;
+            uint16_t contact_id;
+            uint16_t x;
+            uint16_t y;
+        };
+
+        void BuildDescriptor();
+
+        SyntheticTouchpadConfig config_;
+        std::vector<uint8_t> descriptor_;
+        std::vector<SlotOffsets> slot_offsets_;
+        uint16_t scan_time_offset_ = 0;
+        uint16_t contact_count_offset_ = 0;
+        size_t report_size_ = 0;
+        ReportLayout layout_;
+        bool valid_ = false;
+    };
+}
@@ -0,0 +1,299 @@
+#include "trajectory_generator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Touchpad
+{
+    namespace
+    {
+        constexpr double NANOSECONDS_PER_MS = 1e6;
+        constexpr double NANOSECONDS_PER_SCAN_TICK = 1e5;
+        constexpr double PI = 3.14159265358979323846;
+    }
+
+    TrajectoryGenerator::TrajectoryGenerator(const TrajectoryScript& script)
+        : script_(script), touchpad_(script.touchpad), interval_ns_(1e9 / script.rate_hz)
+    {
+        Rewind();
+    }
+
+    void TrajectoryGenerator::Rewind()
+    {
+        runs_.assign(script_.devices, DeviceRun());
+        current_ = 0;
+        frame_handed_out_ = false;
+        frames_ = 0;
+
+        const size_t report_bytes = touchpad_.ReportsPerFrame(TOUCH_FRAME_CAPACITY) * touchpad_.ReportSize();
+        for (size_t i = 0; i < runs_.size(); i++)
+        {
+            DeviceRun& run = runs_[i];
+            run.device = SYNTHETIC_FIRST_DEVICE + i;
+            run.time_ns = interval_ns_ * static_cast<double>(i) / static_cast<double>(runs_.size());
+            run.random = script_.seed * 2654435761u + static_cast<uint32_t>(i) * 40503u + 1u;
+            run.scan_time_base = run.random >> 16;
+            run.reports.resize(report_bytes);
+        }
+
+        if (!IsValid())
+            return;
+
+        for (DeviceRun& run : runs_)
+            PrepareFrame(run);
+    }
+
+    bool TrajectoryGenerator::Next(SyntheticReport& report)
+    {
+        // The last report handed out points into the buffer of its device, so it is only reused now
+        if (frame_handed_out_)
+        {
+            PrepareFrame(runs_[current_]);
+            frame_handed_out_ = false;
+        }
+
+        // Finish the frame being handed out before switching devices, so that hybrid frames stay together
+        if (current_ >= runs_.size() || runs_[current_].next_report >= runs_[current_].report_count)
+        {
+            current_ = runs_.size();
+            for (size_t i = 0; i < runs_.size(); i++)
+            {
+                const DeviceRun& run = runs_[i];
+                if (run.next_report < run.report_count &&
+                    (current_ == runs_.size() || run.frame_time_ns < runs_[current_].frame_time_ns))
+                    current_ = i;
+            }
+            if (current_ == runs_.size())
+                return false;
+        }
+
+        DeviceRun& run = runs_[current_];
+        report.device = run.device;
+        report.arrival_time = std::chrono::steady_clock::time_point(
+            std::chrono::nanoseconds(std::llround(run.frame_time_ns)));
+        report.data = run.reports.data() + run.next_report * touchpad_.ReportSize();
+        report.size = touchpad_.ReportSize();
+        report.scan_time = run.scan_time;
+        report.scan_time_bits = touchpad_.Config().scan_time ? SYNTHETIC_SCAN_TIME_BITS : 0;
+        run.next_report++;
+
+        frame_handed_out_ = run.next_report == run.report_count;
+        return true;
+    }
+
+    uint64_t TrajectoryGenerator::WriteCapture(CaptureWriter& writer)
+    {
+        // Captured with its descriptor, which replays compile again as they do the descriptors of real devices
+        const DeviceInfo info{touchpad_.Layout(), DescriptorFormat::ReportDescriptor, touchpad_.Descriptor()};
+
+        // Reports are generated far faster than a touchpad sends them, so the writer waits rather than drop them
+        writer.SetOverflowPolicy(CaptureOverflowPolicy::Block);
+
+        uint64_t reports = 0;
+        SyntheticReport report;
+        while (Next(report))
+        {
+            writer.WriteReport(report.device, info, report.data, report.size, report.arrival_time, report.scan_time,
+                               report.scan_time_bits);
+            reports++;
+        }
+        return reports;
+    }
+
+    void TrajectoryGenerator::PrepareFrame(DeviceRun& run)
+    {
+        // A frame whose only report was dropped leaves nothing to hand out
+        while (ProduceFrame(run) && run.report_count == 0)
+        {
+        }
+    }
+
+    bool TrajectoryGenerator::ProduceFrame(DeviceRun& run)
+    {
+        const std::vector<TrajectoryStep>& steps = script_.steps;
+        while (run.step < steps.size())
+        {
+            const TrajectoryStep& step = steps[run.step];
+            switch (step.op)
+            {
+            case TrajectoryOp::Add:
+                AddFingers(run, step);
+                run.step++;
+                EmitFrame(run);
+                return true;
+            case TrajectoryOp::Lift:
+                {
+                    run.step++;
+                    const int count = step.count < 0 ? run.finger_count : std::min(step.count, run.finger_count);
+                    if (count == 0)
+                        continue;
+
+                    for (int i = run.finger_count - count; i < run.finger_count; i++)
+                        run.fingers[i].lifting = true;
+                    EmitFrame(run);
+                    return true;
+                }
+            case TrajectoryOp::Line:
+            case TrajectoryOp::Arc:
+            case TrajectoryOp::Hold:
+                {
+                    // Without fingers down the touchpad has nothing to report
+                    if (run.finger_count == 0)
+                    {
+                        run.time_ns += step.duration_ms * NANOSECONDS_PER_MS;
+                        run.step++;
+                        continue;
+                    }
+
+                    const long long frames = std::max(1ll, std::llround(step.duration_ms * script_.rate_hz / 1000.0));
+                    if (step.op == TrajectoryOp::Line)
+                    {
+                        for (int i = 0; i < run.finger_count; i++)
+                        {
+                            run.fingers[i].x += step.x / static_cast<double>(frames);
+                            run.fingers[i].y += step.y / static_cast<double>(frames);
+                        }
+                    }
+                    else if (step.op == TrajectoryOp::Arc)
+                    {
+                        const double angle = step.value * PI / 180.0 / static_cast<double>(frames);
+                        const double cosine = std::cos(angle);
+                        const double sine = std::sin(angle);
+                        for (int i = 0; i < run.finger_count; i++)
+                        {
+                            Finger& finger = run.fingers[i];
+                            const double dx = finger.x - step.x;
+                            const double dy = finger.y - step.y;
+                            finger.x = step.x + dx * cosine - dy * sine;
+                            finger.y = step.y + dx * sine + dy * cosine;
+                        }
+                    }
+
+                    if (++run.step_frame >= frames)
+                    {
+                        run.step_frame = 0;
+                        run.step++;
+                    }
+                    EmitFrame(run);
+                    return true;
+                }
+            case TrajectoryOp::Idle:
+                run.time_ns += step.duration_ms * NANOSECONDS_PER_MS;
+                run.step++;
+                break;
+            case TrajectoryOp::Jitter:
+                run.jitter = step.value;
+                run.step++;
+                break;
+            case TrajectoryOp::Drop:
+                run.drop_report = step.count;
+                run.step++;
+                break;
+            case TrajectoryOp::Repeat:
+                if (step.count == 0)
+                {
+                    run.step = step.match + 1;
+                    break;
+                }
+                run.repeats.push_back({run.step, step.count});
+                run.step++;
+                break;
+            case TrajectoryOp::End:
+                if (--run.repeats.back().remaining > 0)
+                    run.step = step.match + 1;
+                else
+                {
+                    run.repeats.pop_back();
+                    run.step++;
+                }
+                break;
+            }
+        }
+
+        run.finished = true;
+        run.report_count = 0;
+        run.next_report = 0;
+        return false;
+    }
+
+    void TrajectoryGenerator::EmitFrame(DeviceRun& run)
+    {
+        std::array<SyntheticContact, TOUCH_FRAME_CAPACITY> contacts{};
+        for (int i = 0; i < run.finger_count; i++)
+        {
+            const Finger& finger = run.fingers[i];
+            contacts[i].contact_id = finger.contact_id;
+            contacts[i].x = static_cast<int>(std::lround(finger.x + Noise(run)));
+            contacts[i].y = static_cast<int>(std::lround(finger.y + Noise(run)));
+            contacts[i].on_surface = !finger.lifting;
+        }
+
+        run.frame_time_ns = run.time_ns;
+        run.scan_time = (run.scan_time_base + static_cast<uint32_t>(run.time_ns / NANOSECONDS_PER_SCAN_TICK)) &
+            UINT16_MAX;
+        run.report_count = touchpad_.EncodeFrame(contacts.data(), run.finger_count, run.scan_time,
+                                                 run.reports.data());
+        if (run.drop_report >= 0)
+        {
+            if (run.drop_report < run.report_count)
+            {
+                const size_t size = touchpad_.ReportSize();
+                uint8_t* dropped = run.reports.data() + run.drop_report * size;
+                std::copy(dropped + size, run.reports.data() + run.report_count * size, dropped);
+                run.report_count--;
+            }
+            run.drop_report = -1;
+        }
+        run.next_report = 0;
+        run.time_ns += interval_ns_;
+        frames_++;
+
+        // Lifted fingers have been reported for the last time
+        const auto end = std::remove_if(run.fingers.begin(), run.fingers.begin() + run.finger_count,
+                                        [](const Finger& finger) { return finger.lifting; });
+        run.finger_count = static_cast<int>(end - run.fingers.begin());
+    }
+
+    void TrajectoryGenerator::AddFingers(DeviceRun& run, const TrajectoryStep& step) const
+    {
+        for (int i = 0; i < step.count && run.finger_count < TOUCH_FRAME_CAPACITY; i++)
+        {
+            Finger& finger = run.fingers[run.finger_count];
+            finger.contact_id = NextContactId(run);
+            finger.x = step.x + i * step.value;
+            finger.y = step.y;
+            finger.lifting = false;
+            run.finger_count++;
+        }
+    }
+
+    int TrajectoryGenerator::NextContactId(DeviceRun& run) const
+    {
+        uint32_t used = 0;
+        for (int i = 0; i < run.finger_count; i++)
+            used |= 1u << run.fingers[i].contact_id;
+
+        const int first = script_.contact_ids == ContactIdPolicy::Fresh ? run.next_contact_id : 0;
+        for (int i = 0; i < SYNTHETIC_CONTACT_ID_COUNT; i++)
+        {
+            const int id = (first + i) % SYNTHETIC_CONTACT_ID_COUNT;
+            if (!(used >> id & 1))
+            {
+                run.next_contact_id = (id + 1) % SYNTHETIC_CONTACT_ID_COUNT;
+                return id;
+            }
+        }
+        return 0;
+    }
+
+    double TrajectoryGenerator::Noise(DeviceRun& run)
+    {
+        if (run.jitter <= 0.0)
+            return 0.0;
+
+        // xorshift32, so that a seed produces the same stream on every platform
+        run.random ^= run.random << 13;
+        run.random ^= run.random >> 17;
+        run.random ^= run.random << 5;
+        return (static_cast<double>(run.random) / UINT32_MAX * 2.0 - 1.0) * run.jitter;
+    }
+}
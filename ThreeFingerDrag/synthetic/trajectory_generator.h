@@ -0,0 +1,125 @@
+#pragma once
+#include "synthetic_touchpad.h"
+#include "trajectory_script.h"
+#include "../capture/capture_writer.h"
+#include "../hid/device_cache.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Touchpad
+{
+    constexpr DeviceHandle SYNTHETIC_FIRST_DEVICE = 1;
+
+    /**
+     * \brief A report of a synthetic touchpad, as it would arrive from the device.
+     */
+    struct SyntheticReport
+    {
+        DeviceHandle device;
+        std::chrono::steady_clock::time_point arrival_time;
+        const uint8_t* data; ///< The report bytes, valid until the next call to Next.
+        size_t size;
+        uint32_t scan_time;
+        uint8_t scan_time_bits; ///< Width of the Scan Time field, or 0 if the touchpad does not send it.
+    };
+
+    /**
+     * \brief Runs a trajectory script on one or more synthetic touchpads and produces their reports in arrival
+     * order.
+     *
+     * Every device runs the whole script, with its frames offset by a fraction of the report interval from the
+     * other devices and its own jitter noise. The reports of a frame are always produced back to back. Times start
+     * at the epoch of the steady clock; a ReplayDriver shifts them to the time of the replay.
+     */
+    class TrajectoryGenerator
+    {
+    public:
+        explicit TrajectoryGenerator(const TrajectoryScript& script);
+
+        /**
+         * \brief Returns false if the touchpad of the script could not be described.
+         */
+        bool IsValid() const { return touchpad_.IsValid(); }
+
+        const SyntheticTouchpad& Touchpad() const { return touchpad_; }
+
+        /**
+         * \brief Produces the next report of any device.
+         * \return False once every device has finished the script.
+         */
+        bool Next(SyntheticReport& report);
+
+        /**
+         * \brief Starts every device from the beginning of the script again.
+         */
+        void Rewind();
+
+        /**
+         * \brief Writes every remaining report to a capture, together with the layout of the touchpad. The writer is
+         * switched to block rather than drop reports.
+         * \return The number of reports written.
+         */
+        uint64_t WriteCapture(CaptureWriter& writer);
+
+        /**
+         * \brief Returns the number of frames produced since the generator was created or rewound.
+         */
+        uint64_t Frames() const { return frames_; }
+
+    private:
+        struct Finger
+        {
+            int contact_id;
+            double x;
+            double y;
+            bool lifting; ///< Reported once more with its tip switch off, then removed.
+        };
+
+        struct RepeatState
+        {
+            size_t step; ///< Index of the Repeat step.
+            int remaining;
+        };
+
+        struct DeviceRun
+        {
+            DeviceHandle device = 0;
+            double time_ns = 0.0; ///< Time of the next frame.
+            size_t step = 0;
+            long long step_frame = 0; ///< Frames sent by the current timed step.
+            std::vector<RepeatState> repeats;
+            std::array<Finger, TOUCH_FRAME_CAPACITY> fingers{};
+            int finger_count = 0;
+            int next_contact_id = 0;
+            double jitter = 0.0;
+            uint32_t random = 0;
+            uint32_t scan_time_base = 0;
+            int drop_report = -1; ///< Report of the next frame to leave out, or -1.
+            bool finished = false;
+
+            // The frame being handed out
+            std::vector<uint8_t> reports;
+            int report_count = 0;
+            int next_report = 0;
+            double frame_time_ns = 0.0;
+            uint32_t scan_time = 0;
+        };
+
+        void PrepareFrame(DeviceRun& run);
+        bool ProduceFrame(DeviceRun& run);
+        void EmitFrame(DeviceRun& run);
+        void AddFingers(DeviceRun& run, const TrajectoryStep& step) const;
+        int NextContactId(DeviceRun& run) const;
+        static double Noise(DeviceRun& run);
+
+        TrajectoryScript script_;
+        SyntheticTouchpad touchpad_;
+        double interval_ns_;
+        std::vector<DeviceRun> runs_;
+        size_t current_ = 0; ///< The device whose frame is being handed out.
+        bool frame_handed_out_ = false; ///< The device's next frame is produced on the next call, not to overwrite it.
+        uint64_t frames_ = 0;
+    };
+}
@@ -0,0 +1,246 @@
+#include "trajectory_script.h"
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace Touchpad
+{
+    namespace
+    {
+        bool ParseNumber(const std::string& token, double& value)
+        {
+            char* end = nullptr;
+            value = std::strtod(token.c_str(), &end);
+            return !token.empty() && end == token.c_str() + token.size();
+        }
+
+        /**
+         * \brief Parses the arguments of a statement into numbers, of which the last optional ones may be missing.
+         */
+        bool ParseArguments(const std::vector<std::string>& tokens, const size_t required, const size_t optional,
+                            double* values)
+        {
+            const size_t count = tokens.size() - 1;
+            if (count < required || count > required + optional)
+                return false;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!ParseNumber(tokens[i + 1], values[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        bool ParseSwitch(const std::string& token, const char* on, const char* off, bool& value)
+        {
+            if (token != on && token != off)
+                return false;
+            value = token == on;
+            return true;
+        }
+
+        bool IsWhole(const double value, const double minimum, const double maximum)
+        {
+            return value >= minimum && value <= maximum && static_cast<double>(static_cast<long long>(value)) == value;
+        }
+
+        /**
+         * \brief Parses one statement into the script. Returns a message describing the problem, or nullptr.
+         */
+        const char* ParseStatement(const std::vector<std::string>& tokens, TrajectoryScript& script,
+                                   std::vector<size_t>& open_repeats)
+        {
+            const std::string& name = tokens[0];
+            double values[4] = {};
+            TrajectoryStep step;
+            bool on = false;
+
+            if (name == "rate")
+            {
+                if (!ParseArguments(tokens, 1, 0, values) || values[0] < TRAJECTORY_MIN_RATE_HZ ||
+                    values[0] > TRAJECTORY_MAX_RATE_HZ)
+                    return "expected a rate of 1 to 10000 Hz";
+                script.rate_hz = values[0];
+                return nullptr;
+            }
+            if (name == "slots")
+            {
+                if (!ParseArguments(tokens, 1, 0, values) || !IsWhole(values[0], 1, MAX_REPORT_SLOTS))
+                    return "expected 1 to 16 slots";
+                script.touchpad.slots = static_cast<int>(values[0]);
+                return nullptr;
+            }
+            if (name == "size")
+            {
+                if (!ParseArguments(tokens, 2, 0, values) || !IsWhole(values[0], 1, INT16_MAX) ||
+                    !IsWhole(values[1], 1, INT16_MAX))
+                    return "expected a width and height of 1 to 32767";
+                script.touchpad.width = static_cast<int>(values[0]);
+                script.touchpad.height = static_cast<int>(values[1]);
+                return nullptr;
+            }
+            if (name == "scan_time")
+            {
+                if (tokens.size() != 2 || !ParseSwitch(tokens[1], "on", "off", on))
+                    return "expected on or off";
+                script.touchpad.scan_time = on;
+                return nullptr;
+            }
+            if (name == "ids")
+            {
+                if (tokens.size() != 2 || !ParseSwitch(tokens[1], "fresh", "reuse", on))
+                    return "expected reuse or fresh";
+                script.contact_ids = on ? ContactIdPolicy::Fresh : ContactIdPolicy::Reuse;
+                return nullptr;
+            }
+            if (name == "seed")
+            {
+                if (!ParseArguments(tokens, 1, 0, values) || !IsWhole(values[0], 0, UINT32_MAX))
+                    return "expected a seed of 0 to 4294967295";
+                script.seed = static_cast<uint32_t>(values[0]);
+                return nullptr;
+            }
+            if (name == "devices")
+            {
+                if (!ParseArguments(tokens, 1, 0, values) || !IsWhole(values[0], 1, TRAJECTORY_MAX_DEVICES))
+                    return "expected 1 to 256 devices";
+                script.devices = static_cast<int>(values[0]);
+                return nullptr;
+            }
+
+            if (name == "add")
+            {
+                values[3] = TRAJECTORY_DEFAULT_SPACING;
+                if (!ParseArguments(tokens, 3, 1, values) || !IsWhole(values[0], 1, TOUCH_FRAME_CAPACITY))
+                    return "expected add N X Y [SPACING] with 1 to 10 fingers";
+                step.op = TrajectoryOp::Add;
+                step.count = static_cast<int>(values[0]);
+                step.x = values[1];
+                step.y = values[2];
+                step.value = values[3];
+            }
+            else if (name == "lift")
+            {
+                step.op = TrajectoryOp::Lift;
+                if (tokens.size() == 2 && tokens[1] == "all")
+                    step.count = -1;
+                else if (ParseArguments(tokens, 1, 0, values) && IsWhole(values[0], 1, TOUCH_FRAME_CAPACITY))
+                    step.count = static_cast<int>(values[0]);
+                else
+                    return "expected lift N or lift all";
+            }
+            else if (name == "line")
+            {
+                if (!ParseArguments(tokens, 3, 0, values) || values[2] < 0)
+                    return "expected line DX DY MS";
+                step.op = TrajectoryOp::Line;
+                step.x = values[0];
+                step.y = values[1];
+                step.duration_ms = values[2];
+            }
+            else if (name == "arc")
+            {
+                if (!ParseArguments(tokens, 4, 0, values) || values[3] < 0)
+                    return "expected arc CX CY DEGREES MS";
+                step.op = TrajectoryOp::Arc;
+                step.x = values[0];
+                step.y = values[1];
+                step.value = values[2];
+                step.duration_ms = values[3];
+            }
+            else if (name == "hold" || name == "idle")
+            {
+                if (!ParseArguments(tokens, 1, 0, values) || values[0] < 0)
+                    return "expected a duration in milliseconds";
+                step.op = name == "hold" ? TrajectoryOp::Hold : TrajectoryOp::Idle;
+                step.duration_ms = values[0];
+            }
+            else if (name == "jitter")
+            {
+                if (!ParseArguments(tokens, 1, 0, values) || values[0] < 0)
+                    return "expected a jitter amplitude";
+                step.op = TrajectoryOp::Jitter;
+                step.value = values[0];
+            }
+            else if (name == "drop")
+            {
+                if (!ParseArguments(tokens, 1, 0, values) || !IsWhole(values[0], 0, TOUCH_FRAME_CAPACITY - 1))
+                    return "expected drop REPORT with a report number of 0 to 9";
+                step.op = TrajectoryOp::Drop;
+                step.count = static_cast<int>(values[0]);
+            }
+            else if (name == "repeat")
+            {
+                if (!ParseArguments(tokens, 1, 0, values) || !IsWhole(values[0], 0, INT32_MAX))
+                    return "expected a repeat count";
+                step.op = TrajectoryOp::Repeat;
+                step.count = static_cast<int>(values[0]);
+                open_repeats.push_back(script.steps.size());
+            }
+            else if (name == "end")
+            {
+                if (tokens.size() != 1 || open_repeats.empty())
+                    return "end without repeat";
+                step.op = TrajectoryOp::End;
+                step.match = open_repeats.back();
+                script.steps[step.match].match = script.steps.size();
+                open_repeats.pop_back();
+            }
+            else
+                return "unknown statement";
+
+            script.steps.push_back(step);
+            return nullptr;
+        }
+    }
+
+    bool TrajectoryScript::Parse(const std::string& text, TrajectoryScript& script, std::string& error)
+    {
+        script = TrajectoryScript();
+        std::vector<size_t> open_repeats;
+        std::istringstream lines(text);
+        std::string line;
+        int line_number = 0;
+
+        while (std::getline(lines, line))
+        {
+            line_number++;
+            line = line.substr(0, line.find('#'));
+
+            std::istringstream words(line);
+            const std::vector<std::string> tokens{
+                std::istream_iterator<std::string>(words), std::istream_iterator<std::string>()
+            };
+            if (tokens.empty())
+                continue;
+
+            if (const char* problem = ParseStatement(tokens, script, open_repeats))
+            {
+                error = "Line " + std::to_string(line_number) + ": " + problem + ".";
+                return false;
+            }
+        }
+
+        if (!open_repeats.empty())
+        {
+            error = "Repeat without end.";
+            return false;
+        }
+        return true;
+    }
+
+    bool TrajectoryScript::Load(const std::string& path, TrajectoryScript& script, std::string& error)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            error = "Could not read '" + path + "'.";
+            return false;
+        }
+
+        const std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        return Parse(text, script, error);
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "synthetic_touchpad.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Touchpad
+{
+    constexpr auto TRAJECTORY_MIN_RATE_HZ = 1.0;
+    constexpr auto TRAJECTORY_MAX_RATE_HZ = 10000.0;
+    constexpr auto TRAJECTORY_MAX_DEVICES = 256;
+    constexpr auto TRAJECTORY_DEFAULT_SPACING = 150.0;
+
+    enum class TrajectoryOp : uint8_t
+    {
+        Add, ///< Puts fingers down in a row. Sends one frame.
+        Lift, ///< Lifts the most recently added fingers. Sends one frame with them lifted.
+        Line, ///< Moves every finger by an offset.
+        Arc, ///< Rotates every finger around a point.
+        Hold, ///< Keeps every finger still while reporting.
+        Idle, ///< Sends nothing.
+        Jitter, ///< Sets the amplitude of the noise added to every reported coordinate.
+        Drop, ///< Loses one report of the next frame, as if it never arrived.
+        Repeat, ///< Runs the steps up to the matching End a number of times.
+        End
+    };
+
+    /**
+     * \brief A single step of a trajectory script. Only the members of its operation are used.
+     */
+    struct TrajectoryStep
+    {
+        TrajectoryOp op = TrajectoryOp::Hold;
+        int count = 0; ///< Add, Lift: number of fingers, or -1 to lift all. Repeat: number of runs. Drop: report.
+        double x = 0.0; ///< Add: position of the first finger. Line: offset. Arc: center.
+        double y = 0.0;
+        double value = 0.0; ///< Add: spacing of the fingers. Arc: degrees. Jitter: amplitude.
+        double duration_ms = 0.0; ///< Line, Arc, Hold, Idle.
+        size_t match = 0; ///< Repeat: index of the matching End. End: index of the matching Repeat.
+    };
+
+    enum class ContactIdPolicy : uint8_t
+    {
+        Reuse, ///< A new finger takes the lowest free contact ID, as most touchpads do.
+        Fresh ///< A new finger takes the next contact ID in turn, skipping IDs still down.
+    };
+
+    /**
+     * \brief A parsed trajectory script. See TrajectoryScript::Parse for the language.
+     */
+    struct TrajectoryScript
+    {
+        SyntheticTouchpadConfig touchpad;
+        double rate_hz = 125.0; ///< Frames per second while fingers are down.
+        ContactIdPolicy contact_ids = ContactIdPolicy::Reuse;
+        uint32_t seed = 1; ///< Seed of the jitter noise.
+        int devices = 1; ///< Number of touchpads running the script at once.
+        std::vector<TrajectoryStep> steps;
+
+        /**
+         * \brief Parses a script. One statement per line; '#' starts a comment. Distances are in logical units
+         * and durations in milliseconds.
+         *
+         * Settings, which apply to the whole script wherever they appear:
+         *   rate HZ, slots N, size WIDTH HEIGHT, scan_time on|off, ids reuse|fresh, seed N, devices N
+         *
+         * Steps:
+         *   add N X Y [SPACING], lift N|all, line DX DY MS, arc CX CY DEGREES MS, hold MS, idle MS,
+         *   jitter AMPLITUDE, drop REPORT, repeat N ... end
+         *
+         * drop REPORT sends the next frame without its report number REPORT, counted from 0 for the report that
+         * carries the contact count, to replay a lost report. It has no effect if the frame has fewer reports.
+         *
+         * \param text The script.
+         * \param script Receives the parsed script.
+         * \param error Receives a message naming the offending line if parsing fails.
+         * \return False if the script is malformed.
+         */
+        static bool Parse(const std::string& text, TrajectoryScript& script, std::string& error);
+
+        /**
+         * \brief Reads and parses a script file.
+         */
+        static bool Load(const std::string& path, TrajectoryScript& script, std::string& error);
+    };
+}
@@ -0,0 +1,52 @@
+#include "anomaly_detector.h"
+
+namespace Touchpad
+{
+    bool AnomalyDetector::CheckBeforeStep(const GestureState& state, const bool left_button_down,
+                                          const std::chrono::steady_clock::time_point now, FlightDumpReason& reason)
+    {
+        const bool stuck = state.gesture_started && left_button_down &&
+            now - state.last_event >= std::chrono::milliseconds(ANOMALY_STUCK_BUTTON_MS);
+        return stuck && Report(FlightDumpReason::StuckButton, now, reason);
+    }
+
+    bool AnomalyDetector::CheckAfterStep(const GestureState& state, const GestureOutput& output,
+                                         const std::chrono::steady_clock::time_point now, FlightDumpReason& reason)
+    {
+        // Lifting the fingers without dragging also cancels, so only count cancellations that end a drag
+        bool drag_cancelled = false;
+        for (uint8_t i = 0; i < output.count; i++)
+            drag_cancelled |= output.commands[i].type == OutputCommandType::LeftButtonUp;
+
+        if (drag_cancelled && output.transitions & TRANSITION_GESTURE_CANCELLED)
+        {
+            cancel_times_[cancel_count_ % ANOMALY_CANCEL_STORM_COUNT] = now;
+            cancel_count_++;
+
+            // Once the ring is full, the next slot to be replaced holds the oldest of the last cancellations
+            const bool storm = cancel_count_ >= ANOMALY_CANCEL_STORM_COUNT &&
+                now - cancel_times_[cancel_count_ % ANOMALY_CANCEL_STORM_COUNT] <
+                std::chrono::milliseconds(ANOMALY_CANCEL_STORM_WINDOW_MS);
+
+            if (storm && Report(FlightDumpReason::CancelStorm, now, reason))
+                return true;
+        }
+
+        const bool long_drag = state.gesture_started &&
+            now - state.gesture_start >= std::chrono::milliseconds(ANOMALY_LONG_DRAG_MS);
+        return long_drag && Report(FlightDumpReason::LongDrag, now, reason);
+    }
+
+    bool AnomalyDetector::Report(const FlightDumpReason anomaly, const std::chrono::steady_clock::time_point now,
+                                 FlightDumpReason& reason)
+    {
+        const auto index = static_cast<size_t>(anomaly);
+        if (reported_[index] && now - last_reports_[index] < std::chrono::milliseconds(ANOMALY_REPORT_INTERVAL_MS))
+            return false;
+
+        reported_[index] = true;
+        last_reports_[index] = now;
+        reason = anomaly;
+        return true;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "flight_recorder.h"
+#include "../gesture/gesture_engine.h"
+#include <array>
+#include <chrono>
+
+namespace Touchpad
+{
+    constexpr auto ANOMALY_STUCK_BUTTON_MS = 2000;
+    constexpr auto ANOMALY_LONG_DRAG_MS = 60000;
+    constexpr auto ANOMALY_CANCEL_STORM_COUNT = 10;
+    constexpr auto ANOMALY_CANCEL_STORM_WINDOW_MS = 5000;
+    constexpr auto ANOMALY_REPORT_INTERVAL_MS = 60000;
+
+    /**
+     * \brief Watches the gesture steps for signs that something went wrong, so that the flight recorder can be
+     * dumped while the events leading up to it are still recorded.
+     *
+     * Detects the left mouse button being held by the gesture through ANOMALY_STUCK_BUTTON_MS without touch
+     * activity, which the gesture timeouts should have ended; drags longer than ANOMALY_LONG_DRAG_MS; and
+     * ANOMALY_CANCEL_STORM_COUNT drags cancelled within ANOMALY_CANCEL_STORM_WINDOW_MS. Each kind of anomaly is
+     * reported at most every ANOMALY_REPORT_INTERVAL_MS. Like the gesture engine, it makes no system calls.
+     */
+    class AnomalyDetector
+    {
+    public:
+        /**
+         * \brief Checks the state before a step, when the time since the previous event is known.
+         * \param state The gesture state after the previous step.
+         * \param left_button_down True if the left mouse button is held.
+         * \param now Time of the step.
+         * \param reason Receives the anomaly, if one is reported.
+         * \return True if an anomaly is reported.
+         */
+        bool CheckBeforeStep(const GestureState& state, bool left_button_down,
+                             std::chrono::steady_clock::time_point now, FlightDumpReason& reason);
+
+        /**
+         * \brief Checks the state after a step or cancellation.
+         * \param state The gesture state after the step.
+         * \param output The mouse commands and transitions of the step.
+         * \param now Time of the step.
+         * \param reason Receives the anomaly, if one is reported.
+         * \return True if an anomaly is reported.
+         */
+        bool CheckAfterStep(const GestureState& state, const GestureOutput& output,
+                            std::chrono::steady_clock::time_point now, FlightDumpReason& reason);
+
+    private:
+        bool Report(FlightDumpReason anomaly, std::chrono::steady_clock::time_point now, FlightDumpReason& reason);
+
+        std::array<std::chrono::steady_clock::time_point, ANOMALY_CANCEL_STORM_COUNT> cancel_times_{};
+        size_t cancel_count_ = 0;
+        std::array<std::chrono::steady_clock::time_point, FLIGHT_DUMP_REASON_COUNT> last_reports_{};
+        std::array<bool, FLIGHT_DUMP_REASON_COUNT> reported_{};
+    };
+}
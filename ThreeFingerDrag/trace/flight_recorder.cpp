@@ -0,0 +1,122 @@
+#include "flight_recorder.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace Touchpad
+{
+    FlightRecorder::FlightRecorder()
+        : slots_(), start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    void FlightRecorder::SetDumpFolder(const std::string& folder)
+    {
+        for (int i = 0; i < FLIGHT_DUMP_REASON_COUNT; i++)
+        {
+            const std::string file_name = std::string(FLIGHT_DUMP_FILE_PREFIX) +
+                ReasonName(static_cast<FlightDumpReason>(i)) + TRACE_FILE_EXTENSION;
+            dump_paths_[i] = (std::filesystem::path(folder) / file_name).u8string();
+        }
+    }
+
+    void FlightRecorder::RecordFrame(const std::chrono::steady_clock::time_point time, const bool has_scan_time,
+                                     const uint64_t scan_ticks, const TouchFrame& contacts)
+    {
+        EncodeTraceFrame(NextSlot(), TraceTime(start_, time), has_scan_time, scan_ticks, contacts);
+        Publish();
+    }
+
+    void FlightRecorder::RecordStep(const std::chrono::steady_clock::time_point time, const TraceEventType event,
+                                    const int surface_count, const GestureState& state, const bool left_button_down,
+                                    const GestureOutput& output)
+    {
+        EncodeTraceStep(NextSlot(), TraceTime(start_, time), event, surface_count, state, left_button_down, output);
+        Publish();
+    }
+
+    void FlightRecorder::RecordCancel(const std::chrono::steady_clock::time_point time, const CancelReason reason)
+    {
+        EncodeTraceCancel(NextSlot(), TraceTime(start_, time), reason);
+        Publish();
+    }
+
+    bool FlightRecorder::Dump(const FlightDumpReason reason) const
+    {
+        const std::string& path = DumpPath(reason);
+        if (path.empty())
+            return false;
+
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        TraceFileHeader file_header;
+        std::memcpy(file_header.magic, TRACE_MAGIC, sizeof(file_header.magic));
+        file_header.version = TRACE_VERSION;
+        file_header.time_unit_us = TRACE_TIME_UNIT_US;
+        bool written = std::fwrite(&file_header, sizeof(file_header), 1, file) == 1;
+
+        // Oldest first. The slots are only overwritten, never cleared, so the records are always whole unless one
+        // is being written right now.
+        const uint64_t end = next_record_.load(std::memory_order_acquire);
+        const uint64_t begin = end > FLIGHT_RECORDER_CAPACITY ? end - FLIGHT_RECORDER_CAPACITY : 0;
+        uint8_t record[TRACE_MAX_RECORD_SIZE];
+        uint32_t first_time = 0;
+        for (uint64_t i = begin; i < end && written; i++)
+        {
+            std::memcpy(record, slots_[i % FLIGHT_RECORDER_CAPACITY], sizeof(record));
+
+            TraceRecordHeader header;
+            std::memcpy(&header, record, sizeof(header));
+            const size_t size = TraceRecordSize(header);
+            if (size == 0 || size > TRACE_MAX_RECORD_SIZE)
+                continue;
+
+            // Record times wrap around after about five days of uptime, so they are rebased on the oldest record.
+            // The unsigned difference stays correct across the wrap.
+            if (i == begin)
+                first_time = header.time;
+            header.time -= first_time;
+            std::memcpy(record, &header, sizeof(header));
+
+            written = std::fwrite(record, 1, size, file) == size;
+        }
+
+        return std::fclose(file) == 0 && written;
+    }
+
+    const std::string& FlightRecorder::DumpPath(const FlightDumpReason reason) const
+    {
+        return dump_paths_[static_cast<size_t>(reason)];
+    }
+
+    const char* FlightRecorder::ReasonName(const FlightDumpReason reason)
+    {
+        switch (reason)
+        {
+        case FlightDumpReason::Crash:
+            return "crash";
+        case FlightDumpReason::StuckButton:
+            return "stuck-button";
+        case FlightDumpReason::LongDrag:
+            return "long-drag";
+        case FlightDumpReason::CancelStorm:
+            return "cancel-storm";
+        case FlightDumpReason::Requested:
+            return "requested";
+        }
+        return "unknown";
+    }
+
+    uint8_t* FlightRecorder::NextSlot()
+    {
+        return slots_[next_record_.load(std::memory_order_relaxed) % FLIGHT_RECORDER_CAPACITY];
+    }
+
+    void FlightRecorder::Publish()
+    {
+        // Only one thread writes records, so no read-modify-write is needed
+        next_record_.store(next_record_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
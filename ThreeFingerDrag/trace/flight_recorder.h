@@ -0,0 +1,97 @@
+#pragma once
+#include "trace_encoder.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace Touchpad
+{
+    constexpr auto FLIGHT_RECORDER_CAPACITY = 4096;
+    constexpr auto FLIGHT_DUMP_FILE_PREFIX = "flight-";
+
+    /**
+     * \brief Why the flight recorder was dumped. Each reason has its own dump file, which the next dump of the
+     * same reason replaces.
+     */
+    enum class FlightDumpReason : uint8_t
+    {
+        Crash,
+        StuckButton, ///< The gesture held the left mouse button through a period of inactivity.
+        LongDrag, ///< A single drag lasted longer than ANOMALY_LONG_DRAG_MS.
+        CancelStorm, ///< Too many gestures were cancelled in a short time.
+        Requested
+    };
+
+    constexpr auto FLIGHT_DUMP_REASON_COUNT = 5;
+
+    /**
+     * \brief Keeps the last FLIGHT_RECORDER_CAPACITY frames, gesture steps and cancellations in memory, so that the
+     * events leading up to a crash or an anomaly can be written to a trace file after the fact.
+     *
+     * Records use the trace format and go into fixed-size slots that are allocated with the recorder, overwriting
+     * the oldest record. Recording costs a copy per record and never allocates, so the recorder is always on.
+     * Dumps are readable by the trace decoder, with times counted from the oldest record.
+     *
+     * Records must be written from a single thread. Dumps may be taken from any thread; a dump taken while a
+     * record is being written may contain that record partially updated.
+     */
+    class FlightRecorder
+    {
+    public:
+        FlightRecorder();
+
+        FlightRecorder(const FlightRecorder& other) = delete;
+        FlightRecorder& operator=(const FlightRecorder& other) = delete;
+
+        /**
+         * \brief Sets the folder dumps are written to. The dump paths are built here, so that dumping does not
+         * have to build them when the process may be failing.
+         */
+        void SetDumpFolder(const std::string& folder);
+
+        /**
+         * \brief Records a frame received from the touchpad. See TraceWriter::WriteFrame.
+         */
+        void RecordFrame(std::chrono::steady_clock::time_point time, bool has_scan_time, uint64_t scan_ticks,
+                         const TouchFrame& contacts);
+
+        /**
+         * \brief Records a step of the gesture engine. See TraceWriter::WriteStep.
+         */
+        void RecordStep(std::chrono::steady_clock::time_point time, TraceEventType event, int surface_count,
+                        const GestureState& state, bool left_button_down, const GestureOutput& output);
+
+        /**
+         * \brief Records a gesture cancelled by one of its timeouts.
+         */
+        void RecordCancel(std::chrono::steady_clock::time_point time, CancelReason reason);
+
+        /**
+         * \brief Writes the recorded events, oldest first, to the dump file of the given reason.
+         * \return False if no dump folder is set or the file could not be written.
+         */
+        bool Dump(FlightDumpReason reason) const;
+
+        /**
+         * \brief Returns the path of the dump file of the given reason, or an empty string if no folder is set.
+         */
+        const std::string& DumpPath(FlightDumpReason reason) const;
+
+        /**
+         * \brief Returns the number of records written since the recorder was created.
+         */
+        uint64_t Records() const { return next_record_.load(std::memory_order_relaxed); }
+
+        static const char* ReasonName(FlightDumpReason reason);
+
+    private:
+        uint8_t* NextSlot();
+        void Publish();
+
+        uint8_t slots_[FLIGHT_RECORDER_CAPACITY][TRACE_MAX_RECORD_SIZE];
+        std::atomic<uint64_t> next_record_{0}; ///< Number of records written; the next slot to write.
+        std::chrono::steady_clock::time_point start_;
+        std::array<std::string, FLIGHT_DUMP_REASON_COUNT> dump_paths_;
+    };
+}
@@ -0,0 +1,93 @@
+#include "trace_encoder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Touchpad
+{
+    namespace
+    {
+        uint16_t Saturate(const int value)
+        {
+            return static_cast<uint16_t>(std::clamp(value, 0, static_cast<int>(UINT16_MAX)));
+        }
+
+        TraceRecordHeader MakeHeader(const TraceRecordType type, const uint32_t time)
+        {
+            TraceRecordHeader header;
+            header.type = type;
+            header.count = 0;
+            header.flags = 0;
+            header.detail = 0;
+            header.time = time;
+            return header;
+        }
+    }
+
+    uint32_t TraceTime(const std::chrono::steady_clock::time_point start,
+                       const std::chrono::steady_clock::time_point time)
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - start).count();
+        return static_cast<uint32_t>(std::max<long long>(elapsed, 0) / TRACE_TIME_UNIT_US);
+    }
+
+    void EncodeTraceFrame(uint8_t* destination, const uint32_t time, const bool has_scan_time,
+                          const uint64_t scan_ticks, const TouchFrame& contacts)
+    {
+        TraceFrameRecord record;
+        record.header = MakeHeader(TraceRecordType::Frame, time);
+        record.header.count = static_cast<uint8_t>(contacts.Size());
+        record.header.flags = has_scan_time ? TRACE_FRAME_HAS_SCAN_TIME : 0;
+        record.scan_time = static_cast<uint32_t>(scan_ticks);
+        std::memcpy(destination, &record, sizeof(record));
+        destination += sizeof(record);
+
+        for (const auto& contact : contacts)
+        {
+            TraceContact traced;
+            traced.contact_id = static_cast<uint8_t>(contact.contact_id);
+            traced.flags = contact.on_surface ? TRACE_CONTACT_ON_SURFACE : 0;
+            traced.x = Saturate(contact.x);
+            traced.y = Saturate(contact.y);
+            std::memcpy(destination, &traced, sizeof(traced));
+            destination += sizeof(traced);
+        }
+    }
+
+    void EncodeTraceStep(uint8_t* destination, const uint32_t time, const TraceEventType event,
+                         const int surface_count, const GestureState& state, const bool left_button_down,
+                         const GestureOutput& output)
+    {
+        TraceStepRecord record;
+        record.header = MakeHeader(TraceRecordType::Step, time);
+        record.header.count = static_cast<uint8_t>(surface_count);
+        record.header.flags = (state.gesture_started ? TRACE_STEP_GESTURE_STARTED : 0) |
+            (state.cancellation_started ? TRACE_STEP_CANCELLATION_STARTED : 0) |
+            (left_button_down ? TRACE_STEP_LEFT_BUTTON_DOWN : 0);
+        record.header.detail = static_cast<uint8_t>(event);
+        record.transitions = output.transitions;
+        record.command_count = output.count;
+        record.reserved = 0;
+
+        double move_x = 0.0;
+        double move_y = 0.0;
+        for (uint8_t i = 0; i < output.count; i++)
+        {
+            if (output.commands[i].type != OutputCommandType::MoveCursor)
+                continue;
+            move_x += output.commands[i].delta_x;
+            move_y += output.commands[i].delta_y;
+        }
+        record.move_x = static_cast<float>(move_x);
+        record.move_y = static_cast<float>(move_y);
+
+        std::memcpy(destination, &record, sizeof(record));
+    }
+
+    void EncodeTraceCancel(uint8_t* destination, const uint32_t time, const CancelReason reason)
+    {
+        TraceCancelRecord record;
+        record.header = MakeHeader(TraceRecordType::Cancel, time);
+        record.header.detail = static_cast<uint8_t>(reason);
+        std::memcpy(destination, &record, sizeof(record));
+    }
+}
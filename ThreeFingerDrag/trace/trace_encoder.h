@@ -0,0 +1,44 @@
+#pragma once
+#include "trace_format.h"
+#include "../data/touch_data.h"
+#include "../gesture/gesture_engine.h"
+#include "../gesture/gesture_state.h"
+#include <chrono>
+
+namespace Touchpad
+{
+    /**
+     * \brief Size of the largest trace record, a frame with every contact slot occupied.
+     */
+    constexpr size_t TRACE_MAX_RECORD_SIZE = sizeof(TraceFrameRecord) + TOUCH_FRAME_CAPACITY * sizeof(TraceContact);
+
+    /**
+     * \brief Converts a time to the record time of a trace started at the given time.
+     */
+    uint32_t TraceTime(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point time);
+
+    /**
+     * \brief Returns the size of the frame record of the given contacts.
+     */
+    inline size_t TraceFrameSize(const TouchFrame& contacts)
+    {
+        return sizeof(TraceFrameRecord) + contacts.Size() * sizeof(TraceContact);
+    }
+
+    /**
+     * \brief Writes a frame record of TraceFrameSize bytes. See TraceWriter::WriteFrame.
+     */
+    void EncodeTraceFrame(uint8_t* destination, uint32_t time, bool has_scan_time, uint64_t scan_ticks,
+                          const TouchFrame& contacts);
+
+    /**
+     * \brief Writes a step record. See TraceWriter::WriteStep.
+     */
+    void EncodeTraceStep(uint8_t* destination, uint32_t time, TraceEventType event, int surface_count,
+                         const GestureState& state, bool left_button_down, const GestureOutput& output);
+
+    /**
+     * \brief Writes a cancel record.
+     */
+    void EncodeTraceCancel(uint8_t* destination, uint32_t time, CancelReason reason);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Touchpad
+{
+    /*
+     * A trace file starts with a TraceFileHeader, followed by records that each start with a TraceRecordHeader.
+     * Records are fixed-layout structs written in host byte order, which is little endian on every supported
+     * platform. Times are in TRACE_TIME_UNIT_US units since the file was started, which wraps after about 119
+     * hours.
+     */
+
+    constexpr uint8_t TRACE_MAGIC[4] = {'T', 'F', 'D', 'T'};
+    constexpr uint16_t TRACE_VERSION = 1;
+    constexpr auto TRACE_TIME_UNIT_US = 100;
+    constexpr auto TRACE_FILE_EXTENSION = ".tfdtrace";
+
+    enum class TraceRecordType : uint8_t
+    {
+        Frame = 1, ///< A frame received from the touchpad. Followed by contact_count TraceContact.
+        Step = 2, ///< A step of the gesture engine.
+        Cancel = 3 ///< A gesture cancelled by one of its timeouts.
+    };
+
+    enum class TraceEventType : uint8_t
+    {
+        TouchActivity = 0,
+        TouchUp = 1
+    };
+
+    // Flags of TraceRecordHeader::flags
+    constexpr uint8_t TRACE_FRAME_HAS_SCAN_TIME = 1;
+    constexpr uint8_t TRACE_STEP_GESTURE_STARTED = 1;
+    constexpr uint8_t TRACE_STEP_CANCELLATION_STARTED = 2;
+    constexpr uint8_t TRACE_STEP_LEFT_BUTTON_DOWN = 4;
+
+    // Flags of TraceContact::flags
+    constexpr uint8_t TRACE_CONTACT_ON_SURFACE = 1;
+
+#pragma pack(push, 1)
+    struct TraceFileHeader
+    {
+        uint8_t magic[4];
+        uint16_t version;
+        uint16_t time_unit_us;
+    };
+
+    struct TraceRecordHeader
+    {
+        TraceRecordType type;
+        uint8_t count; ///< Frame: number of contacts. Step: number of contacts on the surface.
+        uint8_t flags;
+        uint8_t detail; ///< Step: TraceEventType. Cancel: CancelReason.
+        uint32_t time;
+    };
+
+    struct TraceContact
+    {
+        uint8_t contact_id;
+        uint8_t flags;
+        uint16_t x; ///< Saturated to the range of the field.
+        uint16_t y;
+    };
+
+    struct TraceFrameRecord
+    {
+        TraceRecordHeader header;
+        uint32_t scan_time; ///< Low bits of the unwrapped scan time in 100 microsecond units.
+    };
+
+    struct TraceStepRecord
+    {
+        TraceRecordHeader header;
+        uint8_t transitions; ///< The TRANSITION_* flags raised by the step.
+        uint8_t command_count; ///< Number of mouse commands sent.
+        uint16_t reserved;
+        float move_x; ///< Cursor movement sent by the step, in pixels.
+        float move_y;
+    };
+
+    struct TraceCancelRecord
+    {
+        TraceRecordHeader header;
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(TraceFileHeader) == 8, "Unexpected trace header layout.");
+    static_assert(sizeof(TraceRecordHeader) == 8, "Unexpected trace record layout.");
+    static_assert(sizeof(TraceContact) == 6, "Unexpected trace contact layout.");
+    static_assert(sizeof(TraceFrameRecord) == 12, "Unexpected trace frame layout.");
+    static_assert(sizeof(TraceStepRecord) == 20, "Unexpected trace step layout.");
+
+    /**
+     * \brief Returns the total size of a record with the given header, including any trailing contacts.
+     */
+    inline size_t TraceRecordSize(const TraceRecordHeader& header)
+    {
+        switch (header.type)
+        {
+        case TraceRecordType::Frame:
+            return sizeof(TraceFrameRecord) + header.count * sizeof(TraceContact);
+        case TraceRecordType::Step:
+            return sizeof(TraceStepRecord);
+        case TraceRecordType::Cancel:
+            return sizeof(TraceCancelRecord);
+        }
+        return 0;
+    }
+}
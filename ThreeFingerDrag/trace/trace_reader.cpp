@@ -0,0 +1,88 @@
+#include "trace_reader.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace Touchpad
+{
+    bool TraceReader::Open(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return Load(data.data(), data.size());
+    }
+
+    bool TraceReader::Load(const uint8_t* data, const size_t size)
+    {
+        data_.clear();
+        position_ = 0;
+        malformed_ = false;
+
+        TraceFileHeader header;
+        if (size < sizeof(header))
+            return false;
+
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != TRACE_VERSION ||
+            header.time_unit_us != TRACE_TIME_UNIT_US)
+            return false;
+
+        data_.assign(data, data + size);
+        position_ = sizeof(header);
+        return true;
+    }
+
+    bool TraceReader::Next(TraceRecord& record)
+    {
+        if (position_ >= data_.size())
+            return false;
+
+        const size_t remaining = data_.size() - position_;
+        const uint8_t* source = data_.data() + position_;
+
+        TraceRecordHeader header;
+        size_t size = 0;
+        if (remaining >= sizeof(header))
+        {
+            std::memcpy(&header, source, sizeof(header));
+            size = TraceRecordSize(header);
+        }
+
+        if (size == 0 || size > remaining)
+        {
+            malformed_ = true;
+            return false;
+        }
+
+        record.header = header;
+        switch (header.type)
+        {
+        case TraceRecordType::Frame:
+            {
+                TraceFrameRecord frame;
+                std::memcpy(&frame, source, sizeof(frame));
+                record.scan_time = frame.scan_time;
+                std::memcpy(record.contacts, source + sizeof(frame), header.count * sizeof(TraceContact));
+                break;
+            }
+        case TraceRecordType::Step:
+            {
+                TraceStepRecord step;
+                std::memcpy(&step, source, sizeof(step));
+                record.transitions = step.transitions;
+                record.command_count = step.command_count;
+                record.move_x = step.move_x;
+                record.move_y = step.move_y;
+                break;
+            }
+        case TraceRecordType::Cancel:
+            break;
+        }
+
+        position_ += size;
+        return true;
+    }
+}
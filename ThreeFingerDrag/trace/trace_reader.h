@@ -0,0 +1,66 @@
+#pragma once
+#include "trace_format.h"
+#include <string>
+#include <vector>
+
+namespace Touchpad
+{
+    /**
+     * \brief A single record of a trace file. Only the members of its type are set.
+     */
+    struct TraceRecord
+    {
+        TraceRecordHeader header{};
+        uint32_t scan_time = 0; ///< Frame: low bits of the unwrapped scan time in 100 microsecond units.
+        TraceContact contacts[UINT8_MAX]{}; ///< Frame: the first header.count elements are the contacts.
+        uint8_t transitions = 0; ///< Step: the TRANSITION_* flags raised by the step.
+        uint8_t command_count = 0; ///< Step: number of mouse commands sent.
+        float move_x = 0.0f; ///< Step: cursor movement sent by the step, in pixels.
+        float move_y = 0.0f;
+
+        /**
+         * \brief Returns the time of the record in microseconds since the trace was started.
+         */
+        uint64_t TimeUs() const { return static_cast<uint64_t>(header.time) * TRACE_TIME_UNIT_US; }
+    };
+
+    /**
+     * \brief Reads the records of a trace file written by TraceWriter. The whole file is loaded into memory up
+     * front, so reading records performs no I/O.
+     */
+    class TraceReader
+    {
+    public:
+        /**
+         * \brief Loads a trace file and checks its header.
+         * \param path Path of the file.
+         * \return False if the file could not be read or is not a trace file.
+         */
+        bool Open(const std::string& path);
+
+        /**
+         * \brief Uses a trace already held in memory.
+         * \param data The trace bytes, starting with the header.
+         * \param size Size of the trace in bytes.
+         * \return False if the data does not start with a valid header.
+         */
+        bool Load(const uint8_t* data, size_t size);
+
+        /**
+         * \brief Reads the next record.
+         * \param record Receives the record.
+         * \return False at the end of the trace, or if the next record is truncated or unknown.
+         */
+        bool Next(TraceRecord& record);
+
+        /**
+         * \brief Returns true if reading stopped at a malformed record rather than at the end of the trace.
+         */
+        bool Malformed() const { return malformed_; }
+
+    private:
+        std::vector<uint8_t> data_;
+        size_t position_ = 0;
+        bool malformed_ = false;
+    };
+}
@@ -0,0 +1,247 @@
+#include "trace_writer.h"
+#include "../logging/logger.h"
+#include <cstring>
+#include <filesystem>
+
+namespace Touchpad
+{
+    TraceWriter::~TraceWriter()
+    {
+        Close();
+    }
+
+    bool TraceWriter::Open(const std::string& path)
+    {
+        Close();
+
+        path_ = path;
+        const std::filesystem::path file_path(path);
+        previous_path_ = (file_path.parent_path() / file_path.stem()).string() + ".1" +
+            file_path.extension().string();
+
+        // The trace of the previous run is kept as the previous generation rather than truncated, so the trace
+        // of a problem survives restarting the app
+        std::error_code error;
+        const auto existing_size = std::filesystem::file_size(path, error);
+        const bool created = !error && existing_size > 0 ? Rotate() : StartFile();
+        if (!created)
+        {
+            ERROR("Could not create the trace file '" + path + "'.");
+            return false;
+        }
+
+        // Allocated once, so that tracing never allocates on the input thread
+        for (auto& buffer : buffers_)
+        {
+            if (buffer == nullptr)
+                buffer = std::make_unique<uint8_t[]>(TRACE_BUFFER_SIZE);
+        }
+
+        start_ = std::chrono::steady_clock::now();
+        active_buffer_ = 0;
+        used_ = 0;
+        records_ = 0;
+        dropped_records_ = 0;
+        writer_busy_.store(false, std::memory_order_relaxed);
+        submit_requested_.store(false, std::memory_order_relaxed);
+        pending_size_ = 0;
+        stopping_ = false;
+        open_ = true;
+
+        thread_ = std::thread(&TraceWriter::Run, this);
+        return true;
+    }
+
+    void TraceWriter::Close()
+    {
+        if (!open_)
+            return;
+
+        // Wait for the writer thread to finish the previous buffer, then hand over the last one
+        if (used_ > 0)
+        {
+            {
+                std::unique_lock lock(mutex_);
+                written_condition_.wait(lock, [this] { return !writer_busy_.load(std::memory_order_acquire); });
+            }
+            SubmitBuffer();
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        wake_condition_.notify_one();
+
+        if (thread_.joinable())
+            thread_.join();
+
+        if (file_ != nullptr)
+            std::fclose(file_);
+        file_ = nullptr;
+        open_ = false;
+
+        if (dropped_records_ > 0)
+            WARNING(std::to_string(dropped_records_) +
+                " trace records were dropped because the trace buffers were full.");
+    }
+
+    void TraceWriter::WriteFrame(const std::chrono::steady_clock::time_point time, const bool has_scan_time,
+                                 const uint64_t scan_ticks, const TouchFrame& contacts)
+    {
+        uint8_t* destination = Reserve(TraceFrameSize(contacts));
+        if (destination != nullptr)
+            EncodeTraceFrame(destination, TraceTime(start_, time), has_scan_time, scan_ticks, contacts);
+    }
+
+    void TraceWriter::WriteStep(const std::chrono::steady_clock::time_point time, const TraceEventType event,
+                                const int surface_count, const GestureState& state, const bool left_button_down,
+                                const GestureOutput& output)
+    {
+        uint8_t* destination = Reserve(sizeof(TraceStepRecord));
+        if (destination != nullptr)
+            EncodeTraceStep(destination, TraceTime(start_, time), event, surface_count, state, left_button_down,
+                            output);
+    }
+
+    void TraceWriter::WriteCancel(const std::chrono::steady_clock::time_point time, const CancelReason reason)
+    {
+        uint8_t* destination = Reserve(sizeof(TraceCancelRecord));
+        if (destination != nullptr)
+            EncodeTraceCancel(destination, TraceTime(start_, time), reason);
+    }
+
+    uint8_t* TraceWriter::Reserve(const size_t size)
+    {
+        if (!open_)
+            return nullptr;
+
+        // Hand over a partly filled buffer once the writer thread asks for it, so that the file stays current
+        if (submit_requested_.load(std::memory_order_relaxed) && used_ > 0)
+            SubmitBuffer();
+
+        if (used_ + size > TRACE_BUFFER_SIZE && !SubmitBuffer())
+        {
+            dropped_records_++;
+            return nullptr;
+        }
+
+        uint8_t* destination = buffers_[active_buffer_].get() + used_;
+        used_ += size;
+        records_++;
+        return destination;
+    }
+
+    bool TraceWriter::SubmitBuffer()
+    {
+        // The other buffer is still being written
+        if (writer_busy_.load(std::memory_order_acquire))
+            return false;
+
+        submit_requested_.store(false, std::memory_order_relaxed);
+        writer_busy_.store(true, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(mutex_);
+            pending_ = buffers_[active_buffer_].get();
+            pending_size_ = used_;
+        }
+        wake_condition_.notify_one();
+
+        active_buffer_ ^= 1;
+        used_ = 0;
+        return true;
+    }
+
+    void TraceWriter::Run()
+    {
+        std::unique_lock lock(mutex_);
+        for (;;)
+        {
+            const bool woken = wake_condition_.wait_for(lock, std::chrono::milliseconds(TRACE_FLUSH_INTERVAL_MS),
+                                                        [this] { return stopping_ || pending_size_ > 0; });
+
+            if (pending_size_ > 0)
+            {
+                const uint8_t* data = pending_;
+                const size_t size = pending_size_;
+                lock.unlock();
+                WriteToFile(data, size);
+                lock.lock();
+
+                pending_size_ = 0;
+                writer_busy_.store(false, std::memory_order_release);
+                written_condition_.notify_all();
+            }
+            else if (stopping_)
+            {
+                break;
+            }
+            else if (!woken)
+            {
+                submit_requested_.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void TraceWriter::WriteToFile(const uint8_t* data, const size_t size)
+    {
+        if (file_ == nullptr)
+            return;
+
+        // Buffers only hold whole records, so both generations start and end at a record
+        if (file_size_ + static_cast<long>(size) > TRACE_FILE_MAX_SIZE && !Rotate())
+        {
+            ERROR("Could not rotate the trace file, tracing stopped.");
+            return;
+        }
+
+        if (std::fwrite(data, 1, size, file_) != size || std::fflush(file_) != 0)
+        {
+            ERROR("Could not write to the trace file, tracing stopped.");
+            std::fclose(file_);
+            file_ = nullptr;
+            return;
+        }
+        file_size_ += static_cast<long>(size);
+    }
+
+    bool TraceWriter::Rotate()
+    {
+        if (file_ != nullptr)
+            std::fclose(file_);
+        file_ = nullptr;
+
+        // Renaming fails if the file is held open elsewhere. The file is truncated below in that case, so it can
+        // never grow past its limit.
+        std::error_code error;
+        std::filesystem::remove(previous_path_, error);
+        std::filesystem::rename(path_, previous_path_, error);
+        return StartFile();
+    }
+
+    bool TraceWriter::StartFile()
+    {
+        file_ = std::fopen(path_.c_str(), "wb");
+        if (file_ == nullptr)
+            return false;
+
+        if (!WriteFileHeader())
+        {
+            std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    bool TraceWriter::WriteFileHeader()
+    {
+        TraceFileHeader header;
+        std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+        header.version = TRACE_VERSION;
+        header.time_unit_us = TRACE_TIME_UNIT_US;
+
+        file_size_ = sizeof(header);
+        return std::fwrite(&header, sizeof(header), 1, file_) == 1 && std::fflush(file_) == 0;
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "trace_encoder.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Touchpad
+{
+    constexpr size_t TRACE_BUFFER_SIZE = 64 * 1024;
+    constexpr auto TRACE_FLUSH_INTERVAL_MS = 1000;
+    constexpr long TRACE_FILE_MAX_SIZE = 5 * 1024 * 1024; // 5MB
+
+    /**
+     * \brief Writes the per-frame debug data of the touch processor as fixed-layout binary records, which are
+     * rendered as text or CSV offline by the trace decoder.
+     *
+     * Records are copied into one of two preallocated buffers. Once it is full, or at least every
+     * TRACE_FLUSH_INTERVAL_MS, the buffer is handed to a background thread that writes it to the file while the
+     * other buffer fills up, so tracing costs the input thread a copy per record and never blocks it. Records
+     * that arrive while both buffers are in use are dropped and counted. Once the file would exceed
+     * TRACE_FILE_MAX_SIZE it is rotated, as the log file is: it is renamed to a ".1" generation next to it, e.g.
+     * trace.1.tfdtrace, replacing the previous one, and a new file is started. An existing trace is rotated the
+     * same way when the file is opened.
+     *
+     * All Write functions and Close must be called from the same thread.
+     */
+    class TraceWriter
+    {
+    public:
+        TraceWriter() = default;
+        ~TraceWriter();
+
+        TraceWriter(const TraceWriter& other) = delete;
+        TraceWriter& operator=(const TraceWriter& other) = delete;
+
+        /**
+         * \brief Creates the trace file and starts the writer thread. A non-empty existing file is rotated to the
+         * ".1" generation first. Record times are measured from this call.
+         * \param path Path of the file.
+         * \return False if the file could not be created.
+         */
+        bool Open(const std::string& path);
+
+        /**
+         * \brief Writes the remaining records, stops the writer thread and closes the file.
+         */
+        void Close();
+
+        bool IsOpen() const { return open_; }
+
+        /**
+         * \brief Appends a frame received from the touchpad.
+         * \param time Time the frame was sampled.
+         * \param has_scan_time True if the device reported a scan time for the frame.
+         * \param scan_ticks The unwrapped scan time in 100 microsecond units.
+         * \param contacts The contacts of the frame.
+         */
+        void WriteFrame(std::chrono::steady_clock::time_point time, bool has_scan_time, uint64_t scan_ticks,
+                        const TouchFrame& contacts);
+
+        /**
+         * \brief Appends a step of the gesture engine.
+         * \param time Time of the event.
+         * \param event The event raised by the step.
+         * \param surface_count Number of tracked contacts on the surface.
+         * \param state The gesture state after the step.
+         * \param left_button_down True if the left mouse button is held after the step.
+         * \param output The mouse commands sent by the step.
+         */
+        void WriteStep(std::chrono::steady_clock::time_point time, TraceEventType event, int surface_count,
+                       const GestureState& state, bool left_button_down, const GestureOutput& output);
+
+        /**
+         * \brief Appends a gesture cancelled by one of its timeouts.
+         */
+        void WriteCancel(std::chrono::steady_clock::time_point time, CancelReason reason);
+
+        /**
+         * \brief Returns the number of records written to the buffers.
+         */
+        uint64_t Records() const { return records_; }
+
+        /**
+         * \brief Returns the number of records dropped because both buffers were in use.
+         */
+        uint64_t DroppedRecords() const { return dropped_records_; }
+
+    private:
+        uint8_t* Reserve(size_t size);
+        bool SubmitBuffer();
+        void Run();
+        void WriteToFile(const uint8_t* data, size_t size);
+        bool Rotate();
+        bool StartFile();
+        bool WriteFileHeader();
+
+        bool open_ = false;
+        std::string path_;
+        std::string previous_path_; ///< The generation the file is rotated to.
+        std::chrono::steady_clock::time_point start_;
+
+        // Only used by the tracing thread
+        std::unique_ptr<uint8_t[]> buffers_[2];
+        int active_buffer_ = 0;
+        size_t used_ = 0;
+        uint64_t records_ = 0;
+        uint64_t dropped_records_ = 0;
+
+        // Hand over of full buffers to the writer thread
+        std::atomic<bool> writer_busy_{false}; ///< Set while the inactive buffer is being written.
+        std::atomic<bool> submit_requested_{false}; ///< Set by the writer thread when the interval has passed.
+        std::mutex mutex_;
+        std::condition_variable wake_condition_;
+        std::condition_variable written_condition_;
+        const uint8_t* pending_ = nullptr;
+        size_t pending_size_ = 0;
+        bool stopping_ = false;
+        std::thread thread_;
+
+        // Only used by the writer thread while it runs
+        std::FILE* file_ = nullptr;
+        long file_size_ = 0;
+    };
+}
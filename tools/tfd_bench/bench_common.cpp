@@ -0,0 +1,152 @@
+#include "bench_common.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> allocated_bytes{0};
+
+    void* CountedAllocate(const std::size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (void* memory = std::malloc(size == 0 ? 1 : size))
+            return memory;
+        throw std::bad_alloc();
+    }
+}
+
+// Every allocation of the process goes through these, so the benchmarks can tell how many the pipeline makes
+void* operator new(const std::size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void* operator new[](const std::size_t size)
+{
+    return CountedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace Bench
+{
+    bool ParseOptions(const int argc, char** argv, const int first, Options& options)
+    {
+        for (int i = first; i < argc; i++)
+        {
+            const char* argument = argv[i];
+            if (std::strncmp(argument, "--", 2) != 0)
+            {
+                options.files.emplace_back(argument);
+                continue;
+            }
+
+            char* end = nullptr;
+            const double value = i + 1 < argc ? std::strtod(argv[i + 1], &end) : 0.0;
+            if (end == nullptr || *end != '\0' || !(value > 0.0))
+            {
+                std::fprintf(stderr, "Option %s needs a positive number.\n", argument);
+                return false;
+            }
+            i++;
+
+            if (std::strcmp(argument, "--seconds") == 0)
+                options.seconds = value;
+            else if (std::strcmp(argument, "--rate") == 0)
+                options.rate = static_cast<int>(value);
+            else if (std::strcmp(argument, "--threads") == 0)
+                options.threads = static_cast<int>(value);
+            else if (std::strcmp(argument, "--max-file-size") == 0)
+                options.max_file_size = static_cast<long>(value);
+            else if (std::strcmp(argument, "--devices") == 0)
+                options.devices = static_cast<int>(value);
+            else
+            {
+                std::fprintf(stderr, "Unknown option %s.\n", argument);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t Allocations()
+    {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    uint64_t AllocatedBytes()
+    {
+        return allocated_bytes.load(std::memory_order_relaxed);
+    }
+
+    long PeakResidentKilobytes()
+    {
+#ifdef __linux__
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            return usage.ru_maxrss;
+#endif
+        return 0;
+    }
+
+    double SecondsSince(const Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void PrintLatency(const Metrics::PipelineLatency& latency)
+    {
+        PrintLatency(std::vector<const Metrics::PipelineLatency*>{&latency});
+    }
+
+    void PrintLatency(const std::vector<const Metrics::PipelineLatency*>& latencies)
+    {
+        for (size_t i = 0; i < Metrics::LATENCY_STAGE_COUNT; i++)
+        {
+            const auto stage = static_cast<Metrics::LatencyStage>(i);
+            Metrics::HistogramSnapshot snapshot;
+            for (const Metrics::PipelineLatency* latency : latencies)
+                snapshot.Merge(latency->Snapshot(stage));
+
+            const Metrics::StageLatency percentiles = {
+                snapshot.total,
+                Metrics::TickClock::ToNanoseconds(snapshot.Percentile(50)),
+                Metrics::TickClock::ToNanoseconds(snapshot.Percentile(99)),
+                Metrics::TickClock::ToNanoseconds(snapshot.Percentile(99.9)),
+                Metrics::TickClock::ToNanoseconds(snapshot.max)
+            };
+            std::printf("  %-10s n=%-9llu p50=%7.0fns p99=%7.0fns p99.9=%7.0fns max=%7.0fns\n",
+                        Metrics::PipelineLatency::StageName(stage),
+                        static_cast<unsigned long long>(percentiles.count), percentiles.p50, percentiles.p99,
+                        percentiles.p999, percentiles.max);
+        }
+    }
+}
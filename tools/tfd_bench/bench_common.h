@@ -0,0 +1,59 @@
+#pragma once
+#include "../../ThreeFingerDrag/metrics/pipeline_latency.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * \brief Options shared by the benchmarks, given as "--name value" pairs. Every other argument is an input file.
+     */
+    struct Options
+    {
+        double seconds = 1.0; ///< Minimum measured time of each benchmark.
+        int rate = 10000; ///< Lines per second written by the log benchmark.
+        int threads = 2; ///< Producer threads of the log benchmark.
+        long max_file_size = 256 * 1024; ///< Size the log benchmark rotates at.
+        int devices = 0; ///< Overrides the number of devices of trajectory scripts when positive.
+        std::vector<std::string> files;
+    };
+
+    /**
+     * \brief Parses the options following the benchmark name.
+     * \return False, after printing the reason, if an option is unknown or its value is not a positive number.
+     */
+    bool ParseOptions(int argc, char** argv, int first, Options& options);
+
+    /**
+     * \brief Number of heap allocations made by the process so far. Counted by the replaced global operator new,
+     * so allocations that bypass it, such as those of the C library, are not seen.
+     */
+    uint64_t Allocations();
+
+    /**
+     * \brief Number of bytes requested by the allocations counted by Allocations.
+     */
+    uint64_t AllocatedBytes();
+
+    /**
+     * \brief Returns the peak resident set size of the process in kilobytes, or 0 if the platform does not report it.
+     */
+    long PeakResidentKilobytes();
+
+    double SecondsSince(Clock::time_point start);
+
+    /**
+     * \brief Prints a line per pipeline stage with its count and percentiles. Unlike PipelineLatency::Summary, the
+     * percentiles are printed in nanoseconds, as most stages take well under a microsecond.
+     */
+    void PrintLatency(const Metrics::PipelineLatency& latency);
+
+    /**
+     * \brief Prints the latency of several pipelines, e.g. one per device, as if it had been measured by one.
+     */
+    void PrintLatency(const std::vector<const Metrics::PipelineLatency*>& latencies);
+}
@@ -0,0 +1,259 @@
+#include "benchmarks.h"
+#include "../../ThreeFingerDrag/config/globalconfig.h"
+#include "../../ThreeFingerDrag/gesture/contact_tracker.h"
+#include "../../ThreeFingerDrag/gesture/timeout_scheduler.h"
+#include "../../ThreeFingerDrag/logging/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace Touchpad;
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr auto TRACKER_FRAMES_PER_CHECK = 4096;
+        constexpr auto DRAG_REPORT_INTERVAL_MS = 8;
+
+        TouchFrame MakeFrame(const int fingers, const int step)
+        {
+            TouchFrame frame;
+            for (int i = 0; i < fingers; i++)
+            {
+                TouchContact contact{};
+                contact.contact_id = i;
+                contact.x = 1000 + i * 200 + step % 1000;
+                contact.y = 1000 + step % 500;
+                contact.on_surface = true;
+                frame.Add(contact);
+            }
+            return frame;
+        }
+
+        /**
+         * \brief The contact merge that ContactTracker replaced, kept as it was to compare against. Every frame
+         * rebuilds the tracked contacts through an unordered_map and sorts them by ID, every event copies them into
+         * a new vector, and lifted contacts are erased from the vector.
+         */
+        class MapSortMerge
+        {
+        public:
+            void Merge(const TouchFrame& received_contacts)
+            {
+                std::unordered_map<int, TouchContact> id_to_contact_map;
+
+                for (const auto& contact : contacts_)
+                {
+                    id_to_contact_map[contact.contact_id] = contact;
+                }
+
+                // Validate each received contact and filter out unwanted data
+                for (const auto& received_contact : received_contacts)
+                {
+                    if (received_contact.contact_id > CONTACT_ID_MAXIMUM || received_contact.contact_id < 0)
+                        continue;
+
+                    if (received_contact.x == 0 || received_contact.y == 0)
+                        continue;
+
+                    if (received_contact.has_x_bounds &&
+                        !ValueWithinRange(received_contact.x, received_contact.minimum_x, received_contact.maximum_x))
+                        continue;
+
+                    if (received_contact.has_y_bounds &&
+                        !ValueWithinRange(received_contact.y, received_contact.minimum_y, received_contact.maximum_y))
+                        continue;
+
+                    id_to_contact_map[received_contact.contact_id] = received_contact;
+                }
+
+                contacts_.clear();
+                for (const auto& pair : id_to_contact_map)
+                {
+                    contacts_.push_back(pair.second);
+                }
+
+                std::sort(contacts_.begin(), contacts_.end(), [](const TouchContact& a, const TouchContact& b)
+                {
+                    return a.contact_id < b.contact_id;
+                });
+            }
+
+            std::vector<TouchContact> Snapshot() const { return contacts_; }
+
+            void RemoveLifted()
+            {
+                const auto it = std::remove_if(contacts_.begin(), contacts_.end(),
+                                               [](const TouchContact& tc) { return !tc.on_surface; });
+                contacts_.erase(it, contacts_.end());
+            }
+
+        private:
+            static bool ValueWithinRange(const int value, const int minimum, const int maximum)
+            {
+                return value < maximum && value > minimum;
+            }
+
+            std::vector<TouchContact> contacts_;
+        };
+
+        struct MergeResult
+        {
+            double nanoseconds_per_frame = 0.0;
+            double allocations_per_frame = 0.0;
+        };
+
+        /**
+         * \brief Runs a merge, snapshot and lift-off removal per frame over the frames for at least the given time.
+         */
+        template <typename Step>
+        MergeResult MeasureMerge(const std::vector<TouchFrame>& frames, const double seconds, Step&& step)
+        {
+            uint64_t merged = 0;
+            const uint64_t allocations = Allocations();
+            const auto start = Clock::now();
+            do
+            {
+                for (const TouchFrame& frame : frames)
+                    step(frame);
+                merged += frames.size();
+            }
+            while (SecondsSince(start) < seconds);
+
+            MergeResult result;
+            result.nanoseconds_per_frame = SecondsSince(start) * 1e9 / merged;
+            result.allocations_per_frame = static_cast<double>(Allocations() - allocations) / merged;
+            return result;
+        }
+
+        double WakeupsPerSecond(TimeoutScheduler& scheduler, const double seconds, const bool dragging)
+        {
+            const uint64_t wakeups = scheduler.Wakeups();
+            const auto start = Clock::now();
+            while (SecondsSince(start) < seconds)
+            {
+                // A drag rearms the automatic timeout with every report, as the touch processor does
+                if (dragging)
+                {
+                    scheduler.Arm(TimeoutKind::Automatic,
+                                  Clock::now() + std::chrono::milliseconds(DEFAULT_AUTOMATIC_TIMEOUT_DELAY_MS));
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(DRAG_REPORT_INTERVAL_MS));
+            }
+            return (scheduler.Wakeups() - wakeups) / SecondsSince(start);
+        }
+    }
+
+    int RunTracker(const Options& options)
+    {
+        std::printf("contact tracker merge: slot array against the unordered_map and sort it replaced\n");
+        for (int fingers = 1; fingers <= TOUCH_FRAME_CAPACITY; fingers++)
+        {
+            std::vector<TouchFrame> frames;
+            for (int step = 0; step < TRACKER_FRAMES_PER_CHECK; step++)
+                frames.push_back(MakeFrame(fingers, step));
+
+            ContactTracker tracker;
+            TouchFrame snapshot;
+            const MergeResult slots = MeasureMerge(frames, options.seconds, [&](const TouchFrame& frame)
+            {
+                tracker.Merge(frame);
+                tracker.Snapshot(snapshot);
+                tracker.RemoveLifted();
+            });
+
+            MapSortMerge map_sort;
+            size_t map_sort_contacts = 0;
+            const MergeResult legacy = MeasureMerge(frames, options.seconds, [&](const TouchFrame& frame)
+            {
+                map_sort.Merge(frame);
+                map_sort_contacts = map_sort.Snapshot().size();
+                map_sort.RemoveLifted();
+            });
+
+            std::printf("  %2d fingers  slots %6.1f ns, %.2f allocations | map+sort %7.1f ns, %.2f allocations"
+                        " per frame | %.1fx (%d/%zu on surface)\n", fingers, slots.nanoseconds_per_frame,
+                        slots.allocations_per_frame, legacy.nanoseconds_per_frame, legacy.allocations_per_frame,
+                        legacy.nanoseconds_per_frame / slots.nanoseconds_per_frame, tracker.CountOnSurface(),
+                        map_sort_contacts);
+        }
+        return 0;
+    }
+
+    int RunLog(const Options& options)
+    {
+        Logger& logger = Logger::GetInstance();
+        LogRotationPolicy policy;
+        policy.max_file_size = options.max_file_size;
+        logger.SetRotationPolicy(policy);
+
+        const uint64_t rotations = logger.Rotations();
+        const uint64_t dropped = logger.DroppedRecords();
+        const auto interval = std::chrono::duration<double>(options.threads / static_cast<double>(options.rate));
+        const auto start = Clock::now();
+
+        std::vector<std::thread> producers;
+        std::vector<double> call_seconds(options.threads);
+        std::vector<uint64_t> lines(options.threads);
+        for (int t = 0; t < options.threads; t++)
+        {
+            producers.emplace_back([&, t]
+            {
+                auto next = start;
+                while (SecondsSince(start) < options.seconds)
+                {
+                    const auto call_start = Clock::now();
+                    INFO("Benchmark line " + std::to_string(lines[t]) + " from producer " + std::to_string(t) +
+                        ", padded to the length of a typical debug message.");
+                    call_seconds[t] += SecondsSince(call_start);
+                    lines[t]++;
+
+                    next += std::chrono::duration_cast<Clock::duration>(interval);
+                    std::this_thread::sleep_until(next);
+                }
+            });
+        }
+        for (std::thread& producer : producers)
+            producer.join();
+
+        const double elapsed = SecondsSince(start);
+        logger.Flush();
+        const double flushed = SecondsSince(start);
+
+        uint64_t total_lines = 0;
+        double total_call_seconds = 0.0;
+        for (int t = 0; t < options.threads; t++)
+        {
+            total_lines += lines[t];
+            total_call_seconds += call_seconds[t];
+        }
+
+        std::printf("log: %llu lines from %d threads in %.2f s (%.0f lines/s), flushed after %.2f s\n",
+                    static_cast<unsigned long long>(total_lines), options.threads, elapsed, total_lines / elapsed,
+                    flushed);
+        std::printf("  %.0f ns per call, %llu rotations at %ld bytes, %llu dropped\n",
+                    total_call_seconds * 1e9 / total_lines,
+                    static_cast<unsigned long long>(logger.Rotations() - rotations), options.max_file_size,
+                    static_cast<unsigned long long>(logger.DroppedRecords() - dropped));
+        return 0;
+    }
+
+    int RunTimeouts(const Options& options)
+    {
+        TimeoutScheduler scheduler([](TimeoutKind, TimeoutScheduler::time_point)
+        {
+        });
+        scheduler.Start();
+
+        const double idle = WakeupsPerSecond(scheduler, options.seconds, false);
+        const double dragging = WakeupsPerSecond(scheduler, options.seconds, true);
+        scheduler.Stop();
+
+        std::printf("timeout scheduler: %.1f wakeups/s idle, %.1f wakeups/s during a drag reported every %d ms\n",
+                    idle, dragging, DRAG_REPORT_INTERVAL_MS);
+        return 0;
+    }
+}
@@ -0,0 +1,72 @@
+#include "benchmarks.h"
+#include "../../ThreeFingerDrag/config/config_watcher.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Bench
+{
+    namespace
+    {
+        void AppendLine(const std::filesystem::path& path, const char* line)
+        {
+            std::ofstream file(path, std::ios::app);
+            file << line << '\n';
+        }
+    }
+
+    int RunConfigWatch(const Options&)
+    {
+        std::error_code error;
+        const auto directory = std::filesystem::temp_directory_path(error) / "tfd-config-watch";
+        std::filesystem::remove_all(directory, error);
+        if (!std::filesystem::create_directories(directory, error))
+        {
+            std::fprintf(stderr, "Could not create '%s'.\n", directory.string().c_str());
+            return 1;
+        }
+
+        const auto config_path = directory / "config.ini";
+        const auto log_path = directory / "log.txt";
+        std::mutex mutex;
+        std::vector<Clock::time_point> reports;
+
+        ConfigWatcher watcher;
+        if (!watcher.Start(config_path.string(), [&]
+        {
+            std::lock_guard lock(mutex);
+            reports.push_back(Clock::now());
+        }))
+        {
+            std::fprintf(stderr, "Could not watch '%s'.\n", config_path.string().c_str());
+            return 1;
+        }
+
+        // The configuration is written twice while other files of its folder keep changing, as the log does. It
+        // may only be reported once, after it has been left alone for the debounce delay.
+        const auto start = Clock::now();
+        AppendLine(config_path, "[Configuration]");
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(20));
+        AppendLine(log_path, "a log line");
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(150));
+        const auto last_write = Clock::now();
+        AppendLine(config_path, "gesture_speed = 30");
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(300));
+        AppendLine(log_path, "another log line");
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(300 + CONFIG_WATCH_DEBOUNCE_MS * 4));
+        watcher.Stop();
+        std::filesystem::remove_all(directory, error);
+
+        const auto debounce = std::chrono::milliseconds(CONFIG_WATCH_DEBOUNCE_MS);
+        const bool passed = reports.size() == 1 && reports[0] - last_write >= debounce;
+        const double reported_ms = reports.empty()
+                                       ? 0.0
+                                       : std::chrono::duration<double, std::milli>(reports[0] - last_write).count();
+        std::printf("config watch: %s, %zu reports, the first %.0f ms after the last write of the file (debounce %d "
+                    "ms)\n", passed ? "passed" : "FAILED", reports.size(), reported_ms, CONFIG_WATCH_DEBOUNCE_MS);
+        return passed ? 0 : 1;
+    }
+}
@@ -0,0 +1,300 @@
+#include "benchmarks.h"
+#include "../../ThreeFingerDrag/capture/capture_writer.h"
+#include "../../ThreeFingerDrag/capture/replay_driver.h"
+#include "../../ThreeFingerDrag/mouse/recording_sink.h"
+#include "../../ThreeFingerDrag/synthetic/trajectory_generator.h"
+#include "../../ThreeFingerDrag/trace/trace_reader.h"
+#include "../../ThreeFingerDrag/trace/trace_writer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+using namespace Touchpad;
+
+namespace Bench
+{
+    namespace
+    {
+        /**
+         * \brief What the touch pipeline has to make of the reports of a fixture. Expectations the fixture does not
+         * state are not checked.
+         */
+        struct FixtureExpectations
+        {
+            long frames = -1; ///< Frames assembled from the reports.
+            bool check_steps = false;
+            std::vector<int> steps; ///< Contacts on the surface at each gesture step, 0 for touch up.
+            bool check_buttons = false;
+            std::vector<OutputCommandType> buttons; ///< Left button commands sent, in order.
+        };
+
+        /**
+         * \brief What the touch pipeline made of the reports of a fixture.
+         */
+        struct FixtureOutcome
+        {
+            long frames = 0;
+            std::vector<int> steps;
+            std::vector<OutputCommandType> buttons;
+        };
+
+        bool ParseCount(const std::string& token, long& value)
+        {
+            char* end = nullptr;
+            value = std::strtol(token.c_str(), &end, 10);
+            return !token.empty() && end == token.c_str() + token.size() && value >= 0;
+        }
+
+        /**
+         * \brief Parses an expect statement. Returns a message describing the problem, or nullptr.
+         */
+        const char* ParseExpectation(const std::vector<std::string>& tokens, FixtureExpectations& expected)
+        {
+            const std::string what = tokens.size() > 1 ? tokens[1] : std::string();
+            if (what == "frames")
+            {
+                if (tokens.size() != 3 || !ParseCount(tokens[2], expected.frames))
+                    return "expected expect frames N";
+                return nullptr;
+            }
+            if (what == "steps")
+            {
+                // Each token is a number of contacts on the surface, optionally repeated as CONTACTS*TIMES
+                expected.check_steps = true;
+                for (size_t i = 2; i < tokens.size(); i++)
+                {
+                    const size_t star = tokens[i].find('*');
+                    long contacts = 0;
+                    long times = 1;
+                    if (!ParseCount(tokens[i].substr(0, star), contacts) ||
+                        (star != std::string::npos && !ParseCount(tokens[i].substr(star + 1), times)))
+                        return "expected expect steps followed by CONTACTS or CONTACTS*TIMES";
+                    expected.steps.insert(expected.steps.end(), times, static_cast<int>(contacts));
+                }
+                return nullptr;
+            }
+            if (what == "buttons")
+            {
+                expected.check_buttons = true;
+                for (size_t i = 2; i < tokens.size(); i++)
+                {
+                    if (tokens[i] != "down" && tokens[i] != "up")
+                        return "expected expect buttons followed by down or up";
+                    expected.buttons.push_back(tokens[i] == "down"
+                                                   ? OutputCommandType::LeftButtonDown
+                                                   : OutputCommandType::LeftButtonUp);
+                }
+                return nullptr;
+            }
+            return "expected frames, steps or buttons after expect";
+        }
+
+        /**
+         * \brief Reads a fixture: a trajectory script whose expect statements state what the pipeline has to make
+         * of its reports.
+         */
+        bool LoadFixture(const std::string& path, TrajectoryScript& script, FixtureExpectations& expected)
+        {
+            std::ifstream file(path);
+            if (!file)
+            {
+                std::fprintf(stderr, "Could not read '%s'.\n", path.c_str());
+                return false;
+            }
+
+            std::string script_text;
+            std::string line;
+            int line_number = 0;
+            while (std::getline(file, line))
+            {
+                line_number++;
+                std::istringstream words(line.substr(0, line.find('#')));
+                const std::vector<std::string> tokens{
+                    std::istream_iterator<std::string>(words), std::istream_iterator<std::string>()
+                };
+                if (!tokens.empty() && tokens[0] == "expect")
+                {
+                    if (const char* problem = ParseExpectation(tokens, expected))
+                    {
+                        std::fprintf(stderr, "%s: Line %d: %s.\n", path.c_str(), line_number, problem);
+                        return false;
+                    }
+
+                    // Left as an empty line, so that the script reports errors at the same line numbers
+                    line.clear();
+                }
+                script_text += line;
+                script_text += '\n';
+            }
+
+            std::string error;
+            if (!TrajectoryScript::Parse(script_text, script, error))
+            {
+                std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * \brief Replays the reports of a fixture through the touch pipeline, tracing every frame and gesture step.
+         */
+        bool ReplayFixture(const std::string& path, const TrajectoryScript& script, const std::string& capture_path,
+                           const std::string& trace_path, FixtureOutcome& outcome)
+        {
+            TrajectoryGenerator generator(script);
+            if (!generator.IsValid())
+            {
+                std::fprintf(stderr, "%s: the touchpad of the script could not be described.\n", path.c_str());
+                return false;
+            }
+
+            // Replayed from a capture, so that the reports take the same path as captured input
+            CaptureWriter capture_writer;
+            if (!capture_writer.Open(capture_path))
+            {
+                std::fprintf(stderr, "Could not write '%s'.\n", capture_path.c_str());
+                return false;
+            }
+            generator.WriteCapture(capture_writer);
+            capture_writer.Close();
+
+            CaptureReader capture_reader;
+            TraceWriter trace_writer;
+            if (!capture_reader.Open(capture_path) || !trace_writer.Open(trace_path))
+            {
+                std::fprintf(stderr, "%s: could not replay the reports.\n", path.c_str());
+                return false;
+            }
+
+            auto device_cache = std::make_unique<StaticDeviceCache>();
+            auto output_sink = std::make_unique<RecordingSink>();
+            StaticDeviceCache& cache = *device_cache;
+            const RecordingSink& sink = *output_sink;
+            TouchProcessor processor(std::move(device_cache), std::move(output_sink));
+            processor.SetTraceWriter(&trace_writer);
+            {
+                ReplayDriver driver(processor, cache);
+                driver.Run(capture_reader, ReplaySpeed::Maximum);
+            }
+            processor.SetTraceWriter(nullptr);
+            trace_writer.Close();
+
+            if (trace_writer.DroppedRecords() > 0)
+            {
+                std::fprintf(stderr, "%s: the trace dropped records.\n", path.c_str());
+                return false;
+            }
+
+            TraceReader trace_reader;
+            if (!trace_reader.Open(trace_path))
+            {
+                std::fprintf(stderr, "%s: could not read the trace.\n", path.c_str());
+                return false;
+            }
+
+            TraceRecord record;
+            while (trace_reader.Next(record))
+            {
+                if (record.header.type == TraceRecordType::Frame)
+                    outcome.frames++;
+                else if (record.header.type == TraceRecordType::Step)
+                    outcome.steps.push_back(record.header.count);
+            }
+
+            for (const OutputCommand& command : sink.Commands())
+            {
+                if (command.type != OutputCommandType::MoveCursor)
+                    outcome.buttons.push_back(command.type);
+            }
+            return true;
+        }
+
+        std::string FormatSteps(const std::vector<int>& steps)
+        {
+            std::string text;
+            for (size_t i = 0; i < steps.size();)
+            {
+                size_t run = 1;
+                while (i + run < steps.size() && steps[i + run] == steps[i])
+                    run++;
+
+                text += (text.empty() ? "" : " ") + std::to_string(steps[i]);
+                if (run > 1)
+                    text += "*" + std::to_string(run);
+                i += run;
+            }
+            return text;
+        }
+
+        std::string FormatButtons(const std::vector<OutputCommandType>& buttons)
+        {
+            std::string text;
+            for (const OutputCommandType button : buttons)
+                text += (text.empty() ? "" : " ") + std::string(button == OutputCommandType::LeftButtonDown
+                                                                     ? "down"
+                                                                     : "up");
+            return text;
+        }
+
+        bool RunFixture(const std::string& path, const std::string& capture_path, const std::string& trace_path)
+        {
+            TrajectoryScript script;
+            FixtureExpectations expected;
+            FixtureOutcome outcome;
+            if (!LoadFixture(path, script, expected) ||
+                !ReplayFixture(path, script, capture_path, trace_path, outcome))
+                return false;
+
+            bool passed = true;
+            if (expected.frames >= 0 && outcome.frames != expected.frames)
+            {
+                std::printf("%s: expected %ld frames, got %ld\n", path.c_str(), expected.frames, outcome.frames);
+                passed = false;
+            }
+            if (expected.check_steps && outcome.steps != expected.steps)
+            {
+                std::printf("%s: expected steps %s, got %s\n", path.c_str(), FormatSteps(expected.steps).c_str(),
+                            FormatSteps(outcome.steps).c_str());
+                passed = false;
+            }
+            if (expected.check_buttons && outcome.buttons != expected.buttons)
+            {
+                std::printf("%s: expected buttons %s, got %s\n", path.c_str(),
+                            FormatButtons(expected.buttons).c_str(), FormatButtons(outcome.buttons).c_str());
+                passed = false;
+            }
+
+            std::printf("%s: %s, %ld frames, steps %s, buttons %s\n", path.c_str(), passed ? "passed" : "FAILED",
+                        outcome.frames, FormatSteps(outcome.steps).c_str(), FormatButtons(outcome.buttons).c_str());
+            return passed;
+        }
+    }
+
+    int RunFixtures(const Options& options)
+    {
+        if (options.files.empty())
+        {
+            std::fprintf(stderr, "No fixtures given.\n");
+            return 1;
+        }
+
+        std::error_code error;
+        const auto directory = std::filesystem::temp_directory_path(error);
+        const std::string capture_path = (directory / "tfd-fixture.tfdcap").string();
+        const std::string trace_path = (directory / (std::string("tfd-fixture") + TRACE_FILE_EXTENSION)).string();
+        int exit_code = 0;
+        for (const std::string& path : options.files)
+        {
+            if (!RunFixture(path, capture_path, trace_path))
+                exit_code = 1;
+        }
+
+        std::filesystem::remove(capture_path, error);
+        std::filesystem::remove(trace_path, error);
+        return exit_code;
+    }
+}
@@ -0,0 +1,327 @@
+#include "benchmarks.h"
+#include "../../ThreeFingerDrag/capture/replay_driver.h"
+#include <cstdio>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+using namespace Touchpad;
+
+namespace Bench
+{
+    namespace
+    {
+        constexpr auto ALLOCATION_CHECK_RUNS = 3;
+
+        /**
+         * \brief Counts the commands it is sent without storing them, so that the sink adds no allocations.
+         */
+        class CountingSink : public OutputSink
+        {
+        public:
+            void Send(const OutputCommand* commands, const size_t count) override
+            {
+                commands_ += count;
+                for (size_t i = 0; i < count; i++)
+                {
+                    if (commands[i].type == OutputCommandType::LeftButtonDown)
+                        buttons_.SetLeftDown(true);
+                    else if (commands[i].type == OutputCommandType::LeftButtonUp)
+                        buttons_.SetLeftDown(false);
+                }
+            }
+
+            uint64_t Commands() const { return commands_; }
+
+        private:
+            uint64_t commands_ = 0;
+        };
+
+        /**
+         * \brief Replays every device of a capture through a touch processor of its own, as if each were the only
+         * touchpad. A single processor would merge the contacts of all devices into one gesture, which no number of
+         * touchpads drives in practice.
+         */
+        class CaptureReplay
+        {
+        public:
+            /**
+             * \brief Creates a processor for every device of a capture.
+             * \return False if the capture holds no devices.
+             */
+            bool Open(CaptureReader& reader)
+            {
+                std::vector<DeviceHandle> devices;
+                CaptureRecord record;
+                reader.Rewind();
+                while (reader.Next(record))
+                {
+                    if (std::find(devices.begin(), devices.end(), record.device) == devices.end())
+                        devices.push_back(record.device);
+                }
+
+                for (const DeviceHandle device : devices)
+                {
+                    auto replay = std::make_unique<DeviceReplay>();
+                    auto device_cache = std::make_unique<StaticDeviceCache>();
+                    auto output_sink = std::make_unique<CountingSink>();
+                    StaticDeviceCache& cache = *device_cache;
+                    replay->sink = output_sink.get();
+                    replay->processor = std::make_unique<TouchProcessor>(std::move(device_cache),
+                                                                         std::move(output_sink));
+                    replay->driver = std::make_unique<ReplayDriver>(*replay->processor, cache);
+                    replay->driver->ReplayOnly(device);
+                    replays_.push_back(std::move(replay));
+                }
+                return !replays_.empty();
+            }
+
+            /**
+             * \brief Replays the capture once per device.
+             * \return False if the capture ended in a malformed record.
+             */
+            bool Run(CaptureReader& reader)
+            {
+                bool complete = true;
+                stats_ = {};
+                for (const auto& replay : replays_)
+                {
+                    complete = replay->driver->Run(reader, ReplaySpeed::Maximum) && complete;
+                    const ReplayStats& stats = replay->driver->Stats();
+                    stats_.reports += stats.reports;
+                    stats_.batches += stats.batches;
+                    stats_.timeouts += stats.timeouts;
+                    stats_.captured_span = std::max(stats_.captured_span, stats.captured_span);
+                }
+                return complete;
+            }
+
+            void SetLatencyMeasurement(const bool enabled)
+            {
+                for (const auto& replay : replays_)
+                    replay->processor->SetLatencyMeasurement(enabled);
+            }
+
+            /**
+             * \brief Returns the counters of the last run, summed over the devices.
+             */
+            const ReplayStats& Stats() const { return stats_; }
+
+            size_t Devices() const { return replays_.size(); }
+
+            uint64_t Commands() const
+            {
+                uint64_t commands = 0;
+                for (const auto& replay : replays_)
+                    commands += replay->sink->Commands();
+                return commands;
+            }
+
+            /**
+             * \brief Returns the number of frames tracked so far with the latency stamps on, over all devices.
+             */
+            uint64_t MeasuredFrames() const
+            {
+                uint64_t frames = 0;
+                for (const auto& replay : replays_)
+                    frames += replay->processor->Latency().Percentiles(Metrics::LatencyStage::Track).count;
+                return frames;
+            }
+
+            std::vector<const Metrics::PipelineLatency*> Latencies() const
+            {
+                std::vector<const Metrics::PipelineLatency*> latencies;
+                for (const auto& replay : replays_)
+                    latencies.push_back(&replay->processor->Latency());
+                return latencies;
+            }
+
+        private:
+            struct DeviceReplay
+            {
+                CountingSink* sink = nullptr;
+                std::unique_ptr<TouchProcessor> processor;
+                std::unique_ptr<ReplayDriver> driver;
+            };
+
+            std::vector<std::unique_ptr<DeviceReplay>> replays_;
+            ReplayStats stats_;
+        };
+
+        struct ReplayTotals
+        {
+            uint64_t runs = 0;
+            uint64_t reports = 0;
+            uint64_t batches = 0;
+            double seconds = 0.0;
+        };
+
+        /**
+         * \brief Replays a capture repeatedly for at least the given time.
+         */
+        ReplayTotals ReplayFor(CaptureReplay& replay, CaptureReader& reader, const double seconds)
+        {
+            ReplayTotals totals;
+            const auto start = Clock::now();
+            do
+            {
+                replay.Run(reader);
+                totals.runs++;
+                totals.reports += replay.Stats().reports;
+                totals.batches += replay.Stats().batches;
+                totals.seconds = SecondsSince(start);
+            }
+            while (totals.seconds < seconds);
+            return totals;
+        }
+
+        /**
+         * \brief Replays a capture once to size every buffer, then replays it again and counts the allocations.
+         * \return False if the capture could not be read, holds no reports or allocated after the warm-up.
+         */
+        bool CheckCaptureAllocations(const std::string& path, const std::string& name)
+        {
+            CaptureReader reader;
+            if (!reader.Open(path))
+            {
+                std::fprintf(stderr, "'%s' is not a supported capture file.\n", name.c_str());
+                return false;
+            }
+
+            CaptureReplay replay;
+            if (replay.Open(reader))
+                replay.Run(reader);
+            if (replay.Stats().reports == 0)
+            {
+                std::fprintf(stderr, "'%s' holds no reports.\n", name.c_str());
+                return false;
+            }
+
+            // Measured as the application runs, with the latency stamps on
+            const uint64_t frames = replay.MeasuredFrames();
+            const uint64_t allocations = Allocations();
+            const uint64_t allocated_bytes = AllocatedBytes();
+            for (int run = 0; run < ALLOCATION_CHECK_RUNS; run++)
+                replay.Run(reader);
+            const uint64_t run_allocations = Allocations() - allocations;
+            const uint64_t run_allocated_bytes = AllocatedBytes() - allocated_bytes;
+            const uint64_t run_frames = replay.MeasuredFrames() - frames;
+
+            const bool passed = run_allocations == 0;
+            std::printf("%s: %s, %llu allocations (%llu bytes) in %llu frames after the warm-up\n", name.c_str(),
+                        passed ? "passed" : "FAILED", static_cast<unsigned long long>(run_allocations),
+                        static_cast<unsigned long long>(run_allocated_bytes),
+                        static_cast<unsigned long long>(run_frames));
+            return passed;
+        }
+    }
+
+    bool ReplayCapture(const std::string& path, const Options& options)
+    {
+        CaptureReader reader;
+        if (!reader.Open(path))
+        {
+            std::fprintf(stderr, "'%s' is not a supported capture file.\n", path.c_str());
+            return false;
+        }
+
+        CaptureReplay replay;
+        if (!replay.Open(reader))
+        {
+            std::fprintf(stderr, "'%s' holds no reports.\n", path.c_str());
+            return false;
+        }
+
+        // The first replay sizes every buffer, so that the measured replays show the steady state
+        replay.SetLatencyMeasurement(false);
+        if (!replay.Run(reader))
+            std::fprintf(stderr, "'%s' ends in a malformed record, replaying the records before it.\n",
+                         path.c_str());
+
+        const ReplayStats capture = replay.Stats();
+        const uint64_t commands_per_run = replay.Commands();
+        if (capture.reports == 0)
+        {
+            std::fprintf(stderr, "'%s' holds no reports.\n", path.c_str());
+            return false;
+        }
+
+        // Throughput is measured with the latency stamps off, as they cost more than some of the stages
+        const uint64_t allocations = Allocations();
+        const uint64_t allocated_bytes = AllocatedBytes();
+        const ReplayTotals throughput = ReplayFor(replay, reader, options.seconds);
+        const uint64_t run_allocations = Allocations() - allocations;
+        const uint64_t run_allocated_bytes = AllocatedBytes() - allocated_bytes;
+
+        replay.SetLatencyMeasurement(true);
+        const ReplayTotals measured = ReplayFor(replay, reader, options.seconds);
+        const double frames_per_run = static_cast<double>(replay.MeasuredFrames()) / measured.runs;
+
+        const double captured_seconds = std::chrono::duration<double>(capture.captured_span).count();
+        const double reports = static_cast<double>(throughput.reports);
+        std::printf("%s: %zu devices, %llu reports, %.0f frames, %llu batches, %llu commands, %llu timeouts, "
+                    "%.2f s captured\n", path.c_str(), replay.Devices(),
+                    static_cast<unsigned long long>(capture.reports), frames_per_run,
+                    static_cast<unsigned long long>(capture.batches), static_cast<unsigned long long>(commands_per_run),
+                    static_cast<unsigned long long>(capture.timeouts), captured_seconds);
+        const double runs_per_second = throughput.runs / throughput.seconds;
+        std::printf("  throughput   %.0f reports/s, %.0f frames/s, %.0f batches/s, %.0fx real time (%llu runs)\n",
+                    reports / throughput.seconds, frames_per_run * runs_per_second,
+                    throughput.batches / throughput.seconds, captured_seconds * runs_per_second,
+                    static_cast<unsigned long long>(throughput.runs));
+        std::printf("  allocations  %.3f per frame, %.1f bytes per frame\n",
+                    run_allocations / (frames_per_run * throughput.runs),
+                    run_allocated_bytes / (frames_per_run * throughput.runs));
+        std::printf("  latency\n");
+        PrintLatency(replay.Latencies());
+        return true;
+    }
+
+    int RunReplay(const Options& options)
+    {
+        if (options.files.empty())
+        {
+            std::fprintf(stderr, "No capture files given.\n");
+            return 1;
+        }
+
+        int exit_code = 0;
+        for (const std::string& path : options.files)
+        {
+            if (!ReplayCapture(path, options))
+                exit_code = 1;
+        }
+
+        std::printf("peak RSS       %ld KB\n", PeakResidentKilobytes());
+        return exit_code;
+    }
+
+    int RunAllocationCheck(const Options& options)
+    {
+        if (options.files.empty())
+        {
+            std::fprintf(stderr, "No capture files or trajectory scripts given.\n");
+            return 1;
+        }
+
+        std::error_code error;
+        const auto capture_path = std::filesystem::temp_directory_path(error) / "tfd-allocations.tfdcap";
+        int exit_code = 0;
+        for (const std::string& path : options.files)
+        {
+            // Scripts are replayed through a capture, so that they take the same path as captured input
+            const bool is_capture = std::filesystem::path(path).extension() == CAPTURE_FILE_EXTENSION;
+            if (!is_capture && GenerateCapture(path, capture_path.string(), options) == 0)
+            {
+                exit_code = 1;
+                continue;
+            }
+            if (!CheckCaptureAllocations(is_capture ? path : capture_path.string(), path))
+                exit_code = 1;
+        }
+
+        std::filesystem::remove(capture_path, error);
+        return exit_code;
+    }
+}
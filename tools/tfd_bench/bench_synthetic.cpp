@@ -0,0 +1,146 @@
+#include "benchmarks.h"
+#include "../../ThreeFingerDrag/capture/capture_writer.h"
+#include "../../ThreeFingerDrag/synthetic/trajectory_generator.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using namespace Touchpad;
+
+namespace Bench
+{
+    namespace
+    {
+        /**
+         * \brief Loads a trajectory script and applies the --devices option to it.
+         */
+        bool LoadScript(const std::string& path, const Options& options, TrajectoryScript& script)
+        {
+            std::string error;
+            if (!TrajectoryScript::Load(path, script, error))
+            {
+                std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+                return false;
+            }
+
+            if (options.devices > 0)
+                script.devices = std::min(options.devices, TRAJECTORY_MAX_DEVICES);
+            return true;
+        }
+
+        /**
+         * \brief Measures generating the reports of a script in memory, without writing them anywhere.
+         */
+        bool MeasureGeneration(const std::string& path, const Options& options)
+        {
+            TrajectoryScript script;
+            if (!LoadScript(path, options, script))
+                return false;
+
+            TrajectoryGenerator generator(script);
+            if (!generator.IsValid())
+            {
+                std::fprintf(stderr, "%s: the touchpad of the script could not be described.\n", path.c_str());
+                return false;
+            }
+
+            uint64_t runs = 0;
+            uint64_t reports = 0;
+            uint64_t frames = 0;
+            uint64_t bytes = 0;
+            double seconds = 0.0;
+            SyntheticReport report;
+            const auto start = Clock::now();
+            do
+            {
+                generator.Rewind();
+                while (generator.Next(report))
+                {
+                    reports++;
+                    bytes += report.size;
+                }
+                frames += generator.Frames();
+                runs++;
+                seconds = SecondsSince(start);
+            }
+            while (seconds < options.seconds);
+
+            if (reports == 0)
+            {
+                std::fprintf(stderr, "%s: the script produces no reports.\n", path.c_str());
+                return false;
+            }
+
+            std::printf("%s: %d devices at %.0f Hz, %d slots, %llu reports and %llu frames per run\n", path.c_str(),
+                        script.devices, script.rate_hz, script.touchpad.slots,
+                        static_cast<unsigned long long>(reports / runs),
+                        static_cast<unsigned long long>(frames / runs));
+            std::printf("  generation   %.0f reports/s, %.0f frames/s, %.1f MB/s (%llu runs)\n", reports / seconds,
+                        frames / seconds, bytes / seconds / 1e6, static_cast<unsigned long long>(runs));
+            return true;
+        }
+    }
+
+    uint64_t GenerateCapture(const std::string& script_path, const std::string& capture_path, const Options& options)
+    {
+        TrajectoryScript script;
+        if (!LoadScript(script_path, options, script))
+            return 0;
+
+        TrajectoryGenerator generator(script);
+        if (!generator.IsValid())
+        {
+            std::fprintf(stderr, "%s: the touchpad of the script could not be described.\n",
+                         script_path.c_str());
+            return 0;
+        }
+
+        CaptureWriter writer;
+        if (!writer.Open(capture_path))
+        {
+            std::fprintf(stderr, "Could not write '%s'.\n", capture_path.c_str());
+            return 0;
+        }
+        return generator.WriteCapture(writer);
+    }
+
+    int RunGenerate(const Options& options)
+    {
+        if (options.files.size() != 2)
+        {
+            std::fprintf(stderr, "Expected a script and a capture file.\n");
+            return 1;
+        }
+
+        const uint64_t reports = GenerateCapture(options.files[0], options.files[1], options);
+        if (reports == 0)
+            return 1;
+
+        std::printf("Wrote %llu reports to '%s'.\n", static_cast<unsigned long long>(reports),
+                    options.files[1].c_str());
+        return 0;
+    }
+
+    int RunSynthetic(const Options& options)
+    {
+        if (options.files.empty())
+        {
+            std::fprintf(stderr, "No trajectory scripts given.\n");
+            return 1;
+        }
+
+        std::error_code error;
+        const auto capture_path = std::filesystem::temp_directory_path(error) / "tfd-synthetic.tfdcap";
+        int exit_code = 0;
+        for (const std::string& path : options.files)
+        {
+            if (!MeasureGeneration(path, options) || GenerateCapture(path, capture_path.string(), options) == 0 ||
+                !ReplayCapture(capture_path.string(), options))
+                exit_code = 1;
+        }
+
+        std::filesystem::remove(capture_path, error);
+        std::printf("peak RSS       %ld KB\n", PeakResidentKilobytes());
+        return exit_code;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "bench_common.h"
+#include <string>
+
+namespace Bench
+{
+    /**
+     * \brief Replays captures through the touch pipeline on a simulated clock, reporting throughput, allocations
+     * and per-stage latency. Each device of a capture is replayed through a touch processor of its own.
+     * \return The exit code of the benchmark.
+     */
+    int RunReplay(const Options& options);
+
+    /**
+     * \brief Replays a single capture as RunReplay does, without the peak memory line.
+     * \return False if the capture could not be read or holds no reports.
+     */
+    bool ReplayCapture(const std::string& path, const Options& options);
+
+    /**
+     * \brief Replays captures, and the reports of trajectory scripts, after a warm-up replay, and fails if the
+     * replays allocate. Every other argument is treated as a capture if it has the capture file extension and as a
+     * script otherwise.
+     * \return 0 if no replay allocated after its warm-up.
+     */
+    int RunAllocationCheck(const Options& options);
+
+    /**
+     * \brief Replays fixtures, which are trajectory scripts with expect statements, and checks the frames, gesture
+     * steps and button commands that the touch pipeline makes of their reports. See tools/tfd_bench/fixtures.
+     * \return 0 if every fixture passed.
+     */
+    int RunFixtures(const Options& options);
+
+    /**
+     * \brief Writes a watched configuration file while other files of its folder change, and checks that the
+     * watcher reports it once, only after the file has been left alone for CONFIG_WATCH_DEBOUNCE_MS.
+     * \return 0 if the change was reported once and not too early.
+     */
+    int RunConfigWatch(const Options& options);
+
+    /**
+     * \brief Writes the reports of a trajectory script to a capture file.
+     * \return The number of reports written, or 0 if the script or file could not be used.
+     */
+    uint64_t GenerateCapture(const std::string& script_path, const std::string& capture_path, const Options& options);
+
+    /**
+     * \brief Writes the reports of a trajectory script to a capture file.
+     */
+    int RunGenerate(const Options& options);
+
+    /**
+     * \brief Measures how fast trajectory scripts are generated, then replays the reports they produce.
+     */
+    int RunSynthetic(const Options& options);
+
+    /**
+     * \brief Measures merging frames of 1 to TOUCH_FRAME_CAPACITY fingers into the contact tracker, and into the
+     * unordered_map and sort merge that it replaced.
+     */
+    int RunTracker(const Options& options);
+
+    /**
+     * \brief Logs at a fixed rate from several threads, with the log rotating, and reports dropped records.
+     */
+    int RunLog(const Options& options);
+
+    /**
+     * \brief Counts the wakeups of the timeout scheduler thread while idle and while a drag rearms its timeouts.
+     */
+    int RunTimeouts(const Options& options);
+}
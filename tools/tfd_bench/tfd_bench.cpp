@@ -0,0 +1,84 @@
+// Headless benchmarks of the touch pipeline, built on the portable core without any window or touchpad.
+//
+// Usage: tfd-bench <benchmark> [options] [files]
+//
+//   replay <capture>...   Replays captures on a simulated clock: throughput, allocations and per-stage latency.
+//   tracker               Merges frames of 1 to 10 fingers into the contact tracker and the map+sort merge it
+//                         replaced.
+//   log                   Logs from several threads at a fixed rate while the log file rotates.
+//   timeouts              Counts timeout scheduler wakeups while idle and during a drag.
+//   synthetic <script>... Generates the reports of trajectory scripts, then replays them as replay does.
+//   generate <script> <capture>
+//                         Writes the reports of a trajectory script to a capture file.
+//   allocations <file>... Replays captures and trajectory scripts after a warm-up replay, and exits with 1 if the
+//                         pipeline allocated. Registered as a CTest test.
+//   fixtures <fixture>... Replays fixtures and checks the frames, gesture steps and button commands they expect.
+//                         Exits with 1 if any fixture fails. Registered as a CTest test.
+//   config-watch          Checks that the configuration watcher waits for config.ini to be left alone, while other
+//                         files of its folder change. Exits with 1 if it does not. Registered as a CTest test on Linux.
+//   all <capture>...      Runs every benchmark.
+//
+// Options: --seconds S (minimum time of each measurement, default 1), --rate N and --threads N (log lines per
+// second and producer threads, default 10000 and 2), --max-file-size BYTES (log rotation size, default 256 KB),
+// --devices N (touchpads running each trajectory script, overriding its devices setting).
+// The log benchmark writes log.txt and its rotated generations to the working directory. Sample trajectory scripts
+// are in tools/tfd_bench/scripts; the language is described at TrajectoryScript::Parse. Fixtures, in
+// tools/tfd_bench/fixtures, are scripts with expect statements:
+//   expect frames N, expect steps CONTACTS[*TIMES]..., expect buttons down|up...
+
+#include "benchmarks.h"
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::fprintf(stderr, "Usage: tfd-bench <replay|tracker|log|timeouts|synthetic|generate|allocations|fixtures|"
+                     "config-watch|all> "
+                     "[--seconds S] [--rate N] [--threads N] [--max-file-size BYTES] [--devices N] "
+                     "[capture or script files]\n");
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Bench::Options options;
+    if (argc < 2 || !Bench::ParseOptions(argc, argv, 2, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const char* benchmark = argv[1];
+    if (std::strcmp(benchmark, "replay") == 0)
+        return Bench::RunReplay(options);
+    if (std::strcmp(benchmark, "tracker") == 0)
+        return Bench::RunTracker(options);
+    if (std::strcmp(benchmark, "log") == 0)
+        return Bench::RunLog(options);
+    if (std::strcmp(benchmark, "timeouts") == 0)
+        return Bench::RunTimeouts(options);
+    if (std::strcmp(benchmark, "synthetic") == 0)
+        return Bench::RunSynthetic(options);
+    if (std::strcmp(benchmark, "generate") == 0)
+        return Bench::RunGenerate(options);
+    if (std::strcmp(benchmark, "allocations") == 0)
+        return Bench::RunAllocationCheck(options);
+    if (std::strcmp(benchmark, "fixtures") == 0)
+        return Bench::RunFixtures(options);
+    if (std::strcmp(benchmark, "config-watch") == 0)
+        return Bench::RunConfigWatch(options);
+    if (std::strcmp(benchmark, "all") == 0)
+    {
+        int exit_code = Bench::RunTracker(options);
+        exit_code |= Bench::RunTimeouts(options);
+        exit_code |= Bench::RunLog(options);
+        if (!options.files.empty())
+            exit_code |= Bench::RunReplay(options);
+        return exit_code;
+    }
+
+    PrintUsage();
+    return 1;
+}
@@ -0,0 +1,177 @@
+// Renders a binary trace written by ThreeFingerDrag's debug trace mode as text or CSV.
+//
+// Usage: trace_decoder [--csv] <trace file>
+
+#include "../../ThreeFingerDrag/trace/trace_reader.h"
+#include "../../ThreeFingerDrag/gesture/gesture_engine.h"
+#include "../../ThreeFingerDrag/gesture/gesture_state.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace Touchpad;
+
+namespace
+{
+    const char* EventName(const uint8_t event)
+    {
+        return static_cast<TraceEventType>(event) == TraceEventType::TouchUp ? "TouchUpEvent" : "TouchActivityEvent";
+    }
+
+    const char* CancelReasonName(const uint8_t reason)
+    {
+        return static_cast<CancelReason>(reason) == CancelReason::CancellationTimeout
+                   ? "cancellation timeout"
+                   : "automatic timeout";
+    }
+
+    void WriteTransitionsText(const uint8_t transitions)
+    {
+        if (transitions & TRANSITION_GESTURE_STARTED)
+            std::printf("Started gesture.\n");
+        if (transitions & TRANSITION_CANCELLATION_STARTED)
+            std::printf("Started gesture cancellation.\n");
+        if (transitions & TRANSITION_GESTURE_CANCELLED)
+            std::printf("Cancelled gesture.\n");
+    }
+
+    void WriteText(const TraceRecord& record, const double interval_ms)
+    {
+        const double time_ms = record.TimeUs() / 1000.0;
+        switch (record.header.type)
+        {
+        case TraceRecordType::Frame:
+            std::printf("%.1fms [RAW REPORTED DATA]\n", time_ms);
+            std::printf("Interval: %.1fms\n", interval_ms);
+            if (record.header.flags & TRACE_FRAME_HAS_SCAN_TIME)
+                std::printf("Scan time: %u (x100us)\n", record.scan_time);
+            std::printf("Contacts: (size = %u)\n", record.header.count);
+            for (uint8_t i = 0; i < record.header.count; i++)
+            {
+                const TraceContact& contact = record.contacts[i];
+                std::printf("[ID: %u, X: %u, Y: %u, On Surface: %s]\n", contact.contact_id, contact.x, contact.y,
+                            contact.flags & TRACE_CONTACT_ON_SURFACE ? "Yes" : "No");
+            }
+            break;
+        case TraceRecordType::Step:
+            std::printf("%.1fms [GESTURE STEP]\n", time_ms);
+            std::printf("TYPE: %s\n", EventName(record.header.detail));
+            std::printf("Interval: %.1fms\n", interval_ms);
+            std::printf("Contacts on surface: %u\n", record.header.count);
+            std::printf("State: gesture %s, cancellation %s, left button %s\n",
+                        record.header.flags & TRACE_STEP_GESTURE_STARTED ? "started" : "idle",
+                        record.header.flags & TRACE_STEP_CANCELLATION_STARTED ? "started" : "idle",
+                        record.header.flags & TRACE_STEP_LEFT_BUTTON_DOWN ? "down" : "up");
+            std::printf("Commands: %u, Move: (%.2f, %.2f)\n", record.command_count, record.move_x, record.move_y);
+            WriteTransitionsText(record.transitions);
+            break;
+        case TraceRecordType::Cancel:
+            std::printf("%.1fms Cancelled gesture (%s).\n", time_ms, CancelReasonName(record.header.detail));
+            break;
+        }
+        std::printf("\n");
+    }
+
+    void WriteCsvHeader()
+    {
+        std::printf("time_ms,record,interval_ms,scan_time,event,surface_count,gesture_started,"
+            "cancellation_started,left_button_down,transitions,commands,move_x,move_y,"
+            "contact_id,x,y,on_surface\n");
+    }
+
+    void WriteCsv(const TraceRecord& record, const double interval_ms)
+    {
+        const double time_ms = record.TimeUs() / 1000.0;
+        switch (record.header.type)
+        {
+        case TraceRecordType::Frame:
+            {
+                const bool has_scan_time = record.header.flags & TRACE_FRAME_HAS_SCAN_TIME;
+                const std::string scan_time = has_scan_time ? std::to_string(record.scan_time) : "";
+
+                // One row per contact, so that the columns stay fixed
+                if (record.header.count == 0)
+                    std::printf("%.1f,frame,%.1f,%s,,,,,,,,,,,,,\n", time_ms, interval_ms, scan_time.c_str());
+                for (uint8_t i = 0; i < record.header.count; i++)
+                {
+                    const TraceContact& contact = record.contacts[i];
+                    std::printf("%.1f,frame,%.1f,%s,,,,,,,,,,%u,%u,%u,%d\n", time_ms, interval_ms, scan_time.c_str(),
+                                contact.contact_id, contact.x, contact.y,
+                                contact.flags & TRACE_CONTACT_ON_SURFACE ? 1 : 0);
+                }
+                break;
+            }
+        case TraceRecordType::Step:
+            std::printf("%.1f,step,%.1f,,%s,%u,%d,%d,%d,%u,%u,%.3f,%.3f,,,,\n", time_ms, interval_ms,
+                        EventName(record.header.detail), record.header.count,
+                        record.header.flags & TRACE_STEP_GESTURE_STARTED ? 1 : 0,
+                        record.header.flags & TRACE_STEP_CANCELLATION_STARTED ? 1 : 0,
+                        record.header.flags & TRACE_STEP_LEFT_BUTTON_DOWN ? 1 : 0,
+                        record.transitions, record.command_count, record.move_x, record.move_y);
+            break;
+        case TraceRecordType::Cancel:
+            std::printf("%.1f,cancel,,,%s,,,,,,,,,,,,\n", time_ms, CancelReasonName(record.header.detail));
+            break;
+        }
+    }
+}
+
+int main(const int argc, char* argv[])
+{
+    bool csv = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else
+            path = argv[i];
+    }
+
+    if (path == nullptr)
+    {
+        std::fprintf(stderr, "Usage: %s [--csv] <trace file>\n", argv[0]);
+        return 2;
+    }
+
+    TraceReader reader;
+    if (!reader.Open(path))
+    {
+        std::fprintf(stderr, "'%s' is not a supported trace file.\n", path);
+        return 1;
+    }
+
+    if (csv)
+        WriteCsvHeader();
+
+    // Intervals are measured from the previous record of the same type, like the debug log did
+    uint64_t last_frame_us = 0;
+    uint64_t last_step_us = 0;
+    TraceRecord record;
+    while (reader.Next(record))
+    {
+        double interval_ms = 0.0;
+        if (record.header.type == TraceRecordType::Frame)
+        {
+            interval_ms = (record.TimeUs() - last_frame_us) / 1000.0;
+            last_frame_us = record.TimeUs();
+        }
+        else if (record.header.type == TraceRecordType::Step)
+        {
+            interval_ms = (record.TimeUs() - last_step_us) / 1000.0;
+            last_step_us = record.TimeUs();
+        }
+
+        if (csv)
+            WriteCsv(record, interval_ms);
+        else
+            WriteText(record, interval_ms);
+    }
+
+    if (reader.Malformed())
+    {
+        std::fprintf(stderr, "The trace ends with a malformed record.\n");
+        return 1;
+    }
+    return 0;
+}